@@ -17,8 +17,25 @@
 #include <string>
 #include <cmath>
 #include <fstream>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <list>
+#include <iterator>
+#include <unordered_map>
+#include <cassert>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <wininet.h> 
 #include <urlmon.h>
+#include "hudcore.h"
+#include "hudsnapshot.h"
 
 #pragma comment(lib, "wininet.lib")
 #pragma comment(lib, "gdiplus.lib")
@@ -85,16 +102,6 @@ DWORD WINAPI OnlineService(LPVOID lpParam) {
     return 0;
 }
 
-namespace Config {
-    constexpr int HUD_SIZE = 350;
-    constexpr int ANIM_FRAMES = 30;
-    constexpr int HOLD_FRAMES = 120;
-    constexpr int FADEOUT_FRAMES = 20;
-    constexpr int TIMER_INTERVAL_MS = 16;
-    constexpr wchar_t WINDOW_CLASS[] = L"BatteryHUDClass";
-    constexpr wchar_t CONFIG_FILE[] = L"\\BatteryHUD\\config.dat";
-}
-
 #define WM_TRAYICON (WM_USER + 1)
 #define IDM_EXIT 1001
 #define IDM_TEST 1002
@@ -103,66 +110,43 @@ namespace Config {
 #define IDM_RESET 1005
 #define IDM_TOGGLE_UNPLUG 1006
 #define IDM_TOGGLE_SOUND 1007
+#define IDM_TOGGLE_EXPORT 1008
+#define IDM_TOGGLE_MINI_RING 1009
+#define IDM_TOGGLE_BACKDROP 1010
 #define TRAY_ICON_ID 1
 
-struct AppSettings {
-    Color chargeColor = Color(255, 0, 230, 120);
-    Color dischargeColor = Color(255, 255, 150, 50);
-    bool useCustomChargeColor = false;
-    bool useCustomDischargeColor = false;
-    bool showOnUnplug = false;
-    bool playSound = false;
-};
-
-struct HUDState {
-    bool isVisible = false;
-    int animFrame = 0;
-    int holdFrame = 0;
-    bool isFadingOut = false;
-    BYTE batteryPercent = 0;
-    Color themeColor = Color(255, 0, 230, 120);
-    bool isCharging = false;
-
-    void reset() {
-        isVisible = false;
-        animFrame = 0;
-        holdFrame = 0;
-        isFadingOut = false;
+namespace Utils {
+    float QueryDpiScale() {
+        HDC hdcScreen = GetDC(nullptr);
+        if (!hdcScreen) return 1.0f;
+        const int dpi = GetDeviceCaps(hdcScreen, LOGPIXELSX);
+        ReleaseDC(nullptr, hdcScreen);
+        return (dpi > 0) ? dpi / 96.0f : 1.0f;
     }
 
-    void startAnimation(BYTE percent, bool charging, const AppSettings& settings) {
-        batteryPercent = (percent > 100) ? 100 : percent;
-        isCharging = charging;
-
-        if (charging) {
-            themeColor = settings.useCustomChargeColor
-                ? settings.chargeColor
-                : (batteryPercent < 20 ? Color(255, 255, 50, 50) : Color(255, 0, 230, 120));
-        }
-        else {
-            themeColor = settings.useCustomDischargeColor
-                ? settings.dischargeColor
-                : Color(255, 255, 150, 50);
-        }
-
-        isVisible = true;
-        isFadingOut = false;
-        animFrame = 0;
-        holdFrame = 0;
+    // shcore.dll gibt es erst ab Windows 8.1, deshalb dynamisch laden.
+    // Umweg über void(*)(), sonst warnt GCC/MinGW mit -Wcast-function-type
+    template <typename Fn>
+    Fn ShcoreProc(const char* name) {
+        static HMODULE shcore = LoadLibraryW(L"shcore.dll");
+        return shcore ? reinterpret_cast<Fn>(reinterpret_cast<void (*)()>(GetProcAddress(shcore, name))) : nullptr;
     }
-};
 
-namespace Utils {
-    inline float EaseOutBack(float t) {
-        constexpr float c1 = 1.70158f;
-        constexpr float c3 = c1 + 1.0f;
-        const float t1 = t - 1.0f;
-        return 1.0f + c3 * t1 * t1 * t1 + c1 * t1 * t1;
+    void EnableDpiAwareness() {
+        typedef HRESULT(WINAPI* SetProcessDpiAwarenessFn)(int);
+        const auto setAwareness = ShcoreProc<SetProcessDpiAwarenessFn>("SetProcessDpiAwareness");
+        if (setAwareness && SUCCEEDED(setAwareness(2))) return;    // PROCESS_PER_MONITOR_DPI_AWARE
+        SetProcessDPIAware();
     }
 
-    template<typename T>
-    inline T Clamp(T value, T min, T max) {
-        return (value < min) ? min : (value > max) ? max : value;
+    float QueryMonitorDpiScale(HMONITOR monitor) {
+        typedef HRESULT(WINAPI* GetDpiForMonitorFn)(HMONITOR, int, UINT*, UINT*);
+        static const auto getDpi = ShcoreProc<GetDpiForMonitorFn>("GetDpiForMonitor");
+        UINT dpiX = 0, dpiY = 0;
+        if (getDpi && SUCCEEDED(getDpi(monitor, 0, &dpiX, &dpiY)) && dpiX > 0) {    // MDT_EFFECTIVE_DPI
+            return dpiX / 96.0f;
+        }
+        return QueryDpiScale();
     }
 
     bool GetBatteryStatus(BYTE& outPercent, bool& outIsCharging) {
@@ -201,16 +185,20 @@ namespace Utils {
         }
     }
 
-    std::wstring GetConfigPath() {
+    std::wstring GetAppDataPath(const wchar_t* file) {
         wchar_t path[MAX_PATH];
         if (SUCCEEDED(SHGetFolderPathW(nullptr, CSIDL_LOCAL_APPDATA, nullptr, 0, path))) {
-            std::wstring configPath = path;
-            configPath += Config::CONFIG_FILE;
-            return configPath;
+            std::wstring appDataPath = path;
+            appDataPath += file;
+            return appDataPath;
         }
         return L"";
     }
 
+    std::wstring GetConfigPath() {
+        return GetAppDataPath(Config::CONFIG_FILE);
+    }
+
     void SaveSettings(const AppSettings& settings) {
         std::wstring configPath = GetConfigPath();
         if (configPath.empty()) return;
@@ -226,6 +214,9 @@ namespace Utils {
             file.write(reinterpret_cast<const char*>(&settings.useCustomDischargeColor), sizeof(bool));
             file.write(reinterpret_cast<const char*>(&settings.showOnUnplug), sizeof(bool));
             file.write(reinterpret_cast<const char*>(&settings.playSound), sizeof(bool));
+            file.write(reinterpret_cast<const char*>(&settings.exportFrames), sizeof(bool));
+            file.write(reinterpret_cast<const char*>(&settings.showMiniRing), sizeof(bool));
+            file.write(reinterpret_cast<const char*>(&settings.frostedBackdrop), sizeof(bool));
             file.close();
         }
     }
@@ -242,6 +233,9 @@ namespace Utils {
             file.read(reinterpret_cast<char*>(&settings.useCustomDischargeColor), sizeof(bool));
             file.read(reinterpret_cast<char*>(&settings.showOnUnplug), sizeof(bool));
             file.read(reinterpret_cast<char*>(&settings.playSound), sizeof(bool));
+            file.read(reinterpret_cast<char*>(&settings.exportFrames), sizeof(bool));
+            file.read(reinterpret_cast<char*>(&settings.showMiniRing), sizeof(bool));
+            file.read(reinterpret_cast<char*>(&settings.frostedBackdrop), sizeof(bool));
             file.close();
             return true;
         }
@@ -256,134 +250,625 @@ namespace Utils {
     }
 }
 
-class HUDRenderer {
-public:
-    void Render(HWND hwnd, const HUDState& state) {
-        HDC hdcScreen = GetDC(nullptr);
-        if (!hdcScreen) return;
+namespace Theme {
+    // Ohne Datei gilt das eingebaute Theme; bei Fehlern ebenfalls, dann mit Beschreibung in error
+    inline bool Load(ThemeProgram& out, std::string& error) {
+        out = BuiltIn();
+        std::wstring themePath = Utils::GetAppDataPath(Config::THEME_FILE);
+        if (themePath.empty()) return true;
+
+        std::ifstream file(themePath, std::ios::binary);
+        if (!file.is_open()) return true;
+        const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return Compile(source, out, error);
+    }
+}
 
-        HDC hdcMem = CreateCompatibleDC(hdcScreen);
-        if (!hdcMem) {
-            ReleaseDC(nullptr, hdcScreen);
-            return;
+// DIB-Section (32bpp PARGB) + GDI+ Graphics, einmal pro Animation erzeugt.
+class GdiRenderTarget : public IRenderTarget {
+public:
+    static std::unique_ptr<IRenderTarget> Create() { return std::make_unique<GdiRenderTarget>(); }
+
+    ~GdiRenderTarget() override { Release(); }
+
+    bool Acquire(int width, int height) override {
+        if (IsAcquired() && surface.width == width && surface.height == height) return true;
+        Release();
+
+        hdcMem = CreateCompatibleDC(nullptr);
+        if (!hdcMem) return false;
+
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = width;
+        bmi.bmiHeader.biHeight = -height;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        void* bits = nullptr;
+        hBitmap = CreateDIBSection(hdcMem, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+        if (!hBitmap || !bits) {
+            Release();
+            return false;
         }
+        hOldBitmap = static_cast<HBITMAP>(SelectObject(hdcMem, hBitmap));
+
+        surface.pixels = static_cast<uint32_t*>(bits);
+        surface.width = width;
+        surface.height = height;
+        surface.stride = width;
+
+        bitmap = std::make_unique<Bitmap>(width, height, width * 4, PixelFormat32bppPARGB, static_cast<BYTE*>(bits));
+        graphics = std::make_unique<Graphics>(bitmap.get());
+        graphics->SetSmoothingMode(SmoothingModeAntiAlias);
+        graphics->SetTextRenderingHint(TextRenderingHintAntiAliasGridFit);
 
-        HBITMAP hBitmap = CreateCompatibleBitmap(hdcScreen, Config::HUD_SIZE, Config::HUD_SIZE);
-        if (!hBitmap) {
+        stats.surfaceAllocations++;
+        return true;
+    }
+
+    void Release() override {
+        graphics.reset();
+        bitmap.reset();
+
+        if (hdcMem) {
+            if (hOldBitmap) SelectObject(hdcMem, hOldBitmap);
             DeleteDC(hdcMem);
-            ReleaseDC(nullptr, hdcScreen);
-            return;
         }
+        if (hBitmap) {
+            DeleteObject(hBitmap);
+            stats.surfaceReleases++;
+        }
+
+        hdcMem = nullptr;
+        hBitmap = nullptr;
+        hOldBitmap = nullptr;
+        surface = Surface();
+    }
+
+    bool IsAcquired() const override { return graphics != nullptr; }
+    Surface GetSurface() const override { return surface; }
 
-        HBITMAP hOldBitmap = static_cast<HBITMAP>(SelectObject(hdcMem, hBitmap));
+    Graphics* Context() const override { return graphics.get(); }
+    HDC MemoryDC() const override { return hdcMem; }
+
+    void Flush() const override {
+        if (graphics) graphics->Flush();
+        GdiFlush();
+    }
+
+private:
+    HDC hdcMem = nullptr;
+    HBITMAP hBitmap = nullptr;
+    HBITMAP hOldBitmap = nullptr;
+    std::unique_ptr<Bitmap> bitmap;
+    std::unique_ptr<Graphics> graphics;
+    Surface surface;
+};
 
-        Graphics graphics(hdcMem);
-        graphics.SetSmoothingMode(SmoothingModeAntiAlias);
+// Segoe UI Bold wie bisher in RenderPercentageText (50px bei 96 DPI).
+class GdiPlusGlyphSource : public IGlyphSource {
+public:
+    explicit GdiPlusGlyphSource(float fontSize = Config::FONT_SIZE, const wchar_t* family = L"Segoe UI")
+        : fontFamily(InstalledOr(family, L"Segoe UI")), font(&fontFamily, fontSize, FontStyleBold, UnitPixel),
+        cell(static_cast<int>(fontSize * 1.28f + 0.5f) + 2 * padding) {}   // 96px bei 50px
+
+    static std::unique_ptr<IGlyphSource> Create(float fontSize, const wchar_t* fontFamily) {
+        return std::make_unique<GdiPlusGlyphSource>(fontSize, fontFamily);
+    }
+
+    bool RasterizeGlyph(wchar_t ch, GlyphBitmap& out) override {
+        Bitmap bitmap(cell, cell, PixelFormat32bppPARGB);
+        Graphics graphics(&bitmap);
         graphics.SetTextRenderingHint(TextRenderingHintAntiAliasGridFit);
         graphics.Clear(Color(0, 0, 0, 0));
 
-        float progress = Utils::Clamp(
-            static_cast<float>(state.animFrame) / Config::ANIM_FRAMES,
-            0.0f, 1.0f
-        );
+        const wchar_t text[2] = { ch, 0 };
+        const PointF origin(static_cast<REAL>(padding), 0.0f);
+        SolidBrush brush(Color(255, 255, 255, 255));
+        if (graphics.DrawString(text, 1, &font, origin, StringFormat::GenericTypographic(), &brush) != Ok) {
+            return false;
+        }
 
-        float scale, alphaFactor;
-        if (state.isFadingOut) {
-            float fadeProgress = static_cast<float>(state.holdFrame) / Config::FADEOUT_FRAMES;
-            scale = 1.0f - (1.0f - fadeProgress) * 0.1f;
-            alphaFactor = fadeProgress;
+        RectF bounds;
+        graphics.MeasureString(text, 1, &font, PointF(0.0f, 0.0f), StringFormat::GenericTypographic(), &bounds);
+        graphics.Flush();
+
+        BitmapData data;
+        Rect rect(0, 0, cell, cell);
+        if (bitmap.LockBits(&rect, ImageLockModeRead, PixelFormat32bppPARGB, &data) != Ok) return false;
+
+        int minX = cell, minY = cell, maxX = -1, maxY = -1;
+        for (int y = 0; y < cell; ++y) {
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(static_cast<const BYTE*>(data.Scan0) + y * data.Stride);
+            for (int x = 0; x < cell; ++x) {
+                if (row[x] >> 24) {
+                    if (x < minX) minX = x;
+                    if (x > maxX) maxX = x;
+                    if (y < minY) minY = y;
+                    if (y > maxY) maxY = y;
+                }
+            }
+        }
+
+        if (maxX < 0) {
+            out.width = out.height = 0;
+            out.coverage.clear();
         }
         else {
-            scale = Utils::EaseOutBack(progress);
-            alphaFactor = (progress > 0.5f) ? 1.0f : progress * 2.0f;
+            out.width = maxX - minX + 1;
+            out.height = maxY - minY + 1;
+            out.coverage.resize(static_cast<size_t>(out.width) * out.height);
+            for (int y = 0; y < out.height; ++y) {
+                const uint32_t* row = reinterpret_cast<const uint32_t*>(static_cast<const BYTE*>(data.Scan0) + (minY + y) * data.Stride);
+                for (int x = 0; x < out.width; ++x) {
+                    out.coverage[static_cast<size_t>(y) * out.width + x] = static_cast<uint8_t>(row[minX + x] >> 24);
+                }
+            }
         }
+        bitmap.UnlockBits(&data);
 
-        graphics.TranslateTransform(Config::HUD_SIZE / 2.0f, Config::HUD_SIZE / 2.0f);
-        graphics.ScaleTransform(scale, scale);
-        graphics.TranslateTransform(-Config::HUD_SIZE / 2.0f, -Config::HUD_SIZE / 2.0f);
+        out.offsetX = minX - padding;
+        out.offsetY = minY;
+        out.advance = bounds.Width;
+        lineHeight = static_cast<int>(bounds.Height + 0.5f);
+        return true;
+    }
 
-        int alpha = Utils::Clamp(static_cast<int>(255 * alphaFactor), 0, 255);
+    int LineHeight() const override { return lineHeight; }
 
-        RenderGlow(graphics, state.themeColor, alpha);
-        RenderBatteryRing(graphics, state.themeColor, state.batteryPercent, alpha);
-        RenderPercentageText(graphics, state.batteryPercent, alpha);
-        UpdateLayeredWindowContent(hwnd, hdcScreen, hdcMem, alpha);
+private:
+    // Fehlt die Schrift aus dem Theme, lieber die eingebaute als gar kein Text
+    static const wchar_t* InstalledOr(const wchar_t* family, const wchar_t* fallback) {
+        FontFamily probe(family);
+        return probe.GetLastStatus() == Ok ? family : fallback;
+    }
 
-        SelectObject(hdcMem, hOldBitmap);
-        DeleteObject(hBitmap);
-        DeleteDC(hdcMem);
-        ReleaseDC(nullptr, hdcScreen);
+    static constexpr int padding = 16;
+    FontFamily fontFamily;
+    Font font;
+    int cell;
+    int lineHeight = 0;
+};
+
+class GdiPlusHudRasterizer : public IHudRasterizer {
+public:
+    void Draw(const RenderContext& ctx, const FrameParams& params) override {
+        if (!ctx.graphics) return;
+        Layers& layers = buckets.Get(params.dpiScale);
+        const HudMetrics& m = layers.metrics;
+
+        Graphics& graphics = *ctx.graphics;
+        graphics.ResetTransform();
+        const bool draft = params.quality == RenderQuality::Draft;
+        graphics.SetSmoothingMode(draft ? SmoothingModeNone : SmoothingModeAntiAlias);
+        graphics.SetInterpolationMode(draft ? InterpolationModeNearestNeighbor : InterpolationModeBilinear);
+
+        graphics.TranslateTransform(m.center, m.center);
+        graphics.ScaleTransform(params.scale, params.scale);
+        graphics.TranslateTransform(-m.center, -m.center);
+
+        // Replay der Display-Liste
+        const uint32_t stateRgb = params.themeArgb & 0x00FFFFFF;
+        for (int i = 0; i < theme.opCount; ++i) {
+            const ThemeOp& op = theme.ops[i];
+            const uint32_t rgb = op.stateColor ? stateRgb : op.rgb;
+            switch (op.kind) {
+            case ThemeOp::Glow:
+                if (params.quality == RenderQuality::Full) RenderGlow(graphics, layers, op, rgb, params.alpha);
+                break;
+            case ThemeOp::Arc:
+                RenderBatteryRing(graphics, layers, i, rgb, params.percent, params.alpha);
+                break;
+            case ThemeOp::Text:
+                RenderPercentageText(graphics, layers, op, rgb, params.percent, params.alpha);
+                break;
+            }
+        }
+    }
+
+    GeometryCacheStats RingCacheStats() const override {
+        GeometryCacheStats stats = ringStats;
+        buckets.ForEach([&stats](const Layers& layers) { stats.bytes += layers.ringPathBytes; });
+        return stats;
+    }
+
+    void SetTheme(const ThemeProgram& program) override {
+        theme = program;
+        buckets.Clear();
     }
 
 private:
-    void RenderGlow(Graphics& graphics, const Color& themeColor, int alpha) {
-        GraphicsPath path;
-        path.AddEllipse(0, 0, Config::HUD_SIZE, Config::HUD_SIZE);
+    struct Layers {
+        explicit Layers(const HudMetrics& metrics) : metrics(metrics) {}
+
+        HudMetrics metrics;
+        GlowCache glowCache;
+        std::unique_ptr<Bitmap> glowBitmap;
+        unsigned glowBitmapGeneration = 0;
+        GlyphAtlas glyphAtlas;
+        std::vector<uint32_t> glyphPixels;
+        std::unique_ptr<Bitmap> glyphBitmap;
+        std::unique_ptr<GraphicsPath> ringPaths[Config::MAX_THEME_OPS][101];   // pro Arc-Ebene und Prozentwert
+        size_t ringPathBytes = 0;
+    };
+
+    // Färbt Weiß in rgb um und skaliert Alpha
+    static ColorMatrix TintMatrix(float alphaFactor, uint32_t rgb = 0x00FFFFFF) {
+        ColorMatrix matrix = { {
+            { ((rgb >> 16) & 0xFF) / 255.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+            { 0.0f, ((rgb >> 8) & 0xFF) / 255.0f, 0.0f, 0.0f, 0.0f },
+            { 0.0f, 0.0f, (rgb & 0xFF) / 255.0f, 0.0f, 0.0f },
+            { 0.0f, 0.0f, 0.0f, alphaFactor, 0.0f },
+            { 0.0f, 0.0f, 0.0f, 0.0f, 1.0f }
+        } };
+        return matrix;
+    }
 
-        PathGradientBrush brush(&path);
-        Color centerColor(alpha / 4, themeColor.GetR(), themeColor.GetG(), themeColor.GetB());
-        Color edgeColor(0, 0, 0, 0);
+    void RenderGlow(Graphics& graphics, Layers& layers, const ThemeOp& op, uint32_t rgb, int alpha) {
+        const HudMetrics& m = layers.metrics;
+        const Surface& layer = layers.glowCache.Get(rgb, m.size);
+        if (!layers.glowBitmap || layers.glowBitmapGeneration != layers.glowCache.Generation()) {
+            layers.glowBitmap = std::make_unique<Bitmap>(layer.width, layer.height, layer.stride * 4,
+                PixelFormat32bppPARGB, reinterpret_cast<BYTE*>(layer.pixels));
+            layers.glowBitmapGeneration = layers.glowCache.Generation();
+        }
 
-        int count = 1;
-        brush.SetCenterColor(centerColor);
-        brush.SetSurroundColors(&edgeColor, &count);
+        // Der Cache ist mit Alpha / 4 gerastert (Standard-Glow); op.alpha skaliert relativ dazu
+        const ColorMatrix matrix = TintMatrix(alpha / 255.0f * op.alpha * 4.0f);
+        ImageAttributes attributes;
+        attributes.SetColorMatrix(&matrix);
 
-        graphics.FillEllipse(&brush, 0, 0, Config::HUD_SIZE, Config::HUD_SIZE);
+        const REAL size = static_cast<REAL>(layer.width);
+        const REAL radius = op.radius * m.scale;
+        graphics.DrawImage(layers.glowBitmap.get(), RectF(m.center - radius, m.center - radius, 2 * radius, 2 * radius),
+            0, 0, size, size, UnitPixel, &attributes);
     }
 
-    void RenderBatteryRing(Graphics& graphics, const Color& themeColor, BYTE percent, int alpha) {
-        Pen ringPen(
-            Color(alpha, themeColor.GetR(), themeColor.GetG(), themeColor.GetB()),
-            10.0f
-        );
+    void RenderBatteryRing(Graphics& graphics, Layers& layers, int opIndex, uint32_t rgb, BYTE percent, int alpha) {
+        const ThemeOp& op = theme.ops[opIndex];
+        const BYTE sweepPercent = op.fullSweep ? 100 : percent;
+        const Color color(static_cast<BYTE>(alpha * op.alpha + 0.5f),
+            static_cast<BYTE>(rgb >> 16), static_cast<BYTE>(rgb >> 8), static_cast<BYTE>(rgb));
+
+        if (Config::CACHE_RING_GEOMETRY) {
+            SolidBrush brush(color);
+            graphics.FillPath(&brush, RingPath(layers, opIndex, sweepPercent));
+            return;
+        }
+
+        const HudMetrics& m = layers.metrics;
+        Pen ringPen(color, op.width * m.scale);
 
         ringPen.SetStartCap(LineCapRound);
         ringPen.SetEndCap(LineCapRound);
 
-        constexpr int margin = 60;
-        float sweepAngle = 360.0f * (percent / 100.0f);
+        const float radius = op.radius * m.scale;
+        const float margin = m.center - radius;
+        float sweepAngle = 360.0f * (sweepPercent / 100.0f);
 
         graphics.DrawArc(&ringPen, margin, margin,
-            Config::HUD_SIZE - 2 * margin, Config::HUD_SIZE - 2 * margin,
+            2 * radius, 2 * radius,
             -90.0f, sweepAngle);
     }
 
-    void RenderPercentageText(Graphics& graphics, BYTE percent, int alpha) {
-        FontFamily fontFamily(L"Segoe UI");
-        Font font(&fontFamily, 50, FontStyleBold, UnitPixel);
-        SolidBrush textBrush(Color(alpha, 255, 255, 255));
+    // Bogen einmal pro Ebene und Prozentwert flachlegen und mit rundem Stift verbreitern; danach nur noch FillPath
+    GraphicsPath* RingPath(Layers& layers, int opIndex, BYTE percent) {
+        std::unique_ptr<GraphicsPath>& path = layers.ringPaths[opIndex][percent];
+        if (path) {
+            ringStats.hits++;
+            return path.get();
+        }
 
-        std::wstring text = std::to_wstring(percent) + L"%";
+        const HudMetrics& m = layers.metrics;
+        const ThemeOp& op = theme.ops[opIndex];
+        const float radius = op.radius * m.scale;
+        const float margin = m.center - radius;
+        path = std::make_unique<GraphicsPath>(FillModeWinding);
+        path->AddArc(margin, margin, 2 * radius, 2 * radius, -90.0f, 360.0f * (percent / 100.0f));
+
+        Pen pen(Color(255, 0, 0, 0), op.width * m.scale);
+        pen.SetStartCap(LineCapRound);
+        pen.SetEndCap(LineCapRound);
+        path->Widen(&pen);
+        path->SetFillMode(FillModeWinding);    // Kappen überlappen bei 100 %
+
+        layers.ringPathBytes += path->GetPointCount() * (sizeof(PointF) + sizeof(BYTE));
+        ringStats.builds++;
+        return path.get();
+    }
+
+    void RenderPercentageText(Graphics& graphics, Layers& layers, const ThemeOp& op, uint32_t rgb, BYTE percent, int alpha) {
+        if (!EnsureGlyphAtlas(layers)) return;
+        const GlyphAtlas& atlas = layers.glyphAtlas;
+
+        GlyphAtlas::PlacedGlyph placed[GlyphAtlas::MAX_LAYOUT];
+        float totalWidth;
+        const int count = atlas.Layout(percent, placed, totalWidth);
 
-        StringFormat format;
-        format.SetAlignment(StringAlignmentCenter);
-        format.SetLineAlignment(StringAlignmentCenter);
+        const ColorMatrix matrix = TintMatrix(alpha / 255.0f * op.alpha, rgb);
+        ImageAttributes attributes;
+        attributes.SetColorMatrix(&matrix);
 
-        RectF layoutRect(0, 0, static_cast<float>(Config::HUD_SIZE), static_cast<float>(Config::HUD_SIZE));
-        graphics.DrawString(text.c_str(), -1, &font, layoutRect, &format, &textBrush);
+        const float originX = layers.metrics.center - totalWidth * 0.5f;
+        const float originY = layers.metrics.center - atlas.LineHeight() * 0.5f;
+
+        for (int i = 0; i < count; ++i) {
+            const GlyphAtlas::Entry& e = *placed[i].entry;
+            const RectF dest(originX + placed[i].x + e.offsetX, originY + e.offsetY,
+                static_cast<REAL>(e.width), static_cast<REAL>(e.height));
+            graphics.DrawImage(layers.glyphBitmap.get(), dest,
+                static_cast<REAL>(e.atlasX), 0.0f, static_cast<REAL>(e.width), static_cast<REAL>(e.height),
+                UnitPixel, &attributes);
+        }
     }
 
-    void UpdateLayeredWindowContent(HWND hwnd, HDC hdcScreen, HDC hdcMem, int alpha) {
-        int screenWidth = GetSystemMetrics(SM_CXSCREEN);
-        int screenHeight = GetSystemMetrics(SM_CYSCREEN);
+    bool EnsureGlyphAtlas(Layers& layers) {
+        if (layers.glyphBitmap) return true;
 
-        POINT ptDest = {
-            (screenWidth - Config::HUD_SIZE) / 2,
-            (screenHeight - Config::HUD_SIZE) / 2
-        };
-        SIZE size = { Config::HUD_SIZE, Config::HUD_SIZE };
+        GdiPlusGlyphSource source(theme.fontSize * layers.metrics.scale, theme.fontFamily);
+        if (!layers.glyphAtlas.Build(source)) return false;
+
+        // Weiß mit Abdeckung als (vormultipliziertem) Alpha
+        const int width = layers.glyphAtlas.Width();
+        const int height = layers.glyphAtlas.Height();
+        layers.glyphPixels.resize(static_cast<size_t>(width) * height);
+        for (size_t i = 0; i < layers.glyphPixels.size(); ++i) {
+            const uint32_t c = layers.glyphAtlas.Coverage()[i];
+            layers.glyphPixels[i] = (c << 24) | (c << 16) | (c << 8) | c;
+        }
+
+        layers.glyphBitmap = std::make_unique<Bitmap>(width, height, width * 4,
+            PixelFormat32bppPARGB, reinterpret_cast<BYTE*>(layers.glyphPixels.data()));
+        return true;
+    }
+
+    ThemeProgram theme = Theme::BuiltIn();
+    ScaleBuckets<Layers> buckets;
+    GeometryCacheStats ringStats;
+};
+
+// Software-Rasterizer mit GDI+-Schrift oder ganz GDI+ (Config::SOFTWARE_RASTERIZER)
+std::unique_ptr<IHudRasterizer> CreateHudRasterizer() {
+    if (Config::SOFTWARE_RASTERIZER) return std::make_unique<SoftwareHudRasterizer>(&GdiPlusGlyphSource::Create);
+    return std::make_unique<GdiPlusHudRasterizer>();
+}
+
+// Ein Layered Window pro Monitor; alle bekommen den DC ihrer Skalierung, ohne Kopie.
+// Corner: nur der Hauptmonitor, unten rechts im Arbeitsbereich (Mini-Ring).
+class LayeredWindowOutputs : public IHudOutputs {
+public:
+    enum class Placement { Center, Corner };
+
+    explicit LayeredWindowOutputs(Placement placement = Placement::Center) : placement(placement) {}
+
+    ~LayeredWindowOutputs() override {
+        for (HWND hwnd : windows) {
+            if (hwnd) DestroyWindow(hwnd);
+        }
+    }
+
+    void Refresh() override {
+        outputs.clear();
+        if (placement == Placement::Corner) {
+            CollectPrimaryWorkArea(outputs);
+        }
+        else {
+            EnumDisplayMonitors(nullptr, nullptr, &CollectMonitor, reinterpret_cast<LPARAM>(&outputs));
+        }
+
+        if (outputs.empty()) {
+            HudOutput primary;
+            primary.bounds = { 0, 0, GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN) };
+            primary.dpiScale = Utils::QueryDpiScale();
+            outputs.push_back(primary);
+        }
+
+        while (windows.size() > outputs.size()) {
+            if (windows.back()) DestroyWindow(windows.back());
+            windows.pop_back();
+            uploaded.pop_back();
+        }
+    }
+
+    const std::vector<HudOutput>& Outputs() const override { return outputs; }
+
+    void Present(size_t index, const PresentFrame& frame) override {
+        if (index >= outputs.size()) return;
+        HWND hwnd = EnsureWindow(index);
+        if (!hwnd) return;
+
+        const RECT& bounds = outputs[index].bounds;
+        const RECT centered = outputs[index].Centered(frame.surface.width, frame.surface.height);
+        POINT ptDest = { centered.left, centered.top };
+        if (placement == Placement::Corner) {
+            const int margin = static_cast<int>(Config::MINI_RING_MARGIN * frame.scale + 0.5f);
+            ptDest.x = bounds.right - frame.surface.width - margin;
+            ptDest.y = bounds.bottom - frame.surface.height - margin;
+        }
+        SIZE size = { frame.surface.width, frame.surface.height };
         POINT ptSrc = { 0, 0 };
 
         BLENDFUNCTION blend = {
             AC_SRC_OVER, 0,
-            static_cast<BYTE>(alpha),
+            static_cast<BYTE>(frame.alpha),
             AC_SRC_ALPHA
         };
 
-        UpdateLayeredWindow(hwnd, hdcScreen, &ptDest, &size, hdcMem, &ptSrc, 0, &blend, ULW_ALPHA);
+        // Nur das geänderte Rechteck hochladen, sobald das Fenster einen vollständigen Frame dieser Größe hat.
+        // Zweimal hintereinander ganz transparent: am Bild ändert sich nichts, auch nicht durch das Alpha.
+        const bool partial = uploaded[index].cx == size.cx && uploaded[index].cy == size.cy;
+        if (partial && frame.dirty.IsEmpty()) return;
+        RECT dirty = { frame.dirty.x0, frame.dirty.y0, frame.dirty.x1, frame.dirty.y1 };
+
+        UPDATELAYEREDWINDOWINFO info = {};
+        info.cbSize = sizeof(info);
+        info.pptDst = &ptDest;
+        info.psize = &size;
+        info.hdcSrc = frame.dc;
+        info.pptSrc = &ptSrc;
+        info.pblend = &blend;
+        info.dwFlags = ULW_ALPHA;
+        info.prcDirty = partial ? &dirty : nullptr;
+        BOOL ok = UpdateLayeredWindowIndirect(hwnd, &info);
+        if (!ok && partial) {
+            info.prcDirty = nullptr;
+            ok = UpdateLayeredWindowIndirect(hwnd, &info);
+        }
+        uploaded[index] = ok ? size : SIZE();
+    }
+
+private:
+    static BOOL CALLBACK CollectMonitor(HMONITOR monitor, HDC, LPRECT, LPARAM data) {
+        MONITORINFO info = {};
+        info.cbSize = sizeof(info);
+        if (GetMonitorInfoW(monitor, &info)) {
+            HudOutput output;
+            output.bounds = info.rcMonitor;
+            output.dpiScale = Utils::QueryMonitorDpiScale(monitor);
+            reinterpret_cast<std::vector<HudOutput>*>(data)->push_back(output);
+        }
+        return TRUE;
+    }
+
+    static void CollectPrimaryWorkArea(std::vector<HudOutput>& out) {
+        const POINT origin = { 0, 0 };
+        HMONITOR monitor = MonitorFromPoint(origin, MONITOR_DEFAULTTOPRIMARY);
+        MONITORINFO info = {};
+        info.cbSize = sizeof(info);
+        if (!GetMonitorInfoW(monitor, &info)) return;
+        HudOutput output;
+        output.bounds = info.rcWork;
+        output.dpiScale = Utils::QueryMonitorDpiScale(monitor);
+        out.push_back(output);
+    }
+
+    HWND EnsureWindow(size_t index) {
+        if (windows.size() <= index) {
+            windows.resize(index + 1, nullptr);
+            uploaded.resize(index + 1, SIZE());
+        }
+        if (windows[index]) return windows[index];
+
+        HINSTANCE hInstance = GetModuleHandleW(nullptr);
+        if (!classRegistered) {
+            WNDCLASSW wc = {};
+            wc.lpfnWndProc = DefWindowProcW;
+            wc.hInstance = hInstance;
+            wc.lpszClassName = Config::OUTPUT_WINDOW_CLASS;
+            classRegistered = RegisterClassW(&wc) != 0;
+            if (!classRegistered) return nullptr;
+        }
+
+        HWND hwnd = CreateWindowExW(
+            WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE | WS_EX_TRANSPARENT,
+            Config::OUTPUT_WINDOW_CLASS, L"Battery HUD", WS_POPUP,
+            0, 0, 1, 1, nullptr, nullptr, hInstance, nullptr
+        );
+        if (hwnd) ShowWindow(hwnd, SW_SHOWNOACTIVATE);
+        windows[index] = hwnd;
+        return hwnd;
     }
+
+    std::vector<HudOutput> outputs;
+    std::vector<HWND> windows;
+    std::vector<SIZE> uploaded;     // Größe des letzten vollständigen Uploads, {0, 0} = noch keiner
+    Placement placement;
+    bool classRegistered = false;
 };
 
+// BitBlt vom Bildschirm-DC ohne CAPTUREBLT: Layered Windows, also auch das HUD selbst, fehlen im Bild.
+// Einmal pro Popup; Ziel ist eine nackte DIB-Section ohne GDI+, die bei gleicher Größe wiederverwendet wird.
+class ScreenBackdropSource : public IBackdropSource {
+public:
+    ~ScreenBackdropSource() override { Release(); }
+
+    bool Capture(const RECT& rect, const Surface& dst) override {
+        if (!Acquire(dst.width, dst.height)) return false;
+        HDC screen = GetDC(nullptr);
+        const BOOL ok = screen && BitBlt(hdcMem, 0, 0, dst.width, dst.height, screen, rect.left, rect.top, SRCCOPY);
+        if (screen) ReleaseDC(nullptr, screen);
+        if (!ok) return false;
+
+        GdiFlush();
+        for (int y = 0; y < dst.height; ++y) {
+            const uint32_t* src = bits + static_cast<size_t>(y) * width;
+            uint32_t* row = dst.Row(y);
+            for (int x = 0; x < dst.width; ++x) row[x] = src[x] | 0xFF000000u;
+        }
+        return true;
+    }
+
+private:
+    bool Acquire(int w, int h) {
+        if (hBitmap && width == w && height == h) return true;
+        Release();
+
+        hdcMem = CreateCompatibleDC(nullptr);
+        if (!hdcMem) return false;
+
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = w;
+        bmi.bmiHeader.biHeight = -h;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        void* pixels = nullptr;
+        hBitmap = CreateDIBSection(hdcMem, &bmi, DIB_RGB_COLORS, &pixels, nullptr, 0);
+        if (!hBitmap || !pixels) {
+            Release();
+            return false;
+        }
+        hOldBitmap = static_cast<HBITMAP>(SelectObject(hdcMem, hBitmap));
+        bits = static_cast<uint32_t*>(pixels);
+        width = w;
+        height = h;
+        return true;
+    }
+
+    void Release() {
+        if (hdcMem) {
+            if (hOldBitmap) SelectObject(hdcMem, hOldBitmap);
+            DeleteDC(hdcMem);
+        }
+        if (hBitmap) DeleteObject(hBitmap);
+        hdcMem = nullptr;
+        hBitmap = nullptr;
+        hOldBitmap = nullptr;
+        bits = nullptr;
+        width = height = 0;
+    }
+
+    HDC hdcMem = nullptr;
+    HBITMAP hBitmap = nullptr;
+    HBITMAP hOldBitmap = nullptr;
+    uint32_t* bits = nullptr;
+    int width = 0, height = 0;
+};
+
+namespace Snapshot {
+    // true, wenn die Kommandozeile einen Snapshot-Lauf verlangt hat; exitCode ist dann gesetzt
+    bool RunFromCommandLine(int& exitCode) {
+        int argc = 0;
+        LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+        if (!argv) return false;
+
+        bool handled = false;
+        for (int i = 1; i + 1 < argc && !handled; ++i) {
+            const std::wstring arg = argv[i];
+            if (arg == L"--snapshot-record" || arg == L"--snapshot-verify") {
+                exitCode = Run(argv[i + 1], arg == L"--snapshot-record");
+                handled = true;
+            }
+        }
+        LocalFree(argv);
+        return handled;
+    }
+}
+
 class TrayIconManager {
 public:
     static void Create(HWND hwnd) {
@@ -408,6 +893,59 @@ public:
         Shell_NotifyIconW(NIM_DELETE, &nid);
     }
 
+    // Icon aus den Pixeln des TrayIconCache; current ist das bisherige eigene Icon und wird danach freigegeben
+    static void SetIcon(HWND hwnd, const Surface& image, const wchar_t* tip, HICON& current) {
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = image.width;
+        bmi.bmiHeader.biHeight = -image.height;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        void* bits = nullptr;
+        HBITMAP color = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+        HBITMAP mask = CreateBitmap(image.width, image.height, 1, 1, nullptr);
+        HICON icon = nullptr;
+        if (color && mask && bits) {
+            // Icons erwarten nicht vormultipliziertes Alpha
+            uint32_t* dst = static_cast<uint32_t*>(bits);
+            for (int y = 0; y < image.height; ++y) {
+                const uint32_t* row = image.Row(y);
+                for (int x = 0; x < image.width; ++x) {
+                    const uint32_t p = row[x];
+                    const uint32_t a = p >> 24;
+                    uint32_t out = 0;
+                    if (a != 0) {
+                        auto channel = [&](int shift) { return ((((p >> shift) & 0xFF) * 255 + a / 2) / a) << shift; };
+                        out = (a << 24) | channel(16) | channel(8) | channel(0);
+                    }
+                    dst[static_cast<size_t>(y) * image.width + x] = out;
+                }
+            }
+            ICONINFO info = {};
+            info.fIcon = TRUE;
+            info.hbmMask = mask;
+            info.hbmColor = color;
+            icon = CreateIconIndirect(&info);
+        }
+        if (color) DeleteObject(color);
+        if (mask) DeleteObject(mask);
+        if (!icon) return;
+
+        NOTIFYICONDATAW nid = {};
+        nid.cbSize = sizeof(NOTIFYICONDATAW);
+        nid.hWnd = hwnd;
+        nid.uID = TRAY_ICON_ID;
+        nid.uFlags = NIF_ICON | NIF_TIP;
+        nid.hIcon = icon;
+        wcscpy_s(nid.szTip, tip);
+        Shell_NotifyIconW(NIM_MODIFY, &nid);
+
+        if (current) DestroyIcon(current);
+        current = icon;
+    }
+
     static void ShowContextMenu(HWND hwnd, const AppSettings& settings) {
         POINT pt;
         GetCursorPos(&pt);
@@ -420,6 +958,9 @@ public:
         AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
         AppendMenuW(hMenu, settings.showOnUnplug ? MF_CHECKED : MF_UNCHECKED, IDM_TOGGLE_UNPLUG, L"Animation beim Ausstecken");
         AppendMenuW(hMenu, settings.playSound ? MF_CHECKED : MF_UNCHECKED, IDM_TOGGLE_SOUND, L"Sound abspielen");
+        AppendMenuW(hMenu, settings.exportFrames ? MF_CHECKED : MF_UNCHECKED, IDM_TOGGLE_EXPORT, L"Frames für Overlays freigeben");
+        AppendMenuW(hMenu, settings.showMiniRing ? MF_CHECKED : MF_UNCHECKED, IDM_TOGGLE_MINI_RING, L"Mini-Ring in der Ecke");
+        AppendMenuW(hMenu, settings.frostedBackdrop ? MF_CHECKED : MF_UNCHECKED, IDM_TOGGLE_BACKDROP, L"Milchglas hinter dem HUD");
         AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
         AppendMenuW(hMenu, MF_STRING, IDM_EXIT, L"Beenden");
 
@@ -429,15 +970,94 @@ public:
     }
 };
 HUDState g_hud;
-HUDRenderer g_renderer;
+HUDRenderer g_renderer(std::make_unique<LayeredWindowOutputs>(), &GdiRenderTarget::Create, &CreateHudRasterizer);
 AppSettings g_settings;
+ThemeProgram g_theme = Theme::BuiltIn();
+FrameGovernor g_governor;
+FrameScheduler g_scheduler;
+bool g_timerPeriodRaised = false;
 bool g_lastChargingState = false;
+std::unique_ptr<MiniRingWidget> g_miniRing;     // nur, solange eingeschaltet
+TrayIconCache g_trayIcons;
+HICON g_trayIcon = nullptr;
+
+// Nur wenn sich Prozent oder Ladezustand im Tray ändern; jedes andere Batterie-Ereignis kostet einen Vergleich
+void UpdateTrayIcon(HWND hwnd, BYTE percent, bool isCharging) {
+    if (!g_trayIcons.Update(percent, isCharging, g_settings, Utils::QueryDpiScale())) return;
+    const std::wstring tip = L"Battery HUD - " + std::to_wstring(g_trayIcons.Percent()) + L" % ("
+        + (g_trayIcons.IsCharging() ? L"lädt" : L"Akku") + L")";
+    TrayIconManager::SetIcon(hwnd, g_trayIcons.Current(), tip.c_str(), g_trayIcon);
+}
+
+// Mini-Ring an den aktuellen Zustand angleichen; zeichnet nur, wenn sich das Bild ändert
+void UpdateMiniRing() {
+    BYTE percent;
+    bool isCharging;
+    if (g_miniRing && Utils::GetBatteryStatus(percent, isCharging)) {
+        g_miniRing->Update(percent, isCharging, g_settings);
+    }
+}
+
+void EnableMiniRing(bool enable) {
+    if (!enable) {
+        g_miniRing.reset();
+        return;
+    }
+    if (g_miniRing) return;
+    g_miniRing = std::make_unique<MiniRingWidget>(
+        std::make_unique<LayeredWindowOutputs>(LayeredWindowOutputs::Placement::Corner), &GdiRenderTarget::Create,
+        &GdiPlusGlyphSource::Create);
+    g_miniRing->SetTheme(g_theme);
+    UpdateMiniRing();
+}
+
+// Nach Farbänderungen: Tray-Icon und Mini-Ring in der neuen Farbe
+void UpdateIndicators(HWND hwnd) {
+    BYTE percent;
+    bool isCharging;
+    if (!Utils::GetBatteryStatus(percent, isCharging)) return;
+    UpdateTrayIcon(hwnd, percent, isCharging);
+    if (g_miniRing) g_miniRing->Update(percent, isCharging, g_settings);
+}
+
+// Während des Popups 1-ms-Timerauflösung, sonst wird aus 16 ms oft 31 ms
+void StartAnimationTimer(HWND hwnd) {
+    if (!g_timerPeriodRaised) g_timerPeriodRaised = (timeBeginPeriod(1) == TIMERR_NOERROR);
+    SetTimer(hwnd, 1, g_scheduler.Start(g_governor.FrameStep()), nullptr);
+}
+
+void StopAnimationTimer(HWND hwnd) {
+    KillTimer(hwnd, 1);
+    if (g_timerPeriodRaised) {
+        timeEndPeriod(1);
+        g_timerPeriodRaised = false;
+    }
+}
+
+// "--simd scalar|sse2|avx2|avx512" erzwingt eine Kernel-Stufe (höchstens die der CPU), auch für Snapshot-Läufe
+void ApplySimdOverride() {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) return;
+
+    for (int i = 1; i + 1 < argc; ++i) {
+        Raster::SimdLevel level = Raster::SimdLevel::Scalar;
+        if (std::wstring(argv[i]) == L"--simd" && Raster::ParseSimdLevel(argv[i + 1], level)) {
+            Raster::SelectKernels(level);
+        }
+    }
+    LocalFree(argv);
+}
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
-    case WM_CREATE:
+    case WM_CREATE: {
         TrayIconManager::Create(hwnd);
+        BYTE percent;
+        bool isCharging;
+        if (Utils::GetBatteryStatus(percent, isCharging)) UpdateTrayIcon(hwnd, percent, isCharging);
         return 0;
+    }
 
     case WM_TRAYICON:
         if (lParam == WM_RBUTTONUP) {
@@ -452,8 +1072,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             bool isCharging;
 
             if (Utils::GetBatteryStatus(percent, isCharging)) {
-                g_hud.startAnimation(percent, isCharging, g_settings);
-                SetTimer(hwnd, 1, Config::TIMER_INTERVAL_MS, nullptr);
+                g_governor.SetPowerSource(isCharging);
+                g_hud.startAnimation(percent, isCharging, g_settings, g_theme);
+                g_renderer.BeginAnimation();
+                StartAnimationTimer(hwnd);
             }
             return 0;
         }
@@ -463,6 +1085,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                 g_settings.chargeColor = newColor;
                 g_settings.useCustomChargeColor = true;
                 Utils::SaveSettings(g_settings);
+                UpdateIndicators(hwnd);
             }
             return 0;
         }
@@ -472,6 +1095,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                 g_settings.dischargeColor = newColor;
                 g_settings.useCustomDischargeColor = true;
                 Utils::SaveSettings(g_settings);
+                UpdateIndicators(hwnd);
             }
             return 0;
         }
@@ -479,6 +1103,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             g_settings.useCustomChargeColor = false;
             g_settings.useCustomDischargeColor = false;
             Utils::SaveSettings(g_settings);
+            UpdateIndicators(hwnd);
             return 0;
         }
         case IDM_TOGGLE_UNPLUG: {
@@ -491,6 +1116,25 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             Utils::SaveSettings(g_settings);
             return 0;
         }
+        case IDM_TOGGLE_EXPORT: {
+            // Lässt sich der Ring nicht anlegen, bleibt der Haken aus
+            const bool enable = !g_settings.exportFrames;
+            g_settings.exportFrames = g_renderer.EnableFrameExport(enable) && enable;
+            Utils::SaveSettings(g_settings);
+            return 0;
+        }
+        case IDM_TOGGLE_MINI_RING: {
+            g_settings.showMiniRing = !g_settings.showMiniRing;
+            EnableMiniRing(g_settings.showMiniRing);
+            Utils::SaveSettings(g_settings);
+            return 0;
+        }
+        case IDM_TOGGLE_BACKDROP: {
+            g_settings.frostedBackdrop = !g_settings.frostedBackdrop;
+            g_renderer.EnableBackdrop(g_settings.frostedBackdrop ? std::make_unique<ScreenBackdropSource>() : nullptr);
+            Utils::SaveSettings(g_settings);
+            return 0;
+        }
         case IDM_EXIT:
             DestroyWindow(hwnd);
             return 0;
@@ -499,57 +1143,97 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
     case WM_POWERBROADCAST:
         if (wParam == PBT_APMPOWERSTATUSCHANGE) {
-            if (!g_hud.isVisible) {
-                BYTE percent;
-                bool isCharging;
-
-                if (Utils::GetBatteryStatus(percent, isCharging)) {
-                    bool stateChanged = (isCharging != g_lastChargingState);
-                    g_lastChargingState = isCharging;
-
-                    if (stateChanged) {
-                        if (isCharging || g_settings.showOnUnplug) {
-                            if (g_settings.playSound) {
-                                Utils::PlayNotificationSound(isCharging);
-                            }
-                            g_hud.startAnimation(percent, isCharging, g_settings);
-                            SetTimer(hwnd, 1, Config::TIMER_INTERVAL_MS, nullptr);
+            BYTE percent;
+            bool isCharging;
+
+            if (Utils::GetBatteryStatus(percent, isCharging)) {
+                bool stateChanged = (isCharging != g_lastChargingState);
+                g_lastChargingState = isCharging;
+                g_governor.SetPowerSource(isCharging);
+                UpdateTrayIcon(hwnd, percent, isCharging);
+                if (g_miniRing) g_miniRing->Update(percent, isCharging, g_settings);
+
+                if (stateChanged && g_hud.isVisible) {
+                    // Sichtbar: nicht verwerfen, sondern in die neue Farbe überblenden
+                    if (g_settings.playSound && (isCharging || g_settings.showOnUnplug)) {
+                        Utils::PlayNotificationSound(isCharging);
+                    }
+                    const int interval = g_hud.changeState(percent, isCharging, g_settings, g_theme);
+                    SetTimer(hwnd, 1, g_scheduler.Restart(interval, g_governor.FrameStep()), nullptr);
+                }
+                else if (!stateChanged && g_hud.isVisible && percent != g_hud.batteryPercent) {
+                    // Nur die Zahl: sofort zeichnen, auch mitten in der Hold-Phase, ohne den Timer anzufassen
+                    if (g_hud.updatePercent(percent, g_settings, g_theme)) {
+                        g_governor.BeginFrame();
+                        g_renderer.Render(g_hud, g_governor.Quality());
+                        g_governor.EndFrame();
+                    }
+                    else {
+                        const int interval = g_hud.changeState(percent, isCharging, g_settings, g_theme);
+                        SetTimer(hwnd, 1, g_scheduler.Restart(interval, g_governor.FrameStep()), nullptr);
+                    }
+                }
+                else if (stateChanged) {
+                    if (isCharging || g_settings.showOnUnplug) {
+                        if (g_settings.playSound) {
+                            Utils::PlayNotificationSound(isCharging);
                         }
+                        g_hud.startAnimation(percent, isCharging, g_settings, g_theme);
+                        g_renderer.BeginAnimation();
+                        StartAnimationTimer(hwnd);
                     }
                 }
             }
         }
         return TRUE;
 
+    case WM_DISPLAYCHANGE:
+        g_renderer.RefreshOutputs();
+        if (g_miniRing) g_miniRing->RefreshOutputs();
+        return 0;
+
     case WM_TIMER:
         if (wParam == 1) {
             if (!g_hud.isVisible) {
-                KillTimer(hwnd, 1);
+                StopAnimationTimer(hwnd);
+                g_renderer.EndAnimation();
                 return 0;
             }
 
-            if (!g_hud.isFadingOut) {
-                if (g_hud.animFrame < Config::ANIM_FRAMES) {
-                    g_hud.animFrame++;
-                }
-                else if (++g_hud.holdFrame > Config::HOLD_FRAMES) {
-                    g_hud.isFadingOut = true;
-                    g_hud.holdFrame = Config::FADEOUT_FRAMES;
-                }
+            // Fortschritt nach verstrichener Zeit; zu früh geweckt heißt nur: bis zur Frist weiterschlafen
+            const int due = g_scheduler.DueFrames();
+            if (due == 0) {
+                SetTimer(hwnd, 1, g_scheduler.RemainingMs(), nullptr);
+                return 0;
+            }
+
+            const int interval = g_hud.Tick(due);
+            if (interval < 0) {
+                StopAnimationTimer(hwnd);
             }
             else {
-                if (--g_hud.holdFrame <= 0) {
-                    g_hud.reset();
-                    KillTimer(hwnd, 1);
-                }
+                // Auch ohne neues Intervall neu stellen: auf die nächste Frist, mit der aktuellen Governor-Stufe
+                SetTimer(hwnd, 1, g_scheduler.Schedule(interval, g_governor.FrameStep()), nullptr);
             }
 
-            g_renderer.Render(hwnd, g_hud);
+            g_governor.BeginFrame();
+            g_renderer.Render(g_hud, g_governor.Quality());
+            g_governor.EndFrame();
+
+            // Nach dem Reset (letzter, transparenter Frame) die Zeichenfläche freigeben
+            if (!g_hud.isVisible) {
+                g_renderer.EndAnimation();
+            }
         }
         return 0;
 
     case WM_DESTROY:
+        StopAnimationTimer(hwnd);
+        g_renderer.EndAnimation();
+        g_miniRing.reset();
         TrayIconManager::Remove(hwnd);
+        if (g_trayIcon) DestroyIcon(g_trayIcon);
+        g_trayIcon = nullptr;
         PostQuitMessage(0);
         return 0;
 
@@ -561,6 +1245,13 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 }
 
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow) {
+    // 0. Headless-Snapshot-Test: kein Fenster, kein GDI+, läuft auch neben einer laufenden Instanz
+    ApplySimdOverride();
+    int snapshotExitCode = 0;
+    if (Snapshot::RunFromCommandLine(snapshotExitCode)) {
+        return snapshotExitCode;
+    }
+
     // 1. Prüfen, ob die App schon läuft
     HWND existing = FindWindowW(L"BatteryHUDClass", nullptr);
     if (existing) {
@@ -568,6 +1259,9 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
         return 0;
     }
 
+    // Echte Pixel statt Bitmap-Skalierung durch Windows; die HUD-Größe folgt der DPI des Monitors
+    Utils::EnableDpiAwareness();
+
     // 2. GDI+ starten
     ULONG_PTR gdiplusToken;
     GdiplusStartupInput gdiplusStartupInput;
@@ -578,14 +1272,25 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
     // 3. Online-Service (Tracking & Update) im Hintergrund starten
     CreateThread(NULL, 0, OnlineService, NULL, 0, NULL);
 
-    // 4. Einstellungen laden
+    // 4. Einstellungen und Theme laden
     Utils::LoadSettings(g_settings);
 
+    std::string themeError;
+    if (!Theme::Load(g_theme, themeError)) {
+        const std::wstring message = L"theme.ini wird ignoriert:\n" + Utils::Widen(themeError);
+        MessageBoxW(nullptr, message.c_str(), L"Battery HUD", MB_OK | MB_ICONWARNING);
+    }
+    g_renderer.SetTheme(g_theme);
+    g_trayIcons.SetTheme(g_theme);
+    if (g_settings.exportFrames) g_renderer.EnableFrameExport(true);
+    if (g_settings.frostedBackdrop) g_renderer.EnableBackdrop(std::make_unique<ScreenBackdropSource>());
+
     // 5. Initialer Batterie-Status
     BYTE percent;
     bool isCharging;
     if (Utils::GetBatteryStatus(percent, isCharging)) {
         g_lastChargingState = isCharging;
+        g_governor.SetPowerSource(isCharging);
     }
 
     // 6. Fensterklasse registrieren
@@ -614,6 +1319,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
     }
 
     ShowWindow(hwnd, SW_SHOW);
+    if (g_settings.showMiniRing) EnableMiniRing(true);
 
     // 8. Message Loop
     MSG msg;
@@ -627,4 +1333,4 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
     GdiplusShutdown(gdiplusToken);
 
     return static_cast<int>(msg.wParam);
-}
\ No newline at end of file
+}
@@ -0,0 +1,263 @@
+// Referenz-Leser für den Frame-Export von Battery HUD (Menü "Frames für Overlays freigeben").
+// Liest die Frames direkt aus dem Shared-Memory-Ring (hudframes.h), ohne Kopie und ohne Sperre.
+//
+//   hudconsumer [sekunden]                   liest den Ring der laufenden App, meldet Bildrate und Latenz
+//   hudconsumer --bench [sekunden] [größe]   Durchsatztest mit eigenem Ring: Schreiber- und Leser-Thread
+//                                            über zwei getrennte Abbildungen; läuft auch unter Linux
+//
+// Windows: cl /O2 /EHsc hudconsumer.cpp
+// Linux:   g++ -O2 -std=c++14 -pthread hudconsumer.cpp -o hudconsumer -lrt
+#include "hudframes.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // steady_clock ist unter MSVC QPC, also dieselbe Uhr wie Utils::NowMs in der App
+    uint64_t NowUs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Benannte Abbildung: Create für den Schreiber, Open für Leser (nur lesend)
+    class SharedMapping {
+    public:
+        SharedMapping() = default;
+        SharedMapping(const SharedMapping&) = delete;
+        SharedMapping& operator=(const SharedMapping&) = delete;
+
+        ~SharedMapping() {
+#if defined(_WIN32)
+            if (data) UnmapViewOfFile(data);
+            if (handle) CloseHandle(handle);
+#else
+            if (data) munmap(data, static_cast<size_t>(bytes));
+            if (owner) shm_unlink(name.c_str());
+#endif
+        }
+
+        bool Create(const std::string& mappingName, uint64_t size) {
+            name = mappingName;
+            bytes = size;
+#if defined(_WIN32)
+            const std::wstring wide(name.begin(), name.end());
+            handle = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), wide.c_str());
+            if (!handle) return false;
+            data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, static_cast<SIZE_T>(size));
+#else
+            const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+            if (fd < 0) return false;
+            owner = true;
+            if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+                void* mapped = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                data = (mapped == MAP_FAILED) ? nullptr : mapped;
+            }
+            close(fd);
+#endif
+            return data != nullptr;
+        }
+
+        bool Open(const std::string& mappingName) {
+            name = mappingName;
+#if defined(_WIN32)
+            const std::wstring wide(name.begin(), name.end());
+            handle = OpenFileMappingW(FILE_MAP_READ, FALSE, wide.c_str());
+            if (!handle) return false;
+            data = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+#else
+            const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) return false;
+            struct stat info = {};
+            if (fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_size) >= HudFrames::PIXEL_OFFSET) {
+                bytes = static_cast<uint64_t>(info.st_size);
+                void* mapped = mmap(nullptr, static_cast<size_t>(bytes), PROT_READ, MAP_SHARED, fd, 0);
+                data = (mapped == MAP_FAILED) ? nullptr : mapped;
+            }
+            close(fd);
+#endif
+            return data != nullptr;
+        }
+
+        void* Data() const { return data; }
+
+    private:
+        std::string name;
+        uint64_t bytes = 0;
+        void* data = nullptr;
+#if defined(_WIN32)
+        HANDLE handle = nullptr;
+#else
+        bool owner = false;
+#endif
+    };
+
+    std::string RingName(const char* suffix) {
+#if defined(_WIN32)
+        const std::wstring wide = HudFrames::WINDOWS_NAME;
+        std::string name(wide.begin(), wide.end());
+#else
+        std::string name = HudFrames::POSIX_NAME;
+#endif
+        return name + suffix;
+    }
+
+    struct ReadStats {
+        unsigned frames = 0;
+        unsigned torn = 0;          // beim Lesen überschrieben, verworfen
+        unsigned skipped = 0;       // nie gesehene Frames (Leser zu langsam)
+        unsigned contentErrors = 0;
+        uint64_t bytes = 0;
+        double latencyMs = 0.0;     // Summe, geteilt durch frames = Mittel
+    };
+
+    // Ein Frame direkt aus dem Slot; summiert Alpha als Beispiel für echte Arbeit auf den Pixeln
+    bool ReadFrame(const HudFrames::Reader& reader, uint64_t frame, ReadStats& stats, uint64_t& alphaSum,
+        bool checkStamp) {
+        HudFrames::FrameView view;
+        if (!reader.Acquire(frame, view)) {
+            stats.torn++;
+            return false;
+        }
+
+        uint64_t sum = 0;
+        for (uint32_t y = 0; y < view.height; ++y) {
+            const uint32_t* row = view.Row(y);
+            for (uint32_t x = 0; x < view.width; ++x) sum += row[x] >> 24;
+        }
+        const uint32_t stamp = static_cast<uint32_t>(frame);
+        const bool stampOk = !checkStamp || (view.height > 0 && view.pixels[0] == stamp
+            && view.Row(view.height - 1)[view.width - 1] == stamp);
+
+        if (!reader.StillValid(view)) {
+            stats.torn++;
+            return false;
+        }
+        if (!stampOk) stats.contentErrors++;
+        alphaSum = sum;
+        stats.frames++;
+        stats.bytes += static_cast<uint64_t>(view.width) * view.height * 4;
+        stats.latencyMs += static_cast<double>(NowUs() - view.timestampUs) / 1000.0;
+        return true;
+    }
+
+    int Watch(double seconds) {
+        SharedMapping mapping;
+        if (!mapping.Open(RingName(""))) {
+            fprintf(stderr, "Kein Frame-Export gefunden; in Battery HUD \"Frames für Overlays freigeben\" einschalten.\n");
+            return 1;
+        }
+        HudFrames::Reader reader(mapping.Data());
+        if (!reader.IsValid()) {
+            fprintf(stderr, "Unbekanntes Ring-Format.\n");
+            return 1;
+        }
+
+        ReadStats stats;
+        uint64_t last = reader.Latest();
+        uint64_t alphaSum = 0;
+        const uint64_t start = NowUs();
+        uint64_t nextReport = start + 1000000;
+        while (NowUs() - start < static_cast<uint64_t>(seconds * 1e6)) {
+            const uint64_t latest = reader.Latest();
+            if (latest != last) {
+                if (last != 0 && latest > last + 1) stats.skipped += static_cast<unsigned>(latest - last - 1);
+                ReadFrame(reader, latest, stats, alphaSum, false);
+                last = latest;
+            }
+            if (NowUs() >= nextReport) {
+                printf("frames %u, verworfen %u, übersprungen %u, latenz %.2f ms, alpha-summe %llu\n", stats.frames,
+                    stats.torn, stats.skipped, stats.frames ? stats.latencyMs / stats.frames : 0.0,
+                    static_cast<unsigned long long>(alphaSum));
+                stats = ReadStats();
+                nextReport += 1000000;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return 0;
+    }
+
+    // Schreiber so schnell er kann, Leser nimmt jeweils den neuesten Frame; erstes und letztes Pixel tragen
+    // die Frame-Nummer, damit ein vom Seqlock übersehener Riss als Inhaltsfehler auffällt
+    int Bench(double seconds, uint32_t size) {
+        const std::string name = RingName((".bench." + std::to_string(static_cast<long long>(NowUs() % 100000))).c_str());
+        SharedMapping producerMapping, consumerMapping;
+        if (!producerMapping.Create(name, HudFrames::MappingBytes())) {
+            fprintf(stderr, "Ring %s lässt sich nicht anlegen.\n", name.c_str());
+            return 1;
+        }
+        HudFrames::Writer writer(producerMapping.Data());
+        writer.Init();
+        if (!consumerMapping.Open(name)) {
+            fprintf(stderr, "Ring %s lässt sich nicht öffnen.\n", name.c_str());
+            return 1;
+        }
+        HudFrames::Reader reader(consumerMapping.Data());
+
+        std::vector<uint32_t> source(static_cast<size_t>(size) * size, 0x80402010u);
+        std::atomic<bool> stop(false);
+        uint64_t published = 0;
+        std::thread producer([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                const uint32_t stamp = static_cast<uint32_t>(published + 1);
+                source.front() = stamp;
+                source.back() = stamp;
+                if (!writer.Publish(source.data(), size, size, size * 4, 255, 1.0f, NowUs())) break;
+                published++;
+            }
+        });
+
+        ReadStats stats;
+        uint64_t last = 0, alphaSum = 0;
+        const uint64_t start = NowUs();
+        while (NowUs() - start < static_cast<uint64_t>(seconds * 1e6)) {
+            const uint64_t latest = reader.Latest();
+            if (latest == last) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (latest > last + 1) stats.skipped += static_cast<unsigned>(latest - last - 1);
+            ReadFrame(reader, latest, stats, alphaSum, true);
+            last = latest;
+        }
+        stop.store(true);
+        producer.join();
+
+        const double elapsed = static_cast<double>(NowUs() - start) / 1e6;
+        const double frameBytes = static_cast<double>(size) * size * 4;
+        printf("bench %ux%u, %.1f s\n", size, size, elapsed);
+        printf("  schreiber: %.0f frames/s, %.2f GB/s\n", published / elapsed, published * frameBytes / elapsed / 1e9);
+        printf("  leser:     %.0f frames/s, %.2f GB/s ohne Kopie, latenz %.3f ms\n", stats.frames / elapsed,
+            static_cast<double>(stats.bytes) / elapsed / 1e9, stats.frames ? stats.latencyMs / stats.frames : 0.0);
+        printf("  verworfen %u, übersprungen %u, inhaltsfehler %u\n", stats.torn, stats.skipped, stats.contentErrors);
+        return (stats.contentErrors == 0 && stats.frames > 0) ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+#if defined(_WIN32)
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        const double seconds = (argc > 2) ? std::atof(argv[2]) : 3.0;
+        const long size = (argc > 3) ? std::atol(argv[3]) : 350;
+        if (size <= 0 || size > static_cast<long>(HudFrames::MAX_SIZE)) {
+            fprintf(stderr, "Größe 1..%u\n", HudFrames::MAX_SIZE);
+            return 2;
+        }
+        return Bench(seconds, static_cast<uint32_t>(size));
+    }
+    return Watch((argc > 1) ? std::atof(argv[1]) : 10.0);
+}
@@ -0,0 +1,4859 @@
+// Kern von Battery HUD ohne Fenster und ohne Tray: Theme, Animation, Software-Rasterizer, Caches, Renderer,
+// Mini-Ring, Tray-Icon-Bilder und Governor. Gemeinsam für chargingV3.cpp (die App, mit den GDI/GDI+-Backends)
+// und hudsnapshot.cpp (Snapshot-Test, läuft auch unter Linux). Ohne Windows stehen unten nur die paar Typen
+// bereit, die in Signaturen vorkommen; Graphics und HDC bleiben dort leer.
+#pragma once
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <objbase.h>
+#include <gdiplus.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+// Span-Kernel gibt es für jede Stufe, gewählt wird zur Laufzeit (Raster::SelectKernels)
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HUD_SIMD_DISPATCH 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HUD_TARGET(isa)
+#elif defined(__clang__)
+#include <cpuid.h>
+#define HUD_TARGET(isa) __attribute__((target(isa)))
+#else
+// Ohne fp-contract=off zieht GCC mit AVX-512 Multiplikation und Addition zu FMA zusammen (andere Rundung)
+#include <cpuid.h>
+#define HUD_TARGET(isa) __attribute__((target(isa), optimize("fp-contract=off")))
+#endif
+#endif
+#include "hudframes.h"
+
+#if defined(_WIN32)
+using namespace Gdiplus;
+#else
+typedef unsigned char BYTE;
+typedef long LONG;
+typedef void* HDC;
+struct RECT {
+    LONG left, top, right, bottom;
+};
+
+namespace Gdiplus {
+    class Graphics;
+
+    // Wie Gdiplus::Color: ARGB in einem Wort
+    class Color {
+    public:
+        Color() : argb(0xFF000000u) {}
+        Color(uint32_t argb) : argb(argb) {}
+        Color(BYTE a, BYTE r, BYTE g, BYTE b)
+            : argb((static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | b) {}
+
+        uint32_t GetValue() const { return argb; }
+        BYTE GetA() const { return static_cast<BYTE>(argb >> 24); }
+        BYTE GetR() const { return static_cast<BYTE>(argb >> 16); }
+        BYTE GetG() const { return static_cast<BYTE>(argb >> 8); }
+        BYTE GetB() const { return static_cast<BYTE>(argb); }
+
+    private:
+        uint32_t argb;
+    };
+}
+
+using namespace Gdiplus;
+#endif
+
+namespace Config {
+    constexpr int HUD_SIZE = 350;
+    constexpr int ANIM_FRAMES = 30;
+    constexpr int HOLD_FRAMES = 120;
+    constexpr int FADEOUT_FRAMES = 20;
+    constexpr int COLOR_FADE_FRAMES = 16;                    // Farbübergang bei Ladezustandswechsel
+    constexpr int TIMER_INTERVAL_MS = 16;                    // volle Rate; der FrameGovernor nimmt Vielfache davon
+    constexpr int GOVERNOR_WINDOW = 8;                       // gleitendes Mittel der Render-Zeit über so viele Frames
+    constexpr double FRAME_BUDGET_SHARE = 0.5;               // Anteil des Intervalls, den Render brauchen darf
+    constexpr double GOVERNOR_RECOVER_SHARE = 0.5;           // zurück erst, wenn die bessere Stufe mit Abstand passt
+    constexpr int RING_MARGIN = 60;
+    constexpr float RING_WIDTH = 10.0f;
+    constexpr float FONT_SIZE = 50.0f;
+    constexpr float SCALE_BUCKET_STEP = 0.25f;
+    constexpr int MAX_SCALE_BUCKETS = 3;
+    constexpr int MAX_THEME_OPS = 8;
+    constexpr bool SOFTWARE_RASTERIZER = true;
+    constexpr bool FADE_FROM_SNAPSHOT = true;
+    constexpr bool FADE_RESAMPLE = true;
+    constexpr bool CACHE_RING_GEOMETRY = true;
+    constexpr int RASTER_TILE_ROWS = 32;                     // Kacheln sind volle Zeilenstreifen
+    constexpr int RASTER_THREADS = 0;                        // 0 = Anzahl Kerne, höchstens MAX_RASTER_THREADS
+    constexpr int MAX_RASTER_THREADS = 8;
+    constexpr int PARALLEL_MIN_PIXELS = 600 * 600;           // darunter lohnt sich kein Verteilen
+    constexpr size_t FRAME_CACHE_BUDGET_BYTES = 32u * 1024u * 1024u;
+    constexpr int MINI_RING_SIZE = 72;                       // Mini-Ring in der Bildschirmecke, Basis-Pixel
+    constexpr int MINI_RING_MARGIN = 16;                     // Abstand zum Rand des Arbeitsbereichs
+    constexpr size_t MINI_RING_CACHE_BYTES = 2u * 1024u * 1024u;
+    constexpr int TRAY_ICON_SIZE = 16;                       // kleines Icon bei 96 DPI (SM_CXSMICON)
+    constexpr float FROST_RADIUS = 150.0f;                   // Milchglas-Scheibe hinter dem Ring, Basis-Pixel
+    constexpr int FROST_DOWNSAMPLE = 4;                      // Unschärfe auf 1/4 Kantenlänge (bei 1x)
+    constexpr int FROST_BLUR_RADIUS = 3;                     // Box-Radius; drei Durchgänge je Achse ~ Gauß
+    constexpr uint32_t FROST_TINT = 72;                      // Anteil der Tönung in 1/256
+    constexpr uint32_t FROST_TINT_RGB = 0x101820;
+    constexpr int SNAPSHOT_TOLERANCE = 2;                    // max. Abweichung pro Kanal gegen die Goldens
+    constexpr wchar_t WINDOW_CLASS[] = L"BatteryHUDClass";
+    constexpr wchar_t OUTPUT_WINDOW_CLASS[] = L"BatteryHUDOutputClass";
+    constexpr wchar_t CONFIG_FILE[] = L"\\BatteryHUD\\config.dat";
+    constexpr wchar_t THEME_FILE[] = L"\\BatteryHUD\\theme.ini";
+}
+
+struct AppSettings {
+    Color chargeColor = Color(255, 0, 230, 120);
+    Color dischargeColor = Color(255, 255, 150, 50);
+    bool useCustomChargeColor = false;
+    bool useCustomDischargeColor = false;
+    bool showOnUnplug = false;
+    bool playSound = false;
+    bool exportFrames = false;      // Frames per Shared Memory an Kiosk-Shell/Overlays (hudframes.h)
+    bool showMiniRing = false;      // dauerhafter kleiner Ring in der Ecke
+    bool frostedBackdrop = false;   // Milchglas: unscharfer Bildschirmausschnitt hinter dem HUD
+};
+
+// Kompiliertes Theme: flache Befehlsliste ohne Zeiger und Strings, pro Frame nur abgespielt.
+// Geometrie in Basis-Pixeln (HUD_SIZE); der Rasterizer multipliziert mit DPI- und Animationsskalierung.
+struct ThemeOp {
+    enum Kind : uint8_t { Glow, Arc, Text };
+
+    Kind kind = Glow;
+    bool stateColor = true;         // Farbe des Ladezustands statt rgb
+    bool fullSweep = false;         // Arc: voller Kreis statt Prozentwert, z.B. als Hintergrundspur
+    uint32_t rgb = 0;
+    float alpha = 1.0f;             // Faktor auf das Animations-Alpha
+    float radius = 0.0f;
+    float width = 0.0f;
+};
+
+struct ThemeProgram {
+    ThemeOp ops[Config::MAX_THEME_OPS];
+    int opCount = 0;
+    uint32_t chargeArgb = 0xFF00E678;
+    uint32_t chargeLowArgb = 0xFFFF3232;
+    uint32_t dischargeArgb = 0xFFFF9632;
+    int lowThreshold = 20;          // darunter gilt beim Laden chargeLowArgb
+    float fontSize = Config::FONT_SIZE;
+    wchar_t fontFamily[32] = L"Segoe UI";
+};
+
+static_assert(std::is_trivially_copyable<ThemeProgram>::value, "Theme wird als Ganzes kopiert");
+
+struct HUDState {
+    bool isVisible = false;
+    int animFrame = 0;
+    int holdFrame = 0;
+    bool isFadingOut = false;
+    BYTE batteryPercent = 0;
+    Color themeColor = Color(255, 0, 230, 120);
+    bool isCharging = false;
+    Color fromColor = Color(255, 0, 230, 120);
+    int colorFrame = Config::COLOR_FADE_FRAMES;     // darunter läuft ein Übergang von fromColor zu themeColor
+
+    bool isCrossfading() const { return colorFrame < Config::COLOR_FADE_FRAMES; }
+
+    void reset() {
+        isVisible = false;
+        animFrame = 0;
+        holdFrame = 0;
+        isFadingOut = false;
+        colorFrame = Config::COLOR_FADE_FRAMES;
+    }
+
+    static Color stateColor(BYTE percent, bool charging, const AppSettings& settings, const ThemeProgram& theme) {
+        if (charging) {
+            return settings.useCustomChargeColor
+                ? settings.chargeColor
+                : Color(percent < theme.lowThreshold ? theme.chargeLowArgb : theme.chargeArgb);
+        }
+        return settings.useCustomDischargeColor
+            ? settings.dischargeColor
+            : Color(theme.dischargeArgb);
+    }
+
+    void startAnimation(BYTE percent, bool charging, const AppSettings& settings, const ThemeProgram& theme) {
+        batteryPercent = (percent > 100) ? 100 : percent;
+        isCharging = charging;
+        themeColor = stateColor(batteryPercent, charging, settings, theme);
+        colorFrame = Config::COLOR_FADE_FRAMES;
+
+        isVisible = true;
+        isFadingOut = false;
+        animFrame = 0;
+        holdFrame = 0;
+    }
+
+    // Ladezustand wechselt, während das HUD sichtbar ist: Farbe überblenden, Hold-Phase neu beginnen.
+    // Rückgabe wie bei Tick().
+    int changeState(BYTE percent, bool charging, const AppSettings& settings, const ThemeProgram& theme) {
+        batteryPercent = (percent > 100) ? 100 : percent;
+        isCharging = charging;
+
+        const Color target = stateColor(batteryPercent, charging, settings, theme);
+        if (isCrossfading() && target.GetValue() == fromColor.GetValue()) {
+            // Umkehr mitten im Übergang: von der gerade sichtbaren Mischung zurück
+            fromColor = themeColor;
+            colorFrame = Config::COLOR_FADE_FRAMES - colorFrame;
+        }
+        else if (target.GetValue() != themeColor.GetValue()) {
+            fromColor = themeColor;
+            colorFrame = 0;
+        }
+        themeColor = target;
+
+        if (isFadingOut) {
+            isFadingOut = false;
+            holdFrame = 0;
+            animFrame = Config::ANIM_FRAMES;
+        }
+        if (animFrame < Config::ANIM_FRAMES || isCrossfading()) return 0;     // im Intro tickt der Übergang mit
+        return (Config::HOLD_FRAMES + 1) * Config::TIMER_INTERVAL_MS;
+    }
+
+    // Nur der Prozentwert ändert sich, während das HUD sichtbar ist: ohne Übergang, die Hold-Phase läuft weiter.
+    // false, wenn damit auch die Zustandsfarbe wechselt (Ladeschwelle); dann gilt changeState.
+    bool updatePercent(BYTE percent, const AppSettings& settings, const ThemeProgram& theme) {
+        const BYTE clamped = (percent > 100) ? 100 : percent;
+        if (stateColor(clamped, isCharging, settings, theme).GetValue() != themeColor.GetValue()) return false;
+        batteryPercent = clamped;
+        return true;
+    }
+
+    // Ein Timer-Tick über `frames` seit dem letzten Tick verstrichene Animationsframes (bei reduzierter Bildrate
+    // oder verspätetem Timer bleibt die Animation gleich lang, nur mit weniger Zwischenbildern).
+    // Rückgabe: Wartezeit in ms, wenn der nächste Tick nicht im Bildtakt kommt (Hold), 0 = im Bildtakt weiter,
+    // -1 = Animation vorbei
+    int Tick(int frames = 1) {
+        if (!isFadingOut) {
+            if (animFrame < Config::ANIM_FRAMES) {
+                if (isCrossfading()) colorFrame = std::min(colorFrame + frames, Config::COLOR_FADE_FRAMES);
+                // Hold-Phase ist statisch: ein Timer bis zum Fade statt HOLD_FRAMES identischer Ticks
+                animFrame = std::min(animFrame + frames, Config::ANIM_FRAMES);
+                if (animFrame == Config::ANIM_FRAMES && !isCrossfading()) return (Config::HOLD_FRAMES + 1) * Config::TIMER_INTERVAL_MS;
+                return 0;
+            }
+            if (isCrossfading()) {
+                // Die Hold-Phase beginnt erst nach dem Übergang
+                colorFrame = std::min(colorFrame + frames, Config::COLOR_FADE_FRAMES);
+                if (colorFrame == Config::COLOR_FADE_FRAMES) return (Config::HOLD_FRAMES + 1) * Config::TIMER_INTERVAL_MS;
+                return 0;
+            }
+            isFadingOut = true;
+            holdFrame = Config::FADEOUT_FRAMES;
+            return 0;
+        }
+        holdFrame -= frames;
+        if (holdFrame <= 0) {
+            reset();
+            return -1;
+        }
+        return 0;
+    }
+};
+
+// Vom FrameGovernor gewählt; Teil des Frame-Keys, weil sich das Bild ändert.
+enum class RenderQuality : uint8_t {
+    Full,           // Glow und Kantenglättung
+    NoGlow,         // ohne Glow-Ebenen (die einzige Ebene über die volle Kreisfläche)
+    Draft,          // zusätzlich ohne Kantenglättung (GDI+); der Software-Rasterizer rechnet Abdeckung ohnehin analytisch
+};
+
+// Zugleich der Frame-Key: gleiche Parameter ergeben ein identisches Bild.
+struct FrameParams {
+    float scale = 0.0f;
+    int alpha = 0;
+    BYTE percent = 0;
+    uint32_t themeArgb = 0;
+    float dpiScale = 1.0f;        // bereits auf einen Skalierungs-Bucket gerundet
+    uint32_t fromArgb = 0;
+    int colorMix = 256;           // Anteil von themeArgb gegenüber fromArgb in 1/256; 256 = kein Übergang
+    RenderQuality quality = RenderQuality::Full;
+
+    bool operator==(const FrameParams& other) const {
+        return scale == other.scale && alpha == other.alpha
+            && percent == other.percent && themeArgb == other.themeArgb
+            && dpiScale == other.dpiScale
+            && fromArgb == other.fromArgb && colorMix == other.colorMix
+            && quality == other.quality;
+    }
+    bool operator!=(const FrameParams& other) const { return !(*this == other); }
+};
+
+namespace Utils {
+    constexpr float EaseOutBack(float t) {
+        constexpr float c1 = 1.70158f;
+        constexpr float c3 = c1 + 1.0f;
+        const float t1 = t - 1.0f;
+        return 1.0f + c3 * t1 * t1 * t1 + c1 * t1 * t1;
+    }
+
+    template<typename T>
+    constexpr T Clamp(T value, T min, T max) {
+        return (value < min) ? min : (value > max) ? max : value;
+    }
+
+    constexpr float FadeInFirstHalf(float t) {
+        return (t > 0.5f) ? 1.0f : t * 2.0f;
+    }
+
+    constexpr float ShrinkTo90(float t) {
+        return 1.0f - (1.0f - t) * 0.1f;
+    }
+
+    constexpr float Linear(float t) {
+        return t;
+    }
+
+    // Monotone Zeit in Millisekunden, z.B. für die Render-Zeit pro Frame; Tests setzen eine simulierte Uhr ein
+    using MonotonicClock = double (*)();
+
+    inline double NowMs() {
+#if defined(_WIN32)
+        static const double msPerTick = [] {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            return 1000.0 / static_cast<double>(frequency.QuadPart);
+        }();
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return static_cast<double>(now.QuadPart) * msPerTick;
+#else
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    inline std::wstring Widen(const std::string& utf8) {
+#if defined(_WIN32)
+        if (utf8.empty()) return L"";
+        const int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+        std::wstring wide(static_cast<size_t>(std::max(length, 0)), L'\0');
+        if (length > 0) {
+            MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), &wide[0], length);
+        }
+        return wide;
+#else
+        // wchar_t ist hier UTF-32; ungültige Bytes werden übersprungen
+        std::wstring wide;
+        for (size_t i = 0; i < utf8.size();) {
+            const unsigned char lead = static_cast<unsigned char>(utf8[i]);
+            const int extra = (lead < 0x80) ? 0 : (lead >> 5) == 0x6 ? 1 : (lead >> 4) == 0xE ? 2 : (lead >> 3) == 0x1E ? 3 : -1;
+            if (extra < 0 || i + extra >= utf8.size()) {
+                ++i;
+                continue;
+            }
+            uint32_t code = extra == 0 ? lead : lead & (0x3F >> extra);
+            for (int k = 1; k <= extra; ++k) code = (code << 6) | (static_cast<unsigned char>(utf8[i + k]) & 0x3F);
+            wide += static_cast<wchar_t>(code);
+            i += extra + 1;
+        }
+        return wide;
+#endif
+    }
+}
+
+// Theme-Datei (%LOCALAPPDATA%\BatteryHUD\theme.ini), beim Start einmal zu einem ThemeProgram kompiliert.
+// Jede [glow]/[arc]/[text]-Sektion ist eine Ebene, gezeichnet in Dateireihenfolge:
+//
+//   [colors]                 charge / charge_low / discharge = RRGGBB, low_threshold = 20
+//   [glow]                   radius = 175, alpha = 0.25, color = state | RRGGBB
+//   [arc]                    radius = 115, width = 10, alpha = 1, color = state, sweep = percent | full
+//   [text]                   size = 50, font = Segoe UI, alpha = 1, color = FFFFFF
+//
+// Zeilen mit ; oder # am Anfang sind Kommentare. Höchstens eine Text-Ebene (ein Glyph-Atlas).
+namespace Theme {
+    inline ThemeOp DefaultOp(ThemeOp::Kind kind) {
+        ThemeOp op;
+        op.kind = kind;
+        switch (kind) {
+        case ThemeOp::Glow:
+            op.radius = Config::HUD_SIZE / 2.0f;
+            op.alpha = 0.25f;
+            break;
+        case ThemeOp::Arc:
+            op.radius = Config::HUD_SIZE / 2.0f - Config::RING_MARGIN;
+            op.width = Config::RING_WIDTH;
+            break;
+        case ThemeOp::Text:
+            op.stateColor = false;
+            op.rgb = 0x00FFFFFF;
+            break;
+        }
+        return op;
+    }
+
+    // Das bisherige, fest eingebaute Aussehen
+    inline ThemeProgram BuiltIn() {
+        ThemeProgram theme;
+        theme.ops[theme.opCount++] = DefaultOp(ThemeOp::Glow);
+        theme.ops[theme.opCount++] = DefaultOp(ThemeOp::Arc);
+        theme.ops[theme.opCount++] = DefaultOp(ThemeOp::Text);
+        return theme;
+    }
+
+    // Mini-Ring (Basisgröße MINI_RING_SIZE): Farben und Schrift des Popup-Themes, eigene Ebenen
+    inline ThemeProgram MiniRing(const ThemeProgram& popup) {
+        ThemeProgram theme = popup;
+        theme.opCount = 0;
+        theme.fontSize = 16.0f;
+
+        ThemeOp glow = DefaultOp(ThemeOp::Glow);
+        glow.radius = Config::MINI_RING_SIZE / 2.0f;
+        glow.alpha = 0.5f;
+        ThemeOp track = DefaultOp(ThemeOp::Arc);
+        track.stateColor = false;
+        track.rgb = 0x00FFFFFF;
+        track.alpha = 0.2f;
+        track.fullSweep = true;
+        track.radius = Config::MINI_RING_SIZE / 2.0f - 8.0f;
+        track.width = 5.0f;
+        ThemeOp arc = track;
+        arc.stateColor = true;
+        arc.alpha = 1.0f;
+        arc.fullSweep = false;
+
+        theme.ops[theme.opCount++] = glow;
+        theme.ops[theme.opCount++] = track;
+        theme.ops[theme.opCount++] = arc;
+        theme.ops[theme.opCount++] = DefaultOp(ThemeOp::Text);
+        return theme;
+    }
+
+    // Tray-Icon (Basisgröße TRAY_ICON_SIZE): nur Spur und Bogen, Ziffern wären bei 16 px nicht lesbar
+    inline ThemeProgram TrayIcon(const ThemeProgram& popup) {
+        ThemeProgram theme = popup;
+        theme.opCount = 0;
+
+        ThemeOp track = DefaultOp(ThemeOp::Arc);
+        track.stateColor = false;
+        track.rgb = 0x00808080;         // auf heller und dunkler Taskleiste sichtbar
+        track.alpha = 0.6f;
+        track.fullSweep = true;
+        track.radius = Config::TRAY_ICON_SIZE / 2.0f - 2.5f;
+        track.width = 3.0f;
+        ThemeOp arc = track;
+        arc.stateColor = true;
+        arc.alpha = 1.0f;
+        arc.fullSweep = false;
+
+        theme.ops[theme.opCount++] = track;
+        theme.ops[theme.opCount++] = arc;
+        return theme;
+    }
+
+    inline std::string Trim(const std::string& text) {
+        const size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return "";
+        const size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    inline bool ParseFloat(const std::string& value, float min, float max, float& out) {
+        char* end = nullptr;
+        const float parsed = std::strtof(value.c_str(), &end);
+        if (end == value.c_str() || *end != '\0' || !(parsed >= min && parsed <= max)) return false;
+        out = parsed;
+        return true;
+    }
+
+    // RRGGBB oder AARRGGBB, optional mit #
+    inline bool ParseColor(const std::string& value, uint32_t& out) {
+        const std::string hex = (!value.empty() && value[0] == '#') ? value.substr(1) : value;
+        if (hex.size() != 6 && hex.size() != 8) return false;
+        if (hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) return false;
+        const uint32_t parsed = static_cast<uint32_t>(std::strtoul(hex.c_str(), nullptr, 16));
+        out = (hex.size() == 6) ? (0xFF000000u | parsed) : parsed;
+        return true;
+    }
+
+    inline bool ParseLayerColor(const std::string& value, ThemeOp& op) {
+        if (value == "state") {
+            op.stateColor = true;
+            return true;
+        }
+        uint32_t argb;
+        if (!ParseColor(value, argb)) return false;
+        op.stateColor = false;
+        op.rgb = argb & 0x00FFFFFF;
+        return true;
+    }
+
+    inline bool SetColorsKey(ThemeProgram& theme, const std::string& key, const std::string& value) {
+        float threshold;
+        if (key == "charge") return ParseColor(value, theme.chargeArgb);
+        if (key == "charge_low") return ParseColor(value, theme.chargeLowArgb);
+        if (key == "discharge") return ParseColor(value, theme.dischargeArgb);
+        if (key == "low_threshold" && ParseFloat(value, 0.0f, 101.0f, threshold)) {
+            theme.lowThreshold = static_cast<int>(threshold);
+            return true;
+        }
+        return false;
+    }
+
+    inline bool SetLayerKey(ThemeProgram& theme, ThemeOp& op, const std::string& key, const std::string& value) {
+        const float maxRadius = Config::HUD_SIZE / 2.0f;
+        if (key == "color") return ParseLayerColor(value, op);
+        if (key == "alpha") return ParseFloat(value, 0.0f, 1.0f, op.alpha);
+
+        switch (op.kind) {
+        case ThemeOp::Glow:
+            return key == "radius" && ParseFloat(value, 1.0f, maxRadius, op.radius);
+        case ThemeOp::Arc:
+            if (key == "radius") return ParseFloat(value, 1.0f, maxRadius, op.radius);
+            if (key == "width") return ParseFloat(value, 0.5f, maxRadius, op.width);
+            if (key == "sweep" && (value == "percent" || value == "full")) {
+                op.fullSweep = (value == "full");
+                return true;
+            }
+            return false;
+        case ThemeOp::Text:
+            if (key == "size") return ParseFloat(value, 8.0f, 150.0f, theme.fontSize);
+            if (key == "font") {
+                const std::wstring family = Utils::Widen(value);
+                if (family.empty() || family.size() >= sizeof(theme.fontFamily) / sizeof(wchar_t)) return false;
+                std::copy(family.begin(), family.end(), theme.fontFamily);
+                theme.fontFamily[family.size()] = L'\0';
+                return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    // Bei Fehlern bleibt out unverändert; error nennt die Zeile
+    inline bool Compile(const std::string& source, ThemeProgram& out, std::string& error) {
+        ThemeProgram theme;
+        ThemeOp* op = nullptr;
+        bool inColors = false;
+        bool hasText = false;
+        int lineNumber = 0;
+
+        size_t pos = 0;
+        while (pos < source.size()) {
+            size_t end = source.find('\n', pos);
+            if (end == std::string::npos) end = source.size();
+            const std::string line = Trim(source.substr(pos, end - pos));
+            pos = end + 1;
+            lineNumber++;
+
+            if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+            const std::string where = "Zeile " + std::to_string(lineNumber) + ": ";
+
+            if (line.front() == '[' && line.back() == ']') {
+                const std::string section = Trim(line.substr(1, line.size() - 2));
+                inColors = (section == "colors");
+                op = nullptr;
+                if (inColors) continue;
+
+                ThemeOp::Kind kind;
+                if (section == "glow") kind = ThemeOp::Glow;
+                else if (section == "arc") kind = ThemeOp::Arc;
+                else if (section == "text") kind = ThemeOp::Text;
+                else {
+                    error = where + "unbekannte Sektion [" + section + "]";
+                    return false;
+                }
+
+                if (theme.opCount >= Config::MAX_THEME_OPS) {
+                    error = where + "mehr als " + std::to_string(Config::MAX_THEME_OPS) + " Ebenen";
+                    return false;
+                }
+                if (kind == ThemeOp::Text && hasText) {
+                    error = where + "nur eine [text]-Ebene erlaubt";
+                    return false;
+                }
+                hasText = hasText || kind == ThemeOp::Text;
+                op = &theme.ops[theme.opCount++];
+                *op = DefaultOp(kind);
+                continue;
+            }
+
+            const size_t equals = line.find('=');
+            if (equals == std::string::npos) {
+                error = where + "erwartet Schlüssel = Wert";
+                return false;
+            }
+            const std::string key = Trim(line.substr(0, equals));
+            const std::string value = Trim(line.substr(equals + 1));
+
+            const bool ok = inColors ? SetColorsKey(theme, key, value)
+                : op ? SetLayerKey(theme, *op, key, value)
+                : false;
+            if (!ok) {
+                error = where + "ungültig: " + line;
+                return false;
+            }
+        }
+
+        // Nur [colors]: eingebaute Ebenen mit eigenen Farben
+        if (theme.opCount == 0) {
+            const ThemeProgram builtIn = BuiltIn();
+            std::copy(builtIn.ops, builtIn.ops + builtIn.opCount, theme.ops);
+            theme.opCount = builtIn.opCount;
+        }
+        out = theme;
+        return true;
+    }
+}
+
+// Animationskurven als Tabellen, zur Compile-Zeit aus Easing-Funktionen gebacken.
+// Neue Phasen: Curve<Skalierung, Alpha> + Table<Frames, Curve>.
+namespace Timeline {
+    struct Keyframe {
+        float scale = 0.0f;
+        int alpha = 0;
+    };
+
+    constexpr int ToAlpha(float alphaFactor) {
+        return Utils::Clamp(static_cast<int>(255 * alphaFactor), 0, 255);
+    }
+
+    template<float (*ScaleEase)(float), float (*AlphaEase)(float)>
+    struct Curve {
+        static constexpr Keyframe Evaluate(float t) {
+            Keyframe k;
+            k.scale = ScaleEase(t);
+            k.alpha = ToAlpha(AlphaEase(t));
+            return k;
+        }
+    };
+
+    // Frames + 1 Einträge, t = frame / Frames
+    template<int Frames, typename CurveT>
+    struct Table {
+        static constexpr int FRAMES = Frames;
+        Keyframe frames[Frames + 1];
+
+        constexpr Table() : frames() {
+            for (int i = 0; i <= Frames; ++i) {
+                frames[i] = CurveT::Evaluate(Utils::Clamp(static_cast<float>(i) / Frames, 0.0f, 1.0f));
+            }
+        }
+
+        constexpr const Keyframe& operator[](int frame) const {
+            return frames[Utils::Clamp(frame, 0, Frames)];
+        }
+    };
+
+    using IntroCurve = Curve<Utils::EaseOutBack, Utils::FadeInFirstHalf>;
+    using FadeCurve = Curve<Utils::ShrinkTo90, Utils::Linear>;   // t = holdFrame / FADEOUT_FRAMES, zählt rückwärts
+
+    constexpr Table<Config::ANIM_FRAMES, IntroCurve> INTRO;
+    constexpr Table<Config::FADEOUT_FRAMES, FadeCurve> FADE;
+
+    // Prüft die Tabellen gegen die frühere Laufzeitberechnung aus HUDRenderer::Render.
+    constexpr bool MatchesRuntimeMath() {
+        for (int frame = 0; frame <= Config::ANIM_FRAMES; ++frame) {
+            const float progress = Utils::Clamp(static_cast<float>(frame) / Config::ANIM_FRAMES, 0.0f, 1.0f);
+            const float c1 = 1.70158f;
+            const float c3 = c1 + 1.0f;
+            const float t1 = progress - 1.0f;
+            const float scale = 1.0f + c3 * t1 * t1 * t1 + c1 * t1 * t1;
+            const float alphaFactor = (progress > 0.5f) ? 1.0f : progress * 2.0f;
+            if (INTRO[frame].scale != scale) return false;
+            if (INTRO[frame].alpha != Utils::Clamp(static_cast<int>(255 * alphaFactor), 0, 255)) return false;
+        }
+        for (int holdFrame = 0; holdFrame <= Config::FADEOUT_FRAMES; ++holdFrame) {
+            const float fadeProgress = static_cast<float>(holdFrame) / Config::FADEOUT_FRAMES;
+            const float scale = 1.0f - (1.0f - fadeProgress) * 0.1f;
+            if (FADE[holdFrame].scale != scale) return false;
+            if (FADE[holdFrame].alpha != Utils::Clamp(static_cast<int>(255 * fadeProgress), 0, 255)) return false;
+        }
+        return true;
+    }
+
+    static_assert(MatchesRuntimeMath(), "Timeline-Tabellen weichen von der Laufzeitberechnung ab");
+    static_assert(INTRO[0].alpha == 0, "Intro beginnt unsichtbar");
+    static_assert(INTRO[Config::ANIM_FRAMES].scale == 1.0f && INTRO[Config::ANIM_FRAMES].alpha == 255, "Intro endet bei voller Größe");
+    static_assert(FADE[Config::FADEOUT_FRAMES].scale == 1.0f && FADE[0].alpha == 0, "Fade läuft von voll nach unsichtbar");
+
+    // Fortlaufender Index über alle Phasen: Intro 0..ANIM_FRAMES (Hold = letzter Intro-Frame), danach Fade.
+    constexpr int FrameIndex(const HUDState& state) {
+        return state.isFadingOut
+            ? Config::ANIM_FRAMES + 1 + Utils::Clamp(state.holdFrame, 0, Config::FADEOUT_FRAMES)
+            : Utils::Clamp(state.animFrame, 0, Config::ANIM_FRAMES);
+    }
+
+    inline FrameParams ComputeFrameParams(const HUDState& state) {
+        const Keyframe& k = state.isFadingOut ? FADE[state.holdFrame] : INTRO[state.animFrame];
+
+        FrameParams params;
+        params.scale = k.scale;
+        params.alpha = k.alpha;
+        params.percent = state.batteryPercent;
+        params.themeArgb = state.themeColor.GetValue();
+        if (state.isCrossfading()) {
+            params.fromArgb = state.fromColor.GetValue();
+            params.colorMix = state.colorFrame * 256 / Config::COLOR_FADE_FRAMES;
+        }
+        return params;
+    }
+}
+
+// Alle Maße des HUD für einen Skalierungsfaktor (1.0 = 96 DPI), in ganzen Bucket-Schritten; baseSize ist die
+// Kantenlänge bei 96 DPI (Popup oder Mini-Ring).
+struct HudMetrics {
+    float scale = 1.0f;
+    int size = Config::HUD_SIZE;
+    float center = Config::HUD_SIZE / 2.0f;
+
+    static float BucketScale(float dpiScale) {
+        const float steps = std::floor(dpiScale / Config::SCALE_BUCKET_STEP + 0.5f);
+        return Utils::Clamp(steps, 4.0f, 16.0f) * Config::SCALE_BUCKET_STEP;
+    }
+
+    static int BucketId(float bucketScale) {
+        return static_cast<int>(bucketScale / Config::SCALE_BUCKET_STEP + 0.5f);
+    }
+
+    static HudMetrics ForScale(float dpiScale, int baseSize = Config::HUD_SIZE) {
+        HudMetrics m;
+        m.scale = BucketScale(dpiScale);
+        m.size = static_cast<int>(baseSize * m.scale + 0.5f);
+        m.center = m.size / 2.0f;
+        return m;
+    }
+};
+
+// Wenige Ebenen-Caches (Glow, Glyphen, Ring) je Skalierungs-Bucket; der am längsten unbenutzte fliegt raus.
+template<typename Layers>
+class ScaleBuckets {
+public:
+    struct Stats {
+        unsigned created = 0;
+        unsigned evictions = 0;
+    };
+
+    explicit ScaleBuckets(int baseSize = Config::HUD_SIZE) : baseSize(baseSize) {}
+
+    Layers& Get(float bucketScale) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].scale == bucketScale) {
+                if (i != 0) std::rotate(slots.begin(), slots.begin() + i, slots.begin() + i + 1);
+                return *slots.front().layers;
+            }
+        }
+
+        if (static_cast<int>(slots.size()) >= Config::MAX_SCALE_BUCKETS) {
+            slots.pop_back();
+            stats.evictions++;
+        }
+        Slot slot;
+        slot.scale = bucketScale;
+        slot.layers = std::make_unique<Layers>(HudMetrics::ForScale(bucketScale, baseSize));
+        slots.insert(slots.begin(), std::move(slot));
+        stats.created++;
+        return *slots.front().layers;
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+    void Clear() { slots.clear(); }
+
+    template<typename Fn>
+    void ForEach(Fn fn) const {
+        for (const Slot& slot : slots) fn(*slot.layers);
+    }
+
+private:
+    struct Slot {
+        float scale = 0.0f;
+        std::unique_ptr<Layers> layers;
+    };
+
+    int baseSize;
+    std::vector<Slot> slots;    // vorne = zuletzt benutzt
+    Stats stats;
+};
+
+struct Surface {
+    uint32_t* pixels = nullptr;   // premultiplied ARGB, top-down
+    int width = 0;
+    int height = 0;
+    int stride = 0;               // in Pixeln
+
+    uint32_t* Row(int y) const { return pixels + static_cast<size_t>(y) * stride; }
+    bool IsValid() const { return pixels != nullptr && width > 0 && height > 0; }
+};
+
+// Halboffenes Pixelrechteck [x0, x1) x [y0, y1), z. B. eine Kachel; Koordinaten bleiben absolut.
+struct PixelRect {
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = 0;
+    int y1 = 0;
+
+    bool IsEmpty() const { return x1 <= x0 || y1 <= y0; }
+
+    static PixelRect Of(const Surface& surface) {
+        PixelRect rect;
+        rect.x1 = surface.width;
+        rect.y1 = surface.height;
+        return rect;
+    }
+
+    // Umschließendes Rechteck; leere Rechtecke zählen nicht
+    static PixelRect Hull(const PixelRect& a, const PixelRect& b) {
+        if (a.IsEmpty()) return b;
+        if (b.IsEmpty()) return a;
+        PixelRect hull;
+        hull.x0 = std::min(a.x0, b.x0);
+        hull.y0 = std::min(a.y0, b.y0);
+        hull.x1 = std::max(a.x1, b.x1);
+        hull.y1 = std::max(a.y1, b.y1);
+        return hull;
+    }
+
+    size_t Area() const { return IsEmpty() ? 0 : static_cast<size_t>(x1 - x0) * (y1 - y0); }
+};
+
+// Sparse Frame: pro Zeile das Intervall [x0, x1), außerhalb dessen die Pixel 0 sind. Vorberechnet aus dem Kreis,
+// in dem gezeichnet wird, danach an der tatsächlichen Deckung zugeschnitten. Wer in eine Fläche schreibt, pflegt
+// ihre Spans; Löschen, Alpha-Pässe, Caches und das Hochladen berühren nur, was darin liegt.
+class FrameSpans {
+public:
+    struct Span {
+        uint16_t x0 = 0;
+        uint16_t x1 = 0;
+
+        bool IsEmpty() const { return x1 <= x0; }
+        int Count() const { return IsEmpty() ? 0 : x1 - x0; }
+    };
+
+    int Width() const { return width; }
+    int Height() const { return static_cast<int>(rows.size()); }
+    bool Fits(const Surface& surface) const { return surface.width == width && surface.height == Height(); }
+    const Span& Row(int y) const { return rows[y]; }
+
+    // Alles transparent
+    void Reset(int w, int h) {
+        width = w;
+        rows.assign(h, Span());
+    }
+
+    // Volle Zeilen, wenn über den Inhalt nichts bekannt ist
+    void Fill(int w, int h) {
+        Span full;
+        full.x1 = static_cast<uint16_t>(w);
+        width = w;
+        rows.assign(h, full);
+    }
+
+    // Alle Pixel, deren Fläche den Kreis berührt
+    void Circle(int w, int h, float cx, float cy, float radius) {
+        Reset(w, h);
+        for (int y = 0; y < h; ++y) {
+            const float dy = std::max(std::fabs(y + 0.5f - cy) - 0.5f, 0.0f);
+            if (dy >= radius) continue;
+            const float half = std::sqrt(radius * radius - dy * dy);
+            rows[y].x0 = static_cast<uint16_t>(Utils::Clamp(static_cast<int>(std::floor(cx - half)), 0, w));
+            rows[y].x1 = static_cast<uint16_t>(Utils::Clamp(static_cast<int>(std::ceil(cx + half)), 0, w));
+        }
+    }
+
+    // Transparente Ränder jeder Zeile abschneiden; liest nur innerhalb der bisherigen Spans
+    void Trim(const Surface& surface) {
+        for (int y = 0; y < Height(); ++y) {
+            Span& span = rows[y];
+            const uint32_t* row = surface.Row(y);
+            int x0 = span.x0, x1 = span.x1;
+            while (x0 < x1 && row[x0] == 0) ++x0;
+            while (x1 > x0 && row[x1 - 1] == 0) --x1;
+            span.x0 = static_cast<uint16_t>(x0 < x1 ? x0 : 0);
+            span.x1 = static_cast<uint16_t>(x0 < x1 ? x1 : 0);
+        }
+    }
+
+    // Pro Zeile die Hülle beider Spans
+    void Unite(const FrameSpans& other) {
+        for (int y = 0; y < Height() && y < other.Height(); ++y) {
+            rows[y] = Hull(rows[y], other.rows[y]);
+        }
+    }
+
+    // Fläche auf `next` umstellen: Pixel dieser Spans außerhalb von next werden 0, danach gilt next.
+    // Der Aufrufer beschreibt anschließend die Spans von next.
+    void Adopt(const Surface& surface, const FrameSpans& next) {
+        for (int y = 0; y < Height(); ++y) {
+            const Span old = rows[y];
+            const Span now = next.rows[y];
+            uint32_t* row = surface.Row(y);
+            if (now.IsEmpty()) {
+                ClearRange(row, old.x0, old.x1);
+                continue;
+            }
+            ClearRange(row, old.x0, std::min(old.x1, now.x0));
+            ClearRange(row, std::max(old.x0, now.x1), old.x1);
+        }
+        rows = next.rows;
+        width = next.width;
+    }
+
+    // Rechteck, in das gerade gezeichnet wurde, in die Spans aufnehmen
+    void Cover(const PixelRect& rect) {
+        Span span;
+        span.x0 = static_cast<uint16_t>(rect.x0);
+        span.x1 = static_cast<uint16_t>(rect.x1);
+        for (int y = std::max(rect.y0, 0); y < std::min(rect.y1, Height()); ++y) {
+            rows[y] = Hull(rows[y], span);
+        }
+    }
+
+    // Nur die Spans löschen; danach ist die Fläche ganz leer
+    void ClearSurface(const Surface& surface) {
+        for (int y = 0; y < Height(); ++y) {
+            ClearRange(surface.Row(y), rows[y].x0, rows[y].x1);
+            rows[y] = Span();
+        }
+    }
+
+    size_t Pixels() const {
+        size_t count = 0;
+        for (const Span& span : rows) count += span.Count();
+        return count;
+    }
+
+    size_t Bytes() const { return rows.size() * sizeof(Span); }
+
+    // Umschließendes Rechteck, leer wenn der Frame ganz transparent ist
+    PixelRect Bounds() const {
+        PixelRect rect;
+        rect.x0 = width;
+        rect.y0 = Height();
+        for (int y = 0; y < Height(); ++y) {
+            if (rows[y].IsEmpty()) continue;
+            rect.x0 = std::min(rect.x0, static_cast<int>(rows[y].x0));
+            rect.x1 = std::max(rect.x1, static_cast<int>(rows[y].x1));
+            rect.y0 = std::min(rect.y0, y);
+            rect.y1 = y + 1;
+        }
+        return rect.IsEmpty() ? PixelRect() : rect;
+    }
+
+    void SetRow(int y, Span span) { rows[y] = span; }
+
+    static Span Hull(Span a, Span b) {
+        if (a.IsEmpty()) return b;
+        if (b.IsEmpty()) return a;
+        Span hull;
+        hull.x0 = std::min(a.x0, b.x0);
+        hull.x1 = std::max(a.x1, b.x1);
+        return hull;
+    }
+
+private:
+    static void ClearRange(uint32_t* row, int x0, int x1) {
+        if (x1 > x0) std::memset(row + x0, 0, static_cast<size_t>(x1 - x0) * sizeof(uint32_t));
+    }
+
+    std::vector<Span> rows;
+    int width = 0;
+};
+
+struct RenderTargetStats {
+    unsigned surfaceAllocations = 0;
+    unsigned surfaceReleases = 0;
+    unsigned framesBegun = 0;
+};
+
+// Eine Zeichenfläche pro Animation: Acquire beim Start, BeginFrame pro Tick, Release beim Reset.
+class IRenderTarget {
+public:
+    virtual ~IRenderTarget() = default;
+
+    virtual bool Acquire(int width, int height) = 0;
+    virtual void Release() = 0;
+    virtual bool IsAcquired() const = 0;
+    virtual Surface GetSurface() const = 0;
+
+    // Nur GDI-Backends haben Graphics/DC; headless bleiben sie leer
+    virtual Graphics* Context() const { return nullptr; }
+    virtual HDC MemoryDC() const { return nullptr; }
+    virtual void Flush() const {}
+
+    // Außerhalb der Spans des letzten Frames ist die Fläche schon leer
+    Surface BeginFrame() {
+        Surface surface = GetSurface();
+        if (surface.IsValid()) {
+            Content().ClearSurface(surface);
+            stats.framesBegun++;
+        }
+        return surface;
+    }
+
+    // Wo die Fläche gerade Inhalt hat; nach einem Acquire unbekannt, also volle Zeilen
+    FrameSpans& Content() {
+        const Surface surface = GetSurface();
+        if (!content.Fits(surface)) content.Fill(surface.width, surface.height);
+        return content;
+    }
+
+    const RenderTargetStats& Stats() const { return stats; }
+    void ResetStats() { stats = RenderTargetStats(); }
+
+protected:
+    RenderTargetStats stats;
+    FrameSpans content;
+};
+
+using RenderTargetFactory = std::unique_ptr<IRenderTarget> (*)();
+
+// Headless-Backend ohne GDI, z.B. für Messungen unter Linux.
+class MemoryRenderTarget : public IRenderTarget {
+public:
+    static std::unique_ptr<IRenderTarget> Create() { return std::make_unique<MemoryRenderTarget>(); }
+
+    bool Acquire(int width, int height) override {
+        if (IsAcquired() && surface.width == width && surface.height == height) return true;
+        Release();
+
+        buffer.assign(static_cast<size_t>(width) * height, 0);
+        surface.pixels = buffer.data();
+        surface.width = width;
+        surface.height = height;
+        surface.stride = width;
+        stats.surfaceAllocations++;
+        return true;
+    }
+
+    void Release() override {
+        if (!IsAcquired()) return;
+        std::vector<uint32_t>().swap(buffer);
+        surface = Surface();
+        stats.surfaceReleases++;
+    }
+
+    bool IsAcquired() const override { return surface.pixels != nullptr; }
+    Surface GetSurface() const override { return surface; }
+
+private:
+    std::vector<uint32_t> buffer;
+    Surface surface;
+};
+
+// Radialer Glow (PathGradientBrush-Nachbau): Mitte themeColor mit Alpha 255/4, Rand transparent.
+// Wird pro Themenfarbe einmal vorgerendert, pro Frame nur noch mit Alpha/Skalierung komponiert.
+class GlowCache {
+public:
+    struct Stats {
+        unsigned builds = 0;
+        unsigned hits = 0;
+    };
+
+    static void Rasterize(const Surface& dst, uint32_t themeArgb, int alpha) {
+        const float radius = dst.width * 0.5f;
+        const float centerAlpha = static_cast<float>(alpha / 4);
+        const float r = static_cast<float>((themeArgb >> 16) & 0xFF);
+        const float g = static_cast<float>((themeArgb >> 8) & 0xFF);
+        const float b = static_cast<float>(themeArgb & 0xFF);
+
+        for (int y = 0; y < dst.height; ++y) {
+            uint32_t* row = dst.Row(y);
+            const float dy = (y + 0.5f - radius) / radius;
+
+            for (int x = 0; x < dst.width; ++x) {
+                const float dx = (x + 0.5f - radius) / radius;
+                const float t = 1.0f - std::sqrt(dx * dx + dy * dy);
+                if (t <= 0.0f) {
+                    row[x] = 0;
+                    continue;
+                }
+
+                // GDI+ interpoliert nicht-vormultipliziert: Farbe und Alpha fallen beide linear ab
+                const float a = centerAlpha * t;
+                const float k = t * a / 255.0f;
+                row[x] = (static_cast<uint32_t>(a + 0.5f) << 24)
+                    | (static_cast<uint32_t>(r * k + 0.5f) << 16)
+                    | (static_cast<uint32_t>(g * k + 0.5f) << 8)
+                    | static_cast<uint32_t>(b * k + 0.5f);
+            }
+        }
+    }
+
+    const Surface& Get(uint32_t themeArgb, int size) {
+        themeArgb |= 0xFF000000u;
+        if (surface.IsValid() && themeArgb == color && surface.width == size) {
+            stats.hits++;
+            return surface;
+        }
+
+        pixels.assign(static_cast<size_t>(size) * size, 0);
+        surface.pixels = pixels.data();
+        surface.width = size;
+        surface.height = size;
+        surface.stride = size;
+        color = themeArgb;
+
+        Rasterize(surface, themeArgb, 255);
+        stats.builds++;
+        generation++;
+        return surface;
+    }
+
+    unsigned Generation() const { return generation; }
+    const Stats& GetStats() const { return stats; }
+
+private:
+    std::vector<uint32_t> pixels;
+    Surface surface;
+    uint32_t color = 0;
+    unsigned generation = 0;
+    Stats stats;
+};
+
+struct GlyphBitmap {
+    int width = 0;
+    int height = 0;
+    int offsetX = 0;              // Abstand vom Stift zur linken Kante
+    int offsetY = 0;              // Abstand von der Zeilenoberkante
+    float advance = 0.0f;
+    std::vector<uint8_t> coverage;
+};
+
+// Liefert Glyphen für den Atlas (GDI+-Font unter Windows, Bitmap-Font headless).
+class IGlyphSource {
+public:
+    virtual ~IGlyphSource() = default;
+    virtual bool RasterizeGlyph(wchar_t ch, GlyphBitmap& out) = 0;
+    virtual int LineHeight() const = 0;
+};
+
+using GlyphSourceFactory = std::unique_ptr<IGlyphSource> (*)(float fontSize, const wchar_t* fontFamily);
+
+// Eingebauter 5x7-Pixelfont für 0-9 und %, ganzzahlig skaliert.
+class BitmapFontGlyphSource : public IGlyphSource {
+public:
+    explicit BitmapFontGlyphSource(int pixelScale = 6) : pixelScale(pixelScale) {}
+
+    // 6 Pixel pro Font-Pixel entsprechen der 50px-Schrift.
+    static std::unique_ptr<IGlyphSource> Create(float fontSize, const wchar_t*) {
+        const int pixelScale = static_cast<int>(fontSize * 6.0f / Config::FONT_SIZE + 0.5f);
+        return std::make_unique<BitmapFontGlyphSource>(pixelScale < 1 ? 1 : pixelScale);
+    }
+
+    bool RasterizeGlyph(wchar_t ch, GlyphBitmap& out) override {
+        static const uint8_t rows[11][7] = {
+            { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },   // 0
+            { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },   // 1
+            { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },   // 2
+            { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },   // 3
+            { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },   // 4
+            { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },   // 5
+            { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },   // 6
+            { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // 7
+            { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },   // 8
+            { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },   // 9
+            { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }    // %
+        };
+
+        int index;
+        if (ch >= L'0' && ch <= L'9') index = ch - L'0';
+        else if (ch == L'%') index = 10;
+        else return false;
+
+        out.width = 5 * pixelScale;
+        out.height = 7 * pixelScale;
+        out.offsetX = 0;
+        out.offsetY = pixelScale;
+        out.advance = 6.0f * pixelScale;
+        out.coverage.assign(static_cast<size_t>(out.width) * out.height, 0);
+
+        for (int y = 0; y < out.height; ++y) {
+            const uint8_t bits = rows[index][y / pixelScale];
+            for (int x = 0; x < out.width; ++x) {
+                if (bits & (0x10 >> (x / pixelScale))) {
+                    out.coverage[static_cast<size_t>(y) * out.width + x] = 255;
+                }
+            }
+        }
+        return true;
+    }
+
+    int LineHeight() const override { return 9 * pixelScale; }
+
+private:
+    int pixelScale;
+};
+
+// Vorgerasterte Glyphen für "0".."100" und "%": Layout über feste Vorschübe, Zeichnen per Alpha-Blit.
+class GlyphAtlas {
+public:
+    static constexpr int GLYPH_COUNT = 11;
+    static constexpr int MAX_LAYOUT = 4;   // "100%"
+
+    struct Entry {
+        int atlasX = 0;
+        int width = 0;
+        int height = 0;
+        int offsetX = 0;
+        int offsetY = 0;
+        float advance = 0.0f;
+    };
+
+    struct PlacedGlyph {
+        const Entry* entry;
+        float x;
+    };
+
+    bool Build(IGlyphSource& source) {
+        static const wchar_t chars[GLYPH_COUNT + 1] = L"0123456789%";
+        GlyphBitmap glyphs[GLYPH_COUNT];
+        int totalWidth = 0, maxHeight = 0;
+
+        for (int i = 0; i < GLYPH_COUNT; ++i) {
+            if (!source.RasterizeGlyph(chars[i], glyphs[i])) return false;
+            totalWidth += glyphs[i].width;
+            if (glyphs[i].height > maxHeight) maxHeight = glyphs[i].height;
+        }
+
+        atlasWidth = totalWidth;
+        atlasHeight = maxHeight;
+        coverage.assign(static_cast<size_t>(atlasWidth) * atlasHeight, 0);
+
+        int x = 0;
+        for (int i = 0; i < GLYPH_COUNT; ++i) {
+            const GlyphBitmap& g = glyphs[i];
+            Entry& e = entries[i];
+            e.atlasX = x;
+            e.width = g.width;
+            e.height = g.height;
+            e.offsetX = g.offsetX;
+            e.offsetY = g.offsetY;
+            e.advance = g.advance;
+
+            for (int row = 0; row < g.height; ++row) {
+                std::memcpy(&coverage[static_cast<size_t>(row) * atlasWidth + x],
+                    &g.coverage[static_cast<size_t>(row) * g.width], g.width);
+            }
+            x += g.width;
+        }
+
+        lineHeight = source.LineHeight();
+        built = true;
+        return true;
+    }
+
+    bool IsBuilt() const { return built; }
+    int Width() const { return atlasWidth; }
+    int Height() const { return atlasHeight; }
+    int LineHeight() const { return lineHeight; }
+    const uint8_t* Coverage() const { return coverage.data(); }
+
+    // Ohne Heap: Ziffern rückwärts, danach "%". Rückgabe: Anzahl Glyphen, totalWidth = Summe der Vorschübe.
+    int Layout(BYTE percent, PlacedGlyph (&out)[MAX_LAYOUT], float& totalWidth) const {
+        int digits[3];
+        int count = 0;
+        int value = (percent > 100) ? 100 : percent;
+        do {
+            digits[count++] = value % 10;
+            value /= 10;
+        } while (value > 0);
+
+        float pen = 0.0f;
+        int n = 0;
+        for (int i = count - 1; i >= 0; --i) {
+            out[n++] = { &entries[digits[i]], pen };
+            pen += entries[digits[i]].advance;
+        }
+        out[n++] = { &entries[10], pen };
+        pen += entries[10].advance;
+
+        totalWidth = pen;
+        return n;
+    }
+
+    // Software-Blit (Maßstab 1) für das Headless-Backend: weiß * Abdeckung * alpha, Source-Over.
+    void Draw(const Surface& dst, BYTE percent, float centerX, float centerY, int alpha) const {
+        if (!built || alpha <= 0) return;
+
+        PlacedGlyph placed[MAX_LAYOUT];
+        float totalWidth;
+        const int n = Layout(percent, placed, totalWidth);
+
+        const int originX = static_cast<int>(centerX - totalWidth * 0.5f + 0.5f);
+        const int originY = static_cast<int>(centerY - lineHeight * 0.5f + 0.5f);
+
+        for (int i = 0; i < n; ++i) {
+            const Entry& e = *placed[i].entry;
+            const int gx = originX + static_cast<int>(placed[i].x + 0.5f) + e.offsetX;
+            const int gy = originY + e.offsetY;
+
+            for (int y = 0; y < e.height; ++y) {
+                const int dy = gy + y;
+                if (dy < 0 || dy >= dst.height) continue;
+                uint32_t* row = dst.Row(dy);
+                const uint8_t* src = &coverage[static_cast<size_t>(y) * atlasWidth + e.atlasX];
+
+                for (int x = 0; x < e.width; ++x) {
+                    const int dx = gx + x;
+                    if (dx < 0 || dx >= dst.width || src[x] == 0) continue;
+
+                    const uint32_t a = (src[x] * static_cast<uint32_t>(alpha) + 127) / 255;
+                    const uint32_t inv = 255 - a;
+                    const uint32_t d = row[dx];
+                    const uint32_t oa = a + (((d >> 24) & 0xFF) * inv + 127) / 255;
+                    const uint32_t orr = a + (((d >> 16) & 0xFF) * inv + 127) / 255;
+                    const uint32_t og = a + (((d >> 8) & 0xFF) * inv + 127) / 255;
+                    const uint32_t ob = a + ((d & 0xFF) * inv + 127) / 255;
+                    row[dx] = (oa << 24) | (orr << 16) | (og << 8) | ob;
+                }
+            }
+        }
+    }
+
+private:
+    Entry entries[GLYPH_COUNT];
+    std::vector<uint8_t> coverage;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    int lineHeight = 0;
+    bool built = false;
+};
+
+// Software-Rasterizer: alle Primitive arbeiten auf vormultipliziertem ARGB, zeilenweise mit
+// Abdeckungs-Puffer; die heißen Span-Kernel gibt es skalar, SSE2, AVX2 und AVX-512, gewählt zur Laufzeit.
+namespace Raster {
+    // Befehlssatzstufen der Span-Kernel; jede Stufe setzt die darunter voraus
+    enum class SimdLevel : uint8_t { Scalar, SSE2, AVX2, AVX512 };
+
+    struct ArcGeometry;
+
+    // Eine Tabelle pro Stufe, alle rechnen bitgleich. Radial und Bogen nehmen [begin, end) statt count,
+    // damit die Vektorpfade ihren Rest an die nächste Stufe abgeben können, ohne dx anders zu runden.
+    struct SpanKernels {
+        SimdLevel level;
+        void (*blendSolid)(uint32_t* dst, const float* coverage, int count, uint32_t rgb, float alpha);
+        void (*blendGlow)(uint32_t* dst, const float* falloff, int count, uint32_t rgb, float centerAlpha);
+        void (*radialFalloff)(float* out, int begin, int end, float dx0, float dy, float invRadius);
+        void (*arcCoverage)(float* out, int begin, int end, float dx0, float dy, const ArcGeometry& arc);
+        void (*scaleAlpha)(uint32_t* dst, const uint32_t* src, int count, uint32_t factor);
+        void (*blendRows)(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, uint32_t w0, uint32_t w1);
+        void (*resampleRow)(uint32_t* dst, const uint32_t* src, const int32_t* index, const uint8_t* frac, int count);
+        void (*boxSumRow)(uint16_t* sum, const uint32_t* add, const uint32_t* sub, int count);
+        void (*boxAverageRow)(uint32_t* dst, const uint16_t* sum, int count, uint32_t half, uint32_t mult);
+        void (*blendBehind)(uint32_t* dst, const uint32_t* back, int count, uint32_t factor);
+        int (*equalRun)(const uint32_t* a, const uint32_t* b, int count);
+        int (*diff)(const uint32_t* a, const uint32_t* b, int count, int tolerance, int& maxDiff);
+    };
+
+    inline const SpanKernels& Kernels();
+
+    inline uint32_t RoundChannel(float v) {
+        return static_cast<uint32_t>(std::lrint(v));
+    }
+
+    // dst = farbe * cov * alpha + dst * (1 - cov * alpha)
+    inline void BlendSolidSpanScalar(uint32_t* dst, const float* coverage, int count, uint32_t rgb, float alpha) {
+        const float cr = static_cast<float>((rgb >> 16) & 0xFF);
+        const float cg = static_cast<float>((rgb >> 8) & 0xFF);
+        const float cb = static_cast<float>(rgb & 0xFF);
+        for (int i = 0; i < count; ++i) {
+            const float sa = std::min(coverage[i] * alpha, 1.0f);
+            const float inv = 1.0f - sa;
+            const uint32_t d = dst[i];
+            dst[i] = (RoundChannel(sa * 255.0f + static_cast<float>(d >> 24) * inv) << 24)
+                | (RoundChannel(sa * cr + static_cast<float>((d >> 16) & 0xFF) * inv) << 16)
+                | (RoundChannel(sa * cg + static_cast<float>((d >> 8) & 0xFF) * inv) << 8)
+                | RoundChannel(sa * cb + static_cast<float>(d & 0xFF) * inv);
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline void BlendSolidSpanSse2(uint32_t* dst, const float* coverage, int count, uint32_t rgb, float alpha) {
+        const __m128 one = _mm_set1_ps(1.0f), vAlpha = _mm_set1_ps(alpha), v255 = _mm_set1_ps(255.0f);
+        const __m128 vr = _mm_set1_ps(static_cast<float>((rgb >> 16) & 0xFF));
+        const __m128 vg = _mm_set1_ps(static_cast<float>((rgb >> 8) & 0xFF));
+        const __m128 vb = _mm_set1_ps(static_cast<float>(rgb & 0xFF));
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 sa = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(coverage + i), vAlpha), one);
+            const __m128 inv = _mm_sub_ps(one, sa);
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            const __m128 da = _mm_cvtepi32_ps(_mm_srli_epi32(d, 24));
+            const __m128 dr = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(d, 16), mask));
+            const __m128 dg = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(d, 8), mask));
+            const __m128 db = _mm_cvtepi32_ps(_mm_and_si128(d, mask));
+            const __m128i oa = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(sa, v255), _mm_mul_ps(da, inv)));
+            const __m128i orr = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(sa, vr), _mm_mul_ps(dr, inv)));
+            const __m128i og = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(sa, vg), _mm_mul_ps(dg, inv)));
+            const __m128i ob = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(sa, vb), _mm_mul_ps(db, inv)));
+            const __m128i out = _mm_or_si128(
+                _mm_or_si128(_mm_slli_epi32(oa, 24), _mm_slli_epi32(orr, 16)),
+                _mm_or_si128(_mm_slli_epi32(og, 8), ob));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+        }
+        BlendSolidSpanScalar(dst + i, coverage + i, count - i, rgb, alpha);
+    }
+
+    HUD_TARGET("avx2") inline void BlendSolidSpanAvx2(uint32_t* dst, const float* coverage, int count, uint32_t rgb, float alpha) {
+        const __m256 one = _mm256_set1_ps(1.0f), vAlpha = _mm256_set1_ps(alpha), v255 = _mm256_set1_ps(255.0f);
+        const __m256 vr = _mm256_set1_ps(static_cast<float>((rgb >> 16) & 0xFF));
+        const __m256 vg = _mm256_set1_ps(static_cast<float>((rgb >> 8) & 0xFF));
+        const __m256 vb = _mm256_set1_ps(static_cast<float>(rgb & 0xFF));
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 sa = _mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(coverage + i), vAlpha), one);
+            const __m256 inv = _mm256_sub_ps(one, sa);
+            const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            const __m256 da = _mm256_cvtepi32_ps(_mm256_srli_epi32(d, 24));
+            const __m256 dr = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(d, 16), mask));
+            const __m256 dg = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(d, 8), mask));
+            const __m256 db = _mm256_cvtepi32_ps(_mm256_and_si256(d, mask));
+            const __m256i oa = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(sa, v255), _mm256_mul_ps(da, inv)));
+            const __m256i orr = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(sa, vr), _mm256_mul_ps(dr, inv)));
+            const __m256i og = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(sa, vg), _mm256_mul_ps(dg, inv)));
+            const __m256i ob = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(sa, vb), _mm256_mul_ps(db, inv)));
+            const __m256i out = _mm256_or_si256(
+                _mm256_or_si256(_mm256_slli_epi32(oa, 24), _mm256_slli_epi32(orr, 16)),
+                _mm256_or_si256(_mm256_slli_epi32(og, 8), ob));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+        }
+        BlendSolidSpanSse2(dst + i, coverage + i, count - i, rgb, alpha);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void BlendSolidSpanAvx512(uint32_t* dst, const float* coverage, int count, uint32_t rgb, float alpha) {
+        const __m512 one = _mm512_set1_ps(1.0f), vAlpha = _mm512_set1_ps(alpha), v255 = _mm512_set1_ps(255.0f);
+        const __m512 vr = _mm512_set1_ps(static_cast<float>((rgb >> 16) & 0xFF));
+        const __m512 vg = _mm512_set1_ps(static_cast<float>((rgb >> 8) & 0xFF));
+        const __m512 vb = _mm512_set1_ps(static_cast<float>(rgb & 0xFF));
+        const __m512i mask = _mm512_set1_epi32(0xFF);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512 sa = _mm512_min_ps(_mm512_mul_ps(_mm512_loadu_ps(coverage + i), vAlpha), one);
+            const __m512 inv = _mm512_sub_ps(one, sa);
+            const __m512i d = _mm512_loadu_si512(dst + i);
+            const __m512 da = _mm512_cvtepi32_ps(_mm512_srli_epi32(d, 24));
+            const __m512 dr = _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(d, 16), mask));
+            const __m512 dg = _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(d, 8), mask));
+            const __m512 db = _mm512_cvtepi32_ps(_mm512_and_si512(d, mask));
+            const __m512i oa = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(sa, v255), _mm512_mul_ps(da, inv)));
+            const __m512i orr = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(sa, vr), _mm512_mul_ps(dr, inv)));
+            const __m512i og = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(sa, vg), _mm512_mul_ps(dg, inv)));
+            const __m512i ob = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(sa, vb), _mm512_mul_ps(db, inv)));
+            const __m512i out = _mm512_or_si512(
+                _mm512_or_si512(_mm512_slli_epi32(oa, 24), _mm512_slli_epi32(orr, 16)),
+                _mm512_or_si512(_mm512_slli_epi32(og, 8), ob));
+            _mm512_storeu_si512(dst + i, out);
+        }
+        BlendSolidSpanAvx2(dst + i, coverage + i, count - i, rgb, alpha);
+    }
+#endif
+
+    inline void BlendSolidSpan(uint32_t* dst, const float* coverage, int count, uint32_t rgb, float alpha) {
+        Kernels().blendSolid(dst, coverage, count, rgb, alpha);
+    }
+
+    // Glow wie GlowCache::Rasterize: Alpha = A * t, Farbe zusätzlich mit t abgedunkelt.
+    inline void BlendGlowSpanScalar(uint32_t* dst, const float* falloff, int count, uint32_t rgb, float centerAlpha) {
+        const float cr = static_cast<float>((rgb >> 16) & 0xFF);
+        const float cg = static_cast<float>((rgb >> 8) & 0xFF);
+        const float cb = static_cast<float>(rgb & 0xFF);
+        const float alphaScale = centerAlpha / 255.0f;
+        for (int i = 0; i < count; ++i) {
+            const float t = falloff[i];
+            const float sa = t * alphaScale;
+            const float k = t * sa;
+            const float inv = 1.0f - sa;
+            const uint32_t d = dst[i];
+            dst[i] = (RoundChannel(sa * 255.0f + static_cast<float>(d >> 24) * inv) << 24)
+                | (RoundChannel(k * cr + static_cast<float>((d >> 16) & 0xFF) * inv) << 16)
+                | (RoundChannel(k * cg + static_cast<float>((d >> 8) & 0xFF) * inv) << 8)
+                | RoundChannel(k * cb + static_cast<float>(d & 0xFF) * inv);
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline void BlendGlowSpanSse2(uint32_t* dst, const float* falloff, int count, uint32_t rgb, float centerAlpha) {
+        const __m128 one = _mm_set1_ps(1.0f), vScale = _mm_set1_ps(centerAlpha / 255.0f), v255 = _mm_set1_ps(255.0f);
+        const __m128 vr = _mm_set1_ps(static_cast<float>((rgb >> 16) & 0xFF));
+        const __m128 vg = _mm_set1_ps(static_cast<float>((rgb >> 8) & 0xFF));
+        const __m128 vb = _mm_set1_ps(static_cast<float>(rgb & 0xFF));
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 t = _mm_loadu_ps(falloff + i);
+            const __m128 sa = _mm_mul_ps(t, vScale);
+            const __m128 k = _mm_mul_ps(t, sa);
+            const __m128 inv = _mm_sub_ps(one, sa);
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            const __m128 da = _mm_cvtepi32_ps(_mm_srli_epi32(d, 24));
+            const __m128 dr = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(d, 16), mask));
+            const __m128 dg = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(d, 8), mask));
+            const __m128 db = _mm_cvtepi32_ps(_mm_and_si128(d, mask));
+            const __m128i oa = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(sa, v255), _mm_mul_ps(da, inv)));
+            const __m128i orr = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(k, vr), _mm_mul_ps(dr, inv)));
+            const __m128i og = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(k, vg), _mm_mul_ps(dg, inv)));
+            const __m128i ob = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(k, vb), _mm_mul_ps(db, inv)));
+            const __m128i out = _mm_or_si128(
+                _mm_or_si128(_mm_slli_epi32(oa, 24), _mm_slli_epi32(orr, 16)),
+                _mm_or_si128(_mm_slli_epi32(og, 8), ob));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+        }
+        BlendGlowSpanScalar(dst + i, falloff + i, count - i, rgb, centerAlpha);
+    }
+
+    HUD_TARGET("avx2") inline void BlendGlowSpanAvx2(uint32_t* dst, const float* falloff, int count, uint32_t rgb, float centerAlpha) {
+        const __m256 one = _mm256_set1_ps(1.0f), vScale = _mm256_set1_ps(centerAlpha / 255.0f), v255 = _mm256_set1_ps(255.0f);
+        const __m256 vr = _mm256_set1_ps(static_cast<float>((rgb >> 16) & 0xFF));
+        const __m256 vg = _mm256_set1_ps(static_cast<float>((rgb >> 8) & 0xFF));
+        const __m256 vb = _mm256_set1_ps(static_cast<float>(rgb & 0xFF));
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 t = _mm256_loadu_ps(falloff + i);
+            const __m256 sa = _mm256_mul_ps(t, vScale);
+            const __m256 k = _mm256_mul_ps(t, sa);
+            const __m256 inv = _mm256_sub_ps(one, sa);
+            const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            const __m256 da = _mm256_cvtepi32_ps(_mm256_srli_epi32(d, 24));
+            const __m256 dr = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(d, 16), mask));
+            const __m256 dg = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(d, 8), mask));
+            const __m256 db = _mm256_cvtepi32_ps(_mm256_and_si256(d, mask));
+            const __m256i oa = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(sa, v255), _mm256_mul_ps(da, inv)));
+            const __m256i orr = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(k, vr), _mm256_mul_ps(dr, inv)));
+            const __m256i og = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(k, vg), _mm256_mul_ps(dg, inv)));
+            const __m256i ob = _mm256_cvtps_epi32(_mm256_add_ps(_mm256_mul_ps(k, vb), _mm256_mul_ps(db, inv)));
+            const __m256i out = _mm256_or_si256(
+                _mm256_or_si256(_mm256_slli_epi32(oa, 24), _mm256_slli_epi32(orr, 16)),
+                _mm256_or_si256(_mm256_slli_epi32(og, 8), ob));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), out);
+        }
+        BlendGlowSpanSse2(dst + i, falloff + i, count - i, rgb, centerAlpha);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void BlendGlowSpanAvx512(uint32_t* dst, const float* falloff, int count, uint32_t rgb, float centerAlpha) {
+        const __m512 one = _mm512_set1_ps(1.0f), vScale = _mm512_set1_ps(centerAlpha / 255.0f), v255 = _mm512_set1_ps(255.0f);
+        const __m512 vr = _mm512_set1_ps(static_cast<float>((rgb >> 16) & 0xFF));
+        const __m512 vg = _mm512_set1_ps(static_cast<float>((rgb >> 8) & 0xFF));
+        const __m512 vb = _mm512_set1_ps(static_cast<float>(rgb & 0xFF));
+        const __m512i mask = _mm512_set1_epi32(0xFF);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512 t = _mm512_loadu_ps(falloff + i);
+            const __m512 sa = _mm512_mul_ps(t, vScale);
+            const __m512 k = _mm512_mul_ps(t, sa);
+            const __m512 inv = _mm512_sub_ps(one, sa);
+            const __m512i d = _mm512_loadu_si512(dst + i);
+            const __m512 da = _mm512_cvtepi32_ps(_mm512_srli_epi32(d, 24));
+            const __m512 dr = _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(d, 16), mask));
+            const __m512 dg = _mm512_cvtepi32_ps(_mm512_and_si512(_mm512_srli_epi32(d, 8), mask));
+            const __m512 db = _mm512_cvtepi32_ps(_mm512_and_si512(d, mask));
+            const __m512i oa = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(sa, v255), _mm512_mul_ps(da, inv)));
+            const __m512i orr = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(k, vr), _mm512_mul_ps(dr, inv)));
+            const __m512i og = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(k, vg), _mm512_mul_ps(dg, inv)));
+            const __m512i ob = _mm512_cvtps_epi32(_mm512_add_ps(_mm512_mul_ps(k, vb), _mm512_mul_ps(db, inv)));
+            const __m512i out = _mm512_or_si512(
+                _mm512_or_si512(_mm512_slli_epi32(oa, 24), _mm512_slli_epi32(orr, 16)),
+                _mm512_or_si512(_mm512_slli_epi32(og, 8), ob));
+            _mm512_storeu_si512(dst + i, out);
+        }
+        BlendGlowSpanAvx2(dst + i, falloff + i, count - i, rgb, centerAlpha);
+    }
+#endif
+
+    inline void BlendGlowSpan(uint32_t* dst, const float* falloff, int count, uint32_t rgb, float centerAlpha) {
+        Kernels().blendGlow(dst, falloff, count, rgb, centerAlpha);
+    }
+
+    // t = max(0, 1 - |p - c| / r) für out[begin..end); dx0 = Abstand der ersten Pixelmitte zu cx.
+    // Die Vektorpfade bilden i + Lane exakt und addieren dx0 erst dann, damit dx wie skalar rundet.
+    inline void RadialFalloffSpanScalar(float* out, int begin, int end, float dx0, float dy, float invRadius) {
+        const float dy2 = dy * dy;
+        for (int i = begin; i < end; ++i) {
+            const float dx = dx0 + static_cast<float>(i);
+            const float dist = std::sqrt(dx * dx + dy2);
+            out[i] = std::max(0.0f, 1.0f - dist * invRadius);
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline void RadialFalloffSpanSse2(float* out, int begin, int end, float dx0, float dy, float invRadius) {
+        const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+        const __m128 vInv = _mm_set1_ps(invRadius), vDy2 = _mm_set1_ps(dy * dy), vDx0 = _mm_set1_ps(dx0);
+        const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+        int i = begin;
+        for (; i + 4 <= end; i += 4) {
+            const __m128 dx = _mm_add_ps(vDx0, _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lane));
+            const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), vDy2));
+            _mm_storeu_ps(out + i, _mm_max_ps(zero, _mm_sub_ps(one, _mm_mul_ps(dist, vInv))));
+        }
+        RadialFalloffSpanScalar(out, i, end, dx0, dy, invRadius);
+    }
+
+    HUD_TARGET("avx2") inline void RadialFalloffSpanAvx2(float* out, int begin, int end, float dx0, float dy, float invRadius) {
+        const __m256 one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+        const __m256 vInv = _mm256_set1_ps(invRadius), vDy2 = _mm256_set1_ps(dy * dy), vDx0 = _mm256_set1_ps(dx0);
+        const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        int i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 dx = _mm256_add_ps(vDx0, _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lane));
+            const __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), vDy2));
+            _mm256_storeu_ps(out + i, _mm256_max_ps(zero, _mm256_sub_ps(one, _mm256_mul_ps(dist, vInv))));
+        }
+        RadialFalloffSpanSse2(out, i, end, dx0, dy, invRadius);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void RadialFalloffSpanAvx512(float* out, int begin, int end, float dx0, float dy, float invRadius) {
+        const __m512 one = _mm512_set1_ps(1.0f), zero = _mm512_setzero_ps();
+        const __m512 vInv = _mm512_set1_ps(invRadius), vDy2 = _mm512_set1_ps(dy * dy), vDx0 = _mm512_set1_ps(dx0);
+        const __m512 lane = _mm512_set_ps(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        int i = begin;
+        for (; i + 16 <= end; i += 16) {
+            const __m512 dx = _mm512_add_ps(vDx0, _mm512_add_ps(_mm512_set1_ps(static_cast<float>(i)), lane));
+            const __m512 dist = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), vDy2));
+            _mm512_storeu_ps(out + i, _mm512_max_ps(zero, _mm512_sub_ps(one, _mm512_mul_ps(dist, vInv))));
+        }
+        RadialFalloffSpanAvx2(out, i, end, dx0, dy, invRadius);
+    }
+#endif
+
+    inline void RadialFalloffSpan(float* out, int count, float dx0, float dy, float invRadius) {
+        Kernels().radialFalloff(out, 0, count, dx0, dy, invRadius);
+    }
+
+    inline void FillRadialGradient(const Surface& dst, const PixelRect& clip, float cx, float cy, float radius,
+        uint32_t rgb, float centerAlpha, std::vector<float>& scratch) {
+        if (radius <= 0.0f || centerAlpha <= 0.0f) return;
+        scratch.resize(dst.width);
+
+        const int y0 = std::max(clip.y0, static_cast<int>(std::floor(cy - radius)));
+        const int y1 = std::min(clip.y1, static_cast<int>(std::ceil(cy + radius)));
+        const float invRadius = 1.0f / radius;
+
+        for (int y = y0; y < y1; ++y) {
+            const float dy = y + 0.5f - cy;
+            const float half2 = radius * radius - dy * dy;
+            if (half2 <= 0.0f) continue;
+            const float half = std::sqrt(half2);
+            const int x0 = std::max(clip.x0, static_cast<int>(std::floor(cx - half)));
+            const int x1 = std::min(clip.x1, static_cast<int>(std::ceil(cx + half)));
+            if (x1 <= x0) continue;
+
+            RadialFalloffSpan(scratch.data(), x1 - x0, x0 + 0.5f - cx, dy, invRadius);
+            BlendGlowSpan(dst.Row(y) + x0, scratch.data(), x1 - x0, rgb, centerAlpha);
+        }
+    }
+
+    // Bogen mit runden Enden; Winkel wie GDI+ (Grad, im Uhrzeigersinn, 0 = rechts).
+    struct ArcGeometry {
+        float cx, cy, radius, halfWidth;
+        float sx, sy, ex, ey;
+        float sweep;
+
+        ArcGeometry(float cx, float cy, float radius, float halfWidth, float startDeg, float sweepDeg)
+            : cx(cx), cy(cy), radius(radius), halfWidth(halfWidth), sweep(sweepDeg) {
+            constexpr float degToRad = 3.14159265358979f / 180.0f;
+            sx = std::cos(startDeg * degToRad);
+            sy = std::sin(startDeg * degToRad);
+            ex = std::cos((startDeg + sweepDeg) * degToRad);
+            ey = std::sin((startDeg + sweepDeg) * degToRad);
+        }
+
+        bool InSweep(float dx, float dy) const {
+            if (sweep >= 360.0f) return true;
+            const float fromStart = sx * dy - sy * dx;
+            const float toEnd = dx * ey - dy * ex;
+            if (sweep <= 180.0f) return fromStart >= 0.0f && toEnd >= 0.0f;
+            return !(fromStart < 0.0f && toEnd < 0.0f);
+        }
+
+        float Distance(float px, float py) const {
+            return DistanceFromCenter(px - cx, py - cy);
+        }
+
+        // Abstand zur Mittellinie des Bogens bzw. zum nächsten Kappen-Mittelpunkt
+        float DistanceFromCenter(float dx, float dy) const {
+            if (InSweep(dx, dy)) {
+                return std::fabs(std::sqrt(dx * dx + dy * dy) - radius);
+            }
+            const float ax = dx - sx * radius, ay = dy - sy * radius;
+            const float bx = dx - ex * radius, by = dy - ey * radius;
+            return std::sqrt(std::min(ax * ax + ay * ay, bx * bx + by * by));
+        }
+    };
+
+    // Flächenanteil eines Pixels (Box-Filter quer zur Kante) an einem Band |d| <= halfWidth.
+    inline float BandCoverage(float distance, float halfWidth) {
+        return std::max(0.0f, std::min(distance + 0.5f, halfWidth) - std::max(distance - 0.5f, -halfWidth));
+    }
+
+    // Abdeckung des Bogens mit runden Kappen aus der geschlossenen Abstandsfunktion für out[begin..end), pro Zeile vektorisiert.
+    // Außerhalb des Bogens zählt die Vereinigung beider Kappen: bei fast vollem Bogen überlappen sie, dann unterschätzt
+    // der kleinere Abstand allein die Fläche.
+    inline void ArcCoverageSpanScalar(float* out, int begin, int end, float dx0, float dy, const ArcGeometry& arc) {
+        for (int i = begin; i < end; ++i) {
+            const float dx = dx0 + static_cast<float>(i);
+            if (arc.InSweep(dx, dy)) {
+                out[i] = BandCoverage(std::fabs(std::sqrt(dx * dx + dy * dy) - arc.radius), arc.halfWidth);
+                continue;
+            }
+            const float ax = dx - arc.sx * arc.radius, ay = dy - arc.sy * arc.radius;
+            const float bx = dx - arc.ex * arc.radius, by = dy - arc.ey * arc.radius;
+            const float start = BandCoverage(std::sqrt(ax * ax + ay * ay), arc.halfWidth);
+            const float stop = BandCoverage(std::sqrt(bx * bx + by * by), arc.halfWidth);
+            out[i] = start + stop - start * stop;
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline void ArcCoverageSpanSse2(float* out, int begin, int end, float dx0, float dy, const ArcGeometry& arc) {
+        const bool fullCircle = arc.sweep >= 360.0f;
+        const bool narrow = arc.sweep <= 180.0f;
+        const __m128 zero = _mm_setzero_ps(), half = _mm_set1_ps(0.5f);
+        const __m128 hw = _mm_set1_ps(arc.halfWidth), negHw = _mm_set1_ps(-arc.halfWidth);
+        const __m128 r = _mm_set1_ps(arc.radius), absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        const __m128 vDy = _mm_set1_ps(dy), vDy2 = _mm_set1_ps(dy * dy), vDx0 = _mm_set1_ps(dx0);
+        const __m128 sx = _mm_set1_ps(arc.sx), sy = _mm_set1_ps(arc.sy);
+        const __m128 ex = _mm_set1_ps(arc.ex), ey = _mm_set1_ps(arc.ey);
+        const __m128 ay = _mm_set1_ps(dy - arc.sy * arc.radius), by = _mm_set1_ps(dy - arc.ey * arc.radius);
+        const __m128 ay2 = _mm_mul_ps(ay, ay), by2 = _mm_mul_ps(by, by);
+        const __m128 sxr = _mm_set1_ps(arc.sx * arc.radius), exr = _mm_set1_ps(arc.ex * arc.radius);
+        const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+        int i = begin;
+        for (; i + 4 <= end; i += 4) {
+            const __m128 dx = _mm_add_ps(vDx0, _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), lane));
+            const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), vDy2));
+            const __m128 dist = _mm_and_ps(_mm_sub_ps(len, r), absMask);
+            __m128 cover = _mm_max_ps(zero, _mm_sub_ps(_mm_min_ps(_mm_add_ps(dist, half), hw),
+                _mm_max_ps(_mm_sub_ps(dist, half), negHw)));
+
+            if (!fullCircle) {
+                const __m128 fromStart = _mm_sub_ps(_mm_mul_ps(sx, vDy), _mm_mul_ps(sy, dx));
+                const __m128 toEnd = _mm_sub_ps(_mm_mul_ps(dx, ey), _mm_mul_ps(vDy, ex));
+                const __m128 a = _mm_cmpge_ps(fromStart, zero);
+                const __m128 b = _mm_cmpge_ps(toEnd, zero);
+                const __m128 inSweep = narrow ? _mm_and_ps(a, b) : _mm_or_ps(a, b);
+
+                const __m128 ax = _mm_sub_ps(dx, sxr), bx = _mm_sub_ps(dx, exr);
+                const __m128 startDist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ax, ax), ay2));
+                const __m128 stopDist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(bx, bx), by2));
+                const __m128 start = _mm_max_ps(zero, _mm_sub_ps(_mm_min_ps(_mm_add_ps(startDist, half), hw),
+                    _mm_max_ps(_mm_sub_ps(startDist, half), negHw)));
+                const __m128 stop = _mm_max_ps(zero, _mm_sub_ps(_mm_min_ps(_mm_add_ps(stopDist, half), hw),
+                    _mm_max_ps(_mm_sub_ps(stopDist, half), negHw)));
+                const __m128 caps = _mm_sub_ps(_mm_add_ps(start, stop), _mm_mul_ps(start, stop));
+                cover = _mm_or_ps(_mm_and_ps(inSweep, cover), _mm_andnot_ps(inSweep, caps));
+            }
+            _mm_storeu_ps(out + i, cover);
+        }
+        ArcCoverageSpanScalar(out, i, end, dx0, dy, arc);
+    }
+
+    HUD_TARGET("avx2") inline void ArcCoverageSpanAvx2(float* out, int begin, int end, float dx0, float dy, const ArcGeometry& arc) {
+        const bool fullCircle = arc.sweep >= 360.0f;
+        const bool narrow = arc.sweep <= 180.0f;
+        const __m256 zero = _mm256_setzero_ps(), half = _mm256_set1_ps(0.5f);
+        const __m256 hw = _mm256_set1_ps(arc.halfWidth), negHw = _mm256_set1_ps(-arc.halfWidth);
+        const __m256 r = _mm256_set1_ps(arc.radius), absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        const __m256 vDy = _mm256_set1_ps(dy), vDy2 = _mm256_set1_ps(dy * dy), vDx0 = _mm256_set1_ps(dx0);
+        const __m256 sx = _mm256_set1_ps(arc.sx), sy = _mm256_set1_ps(arc.sy);
+        const __m256 ex = _mm256_set1_ps(arc.ex), ey = _mm256_set1_ps(arc.ey);
+        const __m256 ay = _mm256_set1_ps(dy - arc.sy * arc.radius), by = _mm256_set1_ps(dy - arc.ey * arc.radius);
+        const __m256 ay2 = _mm256_mul_ps(ay, ay), by2 = _mm256_mul_ps(by, by);
+        const __m256 sxr = _mm256_set1_ps(arc.sx * arc.radius), exr = _mm256_set1_ps(arc.ex * arc.radius);
+        const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        int i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 dx = _mm256_add_ps(vDx0, _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), lane));
+            const __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), vDy2));
+            const __m256 dist = _mm256_and_ps(_mm256_sub_ps(len, r), absMask);
+            __m256 cover = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(_mm256_add_ps(dist, half), hw),
+                _mm256_max_ps(_mm256_sub_ps(dist, half), negHw)));
+
+            if (!fullCircle) {
+                const __m256 fromStart = _mm256_sub_ps(_mm256_mul_ps(sx, vDy), _mm256_mul_ps(sy, dx));
+                const __m256 toEnd = _mm256_sub_ps(_mm256_mul_ps(dx, ey), _mm256_mul_ps(vDy, ex));
+                const __m256 a = _mm256_cmp_ps(fromStart, zero, _CMP_GE_OQ);
+                const __m256 b = _mm256_cmp_ps(toEnd, zero, _CMP_GE_OQ);
+                const __m256 inSweep = narrow ? _mm256_and_ps(a, b) : _mm256_or_ps(a, b);
+
+                const __m256 ax = _mm256_sub_ps(dx, sxr), bx = _mm256_sub_ps(dx, exr);
+                const __m256 startDist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ax, ax), ay2));
+                const __m256 stopDist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(bx, bx), by2));
+                const __m256 start = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(_mm256_add_ps(startDist, half), hw),
+                    _mm256_max_ps(_mm256_sub_ps(startDist, half), negHw)));
+                const __m256 stop = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(_mm256_add_ps(stopDist, half), hw),
+                    _mm256_max_ps(_mm256_sub_ps(stopDist, half), negHw)));
+                const __m256 caps = _mm256_sub_ps(_mm256_add_ps(start, stop), _mm256_mul_ps(start, stop));
+                cover = _mm256_blendv_ps(caps, cover, inSweep);
+            }
+            _mm256_storeu_ps(out + i, cover);
+        }
+        ArcCoverageSpanSse2(out, i, end, dx0, dy, arc);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void ArcCoverageSpanAvx512(float* out, int begin, int end, float dx0, float dy, const ArcGeometry& arc) {
+        const bool fullCircle = arc.sweep >= 360.0f;
+        const bool narrow = arc.sweep <= 180.0f;
+        const __m512 zero = _mm512_setzero_ps(), half = _mm512_set1_ps(0.5f);
+        const __m512 hw = _mm512_set1_ps(arc.halfWidth), negHw = _mm512_set1_ps(-arc.halfWidth);
+        const __m512 r = _mm512_set1_ps(arc.radius);
+        const __m512 vDy = _mm512_set1_ps(dy), vDy2 = _mm512_set1_ps(dy * dy), vDx0 = _mm512_set1_ps(dx0);
+        const __m512 sx = _mm512_set1_ps(arc.sx), sy = _mm512_set1_ps(arc.sy);
+        const __m512 ex = _mm512_set1_ps(arc.ex), ey = _mm512_set1_ps(arc.ey);
+        const __m512 ay = _mm512_set1_ps(dy - arc.sy * arc.radius), by = _mm512_set1_ps(dy - arc.ey * arc.radius);
+        const __m512 ay2 = _mm512_mul_ps(ay, ay), by2 = _mm512_mul_ps(by, by);
+        const __m512 sxr = _mm512_set1_ps(arc.sx * arc.radius), exr = _mm512_set1_ps(arc.ex * arc.radius);
+        const __m512 lane = _mm512_set_ps(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        int i = begin;
+        for (; i + 16 <= end; i += 16) {
+            const __m512 dx = _mm512_add_ps(vDx0, _mm512_add_ps(_mm512_set1_ps(static_cast<float>(i)), lane));
+            const __m512 len = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), vDy2));
+            const __m512 dist = _mm512_abs_ps(_mm512_sub_ps(len, r));
+            __m512 cover = _mm512_max_ps(zero, _mm512_sub_ps(_mm512_min_ps(_mm512_add_ps(dist, half), hw),
+                _mm512_max_ps(_mm512_sub_ps(dist, half), negHw)));
+
+            if (!fullCircle) {
+                const __m512 fromStart = _mm512_sub_ps(_mm512_mul_ps(sx, vDy), _mm512_mul_ps(sy, dx));
+                const __m512 toEnd = _mm512_sub_ps(_mm512_mul_ps(dx, ey), _mm512_mul_ps(vDy, ex));
+                const __mmask16 a = _mm512_cmp_ps_mask(fromStart, zero, _CMP_GE_OQ);
+                const __mmask16 b = _mm512_cmp_ps_mask(toEnd, zero, _CMP_GE_OQ);
+                const __mmask16 inSweep = static_cast<__mmask16>(narrow ? (a & b) : (a | b));
+
+                const __m512 ax = _mm512_sub_ps(dx, sxr), bx = _mm512_sub_ps(dx, exr);
+                const __m512 startDist = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(ax, ax), ay2));
+                const __m512 stopDist = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(bx, bx), by2));
+                const __m512 start = _mm512_max_ps(zero, _mm512_sub_ps(_mm512_min_ps(_mm512_add_ps(startDist, half), hw),
+                    _mm512_max_ps(_mm512_sub_ps(startDist, half), negHw)));
+                const __m512 stop = _mm512_max_ps(zero, _mm512_sub_ps(_mm512_min_ps(_mm512_add_ps(stopDist, half), hw),
+                    _mm512_max_ps(_mm512_sub_ps(stopDist, half), negHw)));
+                const __m512 caps = _mm512_sub_ps(_mm512_add_ps(start, stop), _mm512_mul_ps(start, stop));
+                cover = _mm512_mask_blend_ps(inSweep, caps, cover);
+            }
+            _mm512_storeu_ps(out + i, cover);
+        }
+        ArcCoverageSpanAvx2(out, i, end, dx0, dy, arc);
+    }
+#endif
+
+    inline void ArcCoverageSpan(float* out, int count, float dx0, float dy, const ArcGeometry& arc) {
+        Kernels().arcCoverage(out, 0, count, dx0, dy, arc);
+    }
+
+    // Abdeckung analytisch über ArcCoverageSpan; emit(y, x0, count, coverage) für jedes Segment mit Abdeckung.
+    template<typename Emit>
+    inline void ForEachArcSpan(const PixelRect& clip, const ArcGeometry& arc, std::vector<float>& scratch, Emit emit) {
+        if (arc.sweep <= 0.0f || arc.radius <= 0.0f || clip.IsEmpty()) return;
+        scratch.resize(clip.x1 - clip.x0);
+
+        const float outer = arc.radius + arc.halfWidth + 1.0f;
+        const float inner = arc.radius - arc.halfWidth - 1.0f;
+        const int y0 = std::max(clip.y0, static_cast<int>(std::floor(arc.cy - outer)));
+        const int y1 = std::min(clip.y1, static_cast<int>(std::ceil(arc.cy + outer)));
+
+        auto coverSegment = [&](int y, float dy, int x0, int x1) {
+            x0 = std::max(clip.x0, x0);
+            x1 = std::min(clip.x1, x1);
+            if (x1 <= x0) return;
+
+            ArcCoverageSpan(scratch.data(), x1 - x0, x0 + 0.5f - arc.cx, dy, arc);
+            for (int i = 0; i < x1 - x0; ++i) {
+                if (scratch[i] > 0.0f) {
+                    emit(y, x0, x1 - x0, scratch.data());
+                    return;
+                }
+            }
+        };
+
+        for (int y = y0; y < y1; ++y) {
+            const float dy = y + 0.5f - arc.cy;
+            const float outer2 = outer * outer - dy * dy;
+            if (outer2 <= 0.0f) continue;
+            const float outerHalf = std::sqrt(outer2);
+            const int left = static_cast<int>(std::floor(arc.cx - outerHalf));
+            const int right = static_cast<int>(std::ceil(arc.cx + outerHalf));
+
+            const float inner2 = (inner > 0.0f) ? inner * inner - dy * dy : 0.0f;
+            if (inner2 > 0.0f) {
+                const float innerHalf = std::sqrt(inner2);
+                coverSegment(y, dy, left, static_cast<int>(std::ceil(arc.cx - innerHalf)));
+                coverSegment(y, dy, static_cast<int>(std::floor(arc.cx + innerHalf)), right);
+            }
+            else {
+                coverSegment(y, dy, left, right);
+            }
+        }
+    }
+
+    inline void StrokeArc(const Surface& dst, const PixelRect& clip, const ArcGeometry& arc, uint32_t rgb, float alpha,
+        std::vector<float>& scratch) {
+        if (alpha <= 0.0f) return;
+        ForEachArcSpan(clip, arc, scratch, [&](int y, int x0, int count, const float* coverage) {
+            BlendSolidSpan(dst.Row(y) + x0, coverage, count, rgb, alpha);
+        });
+    }
+
+    // 8-Bit-Maske bilinear skaliert (um den Punkt cx/cy) einblenden.
+    inline void BlitMaskScaled(const Surface& dst, const PixelRect& clip, const uint8_t* mask, int maskStride,
+        int srcX, int srcW, int srcH, float destX, float destY,
+        float scale, float cx, float cy, uint32_t rgb, float alpha, std::vector<float>& scratch) {
+        if (srcW <= 0 || srcH <= 0 || scale <= 0.0f || alpha <= 0.0f) return;
+        scratch.resize(dst.width);
+
+        const float left = cx + (destX - cx) * scale;
+        const float top = cy + (destY - cy) * scale;
+        const int x0 = std::max(clip.x0, static_cast<int>(std::floor(left)));
+        const int x1 = std::min(clip.x1, static_cast<int>(std::ceil(left + srcW * scale)));
+        const int y0 = std::max(clip.y0, static_cast<int>(std::floor(top)));
+        const int y1 = std::min(clip.y1, static_cast<int>(std::ceil(top + srcH * scale)));
+        if (x1 <= x0 || y1 <= y0) return;
+
+        const float invScale = 1.0f / scale;
+        auto sample = [&](int u, int v) -> float {
+            if (u < 0 || v < 0 || u >= srcW || v >= srcH) return 0.0f;
+            return mask[static_cast<size_t>(v) * maskStride + srcX + u];
+        };
+
+        for (int y = y0; y < y1; ++y) {
+            const float v = (y + 0.5f - top) * invScale - 0.5f;
+            const int vi = static_cast<int>(std::floor(v));
+            const float fv = v - vi;
+
+            for (int x = x0; x < x1; ++x) {
+                const float u = (x + 0.5f - left) * invScale - 0.5f;
+                const int ui = static_cast<int>(std::floor(u));
+                const float fu = u - ui;
+                const float top0 = sample(ui, vi) + (sample(ui + 1, vi) - sample(ui, vi)) * fu;
+                const float bottom0 = sample(ui, vi + 1) + (sample(ui + 1, vi + 1) - sample(ui, vi + 1)) * fu;
+                scratch[x - x0] = (top0 + (bottom0 - top0) * fv) * (1.0f / 255.0f);
+            }
+            BlendSolidSpan(dst.Row(y) + x0, scratch.data(), x1 - x0, rgb, alpha);
+        }
+    }
+
+    // Vormultipliziert: alle vier Kanäle * factor / 256 (factor 0..256, 256 = unverändert).
+    inline void ScaleAlphaSpanScalar(uint32_t* dst, const uint32_t* src, int count, uint32_t factor) {
+        for (int i = 0; i < count; ++i) {
+            const uint32_t p = src[i];
+            const uint32_t rb = ((p & 0x00FF00FF) * factor + 0x00800080) >> 8;
+            const uint32_t ag = (((p >> 8) & 0x00FF00FF) * factor + 0x00800080) >> 8;
+            dst[i] = (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline void ScaleAlphaSpanSse2(uint32_t* dst, const uint32_t* src, int count, uint32_t factor) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i vFactor = _mm_set1_epi16(static_cast<short>(factor));
+        const __m128i round = _mm_set1_epi16(128);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i lo = _mm_unpacklo_epi8(p, zero);
+            __m128i hi = _mm_unpackhi_epi8(p, zero);
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, vFactor), round), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, vFactor), round), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        ScaleAlphaSpanScalar(dst + i, src + i, count - i, factor);
+    }
+
+    HUD_TARGET("avx2") inline void ScaleAlphaSpanAvx2(uint32_t* dst, const uint32_t* src, int count, uint32_t factor) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i vFactor = _mm256_set1_epi16(static_cast<short>(factor));
+        const __m256i round = _mm256_set1_epi16(128);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i lo = _mm256_unpacklo_epi8(p, zero);
+            __m256i hi = _mm256_unpackhi_epi8(p, zero);
+            lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(lo, vFactor), round), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(hi, vFactor), round), 8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+        }
+        ScaleAlphaSpanSse2(dst + i, src + i, count - i, factor);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void ScaleAlphaSpanAvx512(uint32_t* dst, const uint32_t* src, int count, uint32_t factor) {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i vFactor = _mm512_set1_epi16(static_cast<short>(factor));
+        const __m512i round = _mm512_set1_epi16(128);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512i p = _mm512_loadu_si512(src + i);
+            __m512i lo = _mm512_unpacklo_epi8(p, zero);
+            __m512i hi = _mm512_unpackhi_epi8(p, zero);
+            lo = _mm512_srli_epi16(_mm512_add_epi16(_mm512_mullo_epi16(lo, vFactor), round), 8);
+            hi = _mm512_srli_epi16(_mm512_add_epi16(_mm512_mullo_epi16(hi, vFactor), round), 8);
+            _mm512_storeu_si512(dst + i, _mm512_packus_epi16(lo, hi));
+        }
+        ScaleAlphaSpanAvx2(dst + i, src + i, count - i, factor);
+    }
+#endif
+
+    inline void ScaleAlphaSpan(uint32_t* dst, const uint32_t* src, int count, uint32_t factor) {
+        Kernels().scaleAlpha(dst, src, count, factor);
+    }
+
+    inline uint32_t AlphaToFactor(int alpha) {
+        return (static_cast<uint32_t>(alpha) * 256 + 127) / 255;
+    }
+
+    // Zwei Zeilen gewichtet mischen (w0 + w1 <= 256); ergibt zugleich die Alpha-Skalierung.
+    inline void BlendRowsSpanScalar(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, uint32_t w0, uint32_t w1) {
+        for (int i = 0; i < count; ++i) {
+            const uint32_t rb = ((a[i] & 0x00FF00FF) * w0 + (b[i] & 0x00FF00FF) * w1 + 0x00800080) >> 8;
+            const uint32_t ag = (((a[i] >> 8) & 0x00FF00FF) * w0 + ((b[i] >> 8) & 0x00FF00FF) * w1 + 0x00800080) >> 8;
+            dst[i] = (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline void BlendRowsSpanSse2(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, uint32_t w0, uint32_t w1) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i vw0 = _mm_set1_epi16(static_cast<short>(w0));
+        const __m128i vw1 = _mm_set1_epi16(static_cast<short>(w1));
+        const __m128i round = _mm_set1_epi16(128);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), vw0),
+                _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), vw1));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), vw0),
+                _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), vw1));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        BlendRowsSpanScalar(dst + i, a + i, b + i, count - i, w0, w1);
+    }
+
+    HUD_TARGET("avx2") inline void BlendRowsSpanAvx2(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, uint32_t w0, uint32_t w1) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i vw0 = _mm256_set1_epi16(static_cast<short>(w0));
+        const __m256i vw1 = _mm256_set1_epi16(static_cast<short>(w1));
+        const __m256i round = _mm256_set1_epi16(128);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i pa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const __m256i pb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pa, zero), vw0),
+                _mm256_mullo_epi16(_mm256_unpacklo_epi8(pb, zero), vw1));
+            __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pa, zero), vw0),
+                _mm256_mullo_epi16(_mm256_unpackhi_epi8(pb, zero), vw1));
+            lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+        }
+        BlendRowsSpanSse2(dst + i, a + i, b + i, count - i, w0, w1);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void BlendRowsSpanAvx512(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, uint32_t w0, uint32_t w1) {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i vw0 = _mm512_set1_epi16(static_cast<short>(w0));
+        const __m512i vw1 = _mm512_set1_epi16(static_cast<short>(w1));
+        const __m512i round = _mm512_set1_epi16(128);
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512i pa = _mm512_loadu_si512(a + i);
+            const __m512i pb = _mm512_loadu_si512(b + i);
+            __m512i lo = _mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpacklo_epi8(pa, zero), vw0),
+                _mm512_mullo_epi16(_mm512_unpacklo_epi8(pb, zero), vw1));
+            __m512i hi = _mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpackhi_epi8(pa, zero), vw0),
+                _mm512_mullo_epi16(_mm512_unpackhi_epi8(pb, zero), vw1));
+            lo = _mm512_srli_epi16(_mm512_add_epi16(lo, round), 8);
+            hi = _mm512_srli_epi16(_mm512_add_epi16(hi, round), 8);
+            _mm512_storeu_si512(dst + i, _mm512_packus_epi16(lo, hi));
+        }
+        BlendRowsSpanAvx2(dst + i, a + i, b + i, count - i, w0, w1);
+    }
+#endif
+
+    inline void BlendRowsSpan(uint32_t* dst, const uint32_t* a, const uint32_t* b, int count, uint32_t w0, uint32_t w1) {
+        Kernels().blendRows(dst, a, b, count, w0, w1);
+    }
+
+    // Horizontal bilinear über Index-/Gewichtstabellen; src muss bei index und index + 1 lesbar sein.
+    inline void ResampleRowSpanScalar(uint32_t* dst, const uint32_t* src, const int32_t* index, const uint8_t* frac, int count) {
+        for (int i = 0; i < count; ++i) {
+            const uint32_t p0 = src[index[i]];
+            const uint32_t p1 = src[index[i] + 1];
+            const uint32_t w1 = frac[i];
+            const uint32_t w0 = 256 - w1;
+            const uint32_t rb = ((p0 & 0x00FF00FF) * w0 + (p1 & 0x00FF00FF) * w1 + 0x00800080) >> 8;
+            const uint32_t ag = (((p0 >> 8) & 0x00FF00FF) * w0 + ((p1 >> 8) & 0x00FF00FF) * w1 + 0x00800080) >> 8;
+            dst[i] = (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    // Wie BlendRows mit einem Gewicht pro Pixel: frac als 32-Bit-Lanes [f, f], per unpack auf die vier Kanäle
+    HUD_TARGET("sse2") inline __m128i ResampleLanesSse2(__m128i p0, __m128i p1, __m128i w1) {
+        const __m128i w0 = _mm_sub_epi16(_mm_set1_epi16(256), w1);
+        const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(p0, w0), _mm_mullo_epi16(p1, w1));
+        return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+    }
+
+    HUD_TARGET("sse2") inline void ResampleRowSpanSse2(uint32_t* dst, const uint32_t* src, const int32_t* index, const uint8_t* frac, int count) {
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            // Beide Nachbarn eines Zielpixels mit einem 64-Bit-Load, dann nach p0 und p1 sortiert
+            const int32_t* k = index + i;
+            const __m128i ab = _mm_unpacklo_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + k[0])),
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + k[1])));
+            const __m128i cd = _mm_unpacklo_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + k[2])),
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + k[3])));
+            const __m128i p0 = _mm_unpacklo_epi64(ab, cd);
+            const __m128i p1 = _mm_unpackhi_epi64(ab, cd);
+            int packed;
+            std::memcpy(&packed, frac + i, sizeof(packed));
+            const __m128i f = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+            const __m128i w = _mm_or_si128(f, _mm_slli_epi32(f, 16));
+            const __m128i lo = ResampleLanesSse2(_mm_unpacklo_epi8(p0, zero), _mm_unpacklo_epi8(p1, zero), _mm_unpacklo_epi32(w, w));
+            const __m128i hi = ResampleLanesSse2(_mm_unpackhi_epi8(p0, zero), _mm_unpackhi_epi8(p1, zero), _mm_unpackhi_epi32(w, w));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        ResampleRowSpanScalar(dst + i, src, index + i, frac + i, count - i);
+    }
+
+    HUD_TARGET("avx2") inline __m256i ResampleLanesAvx2(__m256i p0, __m256i p1, __m256i w1) {
+        const __m256i w0 = _mm256_sub_epi16(_mm256_set1_epi16(256), w1);
+        const __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(p0, w0), _mm256_mullo_epi16(p1, w1));
+        return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(128)), 8);
+    }
+
+    HUD_TARGET("avx2") inline void ResampleRowSpanAvx2(uint32_t* dst, const uint32_t* src, const int32_t* index, const uint8_t* frac, int count) {
+        const __m256i zero = _mm256_setzero_si256();
+        const int* base = reinterpret_cast<const int*>(src);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i));
+            const __m256i p0 = _mm256_i32gather_epi32(base, k, 4);
+            const __m256i p1 = _mm256_i32gather_epi32(base + 1, k, 4);
+            const __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(frac + i)));
+            const __m256i w = _mm256_or_si256(f, _mm256_slli_epi32(f, 16));
+            const __m256i lo = ResampleLanesAvx2(_mm256_unpacklo_epi8(p0, zero), _mm256_unpacklo_epi8(p1, zero), _mm256_unpacklo_epi32(w, w));
+            const __m256i hi = ResampleLanesAvx2(_mm256_unpackhi_epi8(p0, zero), _mm256_unpackhi_epi8(p1, zero), _mm256_unpackhi_epi32(w, w));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+        }
+        ResampleRowSpanSse2(dst + i, src, index + i, frac + i, count - i);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline __m512i ResampleLanesAvx512(__m512i p0, __m512i p1, __m512i w1) {
+        const __m512i w0 = _mm512_sub_epi16(_mm512_set1_epi16(256), w1);
+        const __m512i sum = _mm512_add_epi16(_mm512_mullo_epi16(p0, w0), _mm512_mullo_epi16(p1, w1));
+        return _mm512_srli_epi16(_mm512_add_epi16(sum, _mm512_set1_epi16(128)), 8);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void ResampleRowSpanAvx512(uint32_t* dst, const uint32_t* src, const int32_t* index, const uint8_t* frac, int count) {
+        const __m512i zero = _mm512_setzero_si512();
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512i k = _mm512_loadu_si512(index + i);
+            const __m512i p0 = _mm512_i32gather_epi32(k, src, 4);
+            const __m512i p1 = _mm512_i32gather_epi32(k, src + 1, 4);
+            const __m512i f = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(frac + i)));
+            const __m512i w = _mm512_or_si512(f, _mm512_slli_epi32(f, 16));
+            const __m512i lo = ResampleLanesAvx512(_mm512_unpacklo_epi8(p0, zero), _mm512_unpacklo_epi8(p1, zero), _mm512_unpacklo_epi32(w, w));
+            const __m512i hi = ResampleLanesAvx512(_mm512_unpackhi_epi8(p0, zero), _mm512_unpackhi_epi8(p1, zero), _mm512_unpackhi_epi32(w, w));
+            _mm512_storeu_si512(dst + i, _mm512_packus_epi16(lo, hi));
+        }
+        ResampleRowSpanAvx2(dst + i, src, index + i, frac + i, count - i);
+    }
+#endif
+
+    inline void ResampleRowSpan(uint32_t* dst, const uint32_t* src, const int32_t* index, const uint8_t* frac, int count) {
+        Kernels().resampleRow(dst, src, index, frac, count);
+    }
+
+    // Laufende Summe einer Box-Unschärfe über Zeilen: pro Kanal sum += add - sub, vier 16-Bit-Summen pro Pixel
+    inline void BoxSumRowScalar(uint16_t* sum, const uint32_t* add, const uint32_t* sub, int count) {
+        for (int i = 0; i < count; ++i) {
+            for (int c = 0; c < 4; ++c) {
+                const uint32_t plus = (add[i] >> (8 * c)) & 0xFF;
+                const uint32_t minus = (sub[i] >> (8 * c)) & 0xFF;
+                sum[i * 4 + c] = static_cast<uint16_t>(sum[i * 4 + c] + plus - minus);
+            }
+        }
+    }
+
+    // Mittel aus der Summe von n Pixeln: min(((sum + half) * mult) >> 16, 255) mit half = n / 2,
+    // mult = ceil(65536 / n); für 2 <= n < 128 bleibt sum + half in 16 Bit und der Fehler unter 1/2
+    inline void BoxAverageRowScalar(uint32_t* dst, const uint16_t* sum, int count, uint32_t half, uint32_t mult) {
+        for (int i = 0; i < count; ++i) {
+            uint32_t pixel = 0;
+            for (int c = 0; c < 4; ++c) {
+                const uint32_t value = ((sum[i * 4 + c] + half) * mult) >> 16;
+                pixel |= std::min(value, 255u) << (8 * c);
+            }
+            dst[i] = pixel;
+        }
+    }
+
+    // back * factor/256 hinter dst legen: dst + back' * (255 - dst.alpha) / 255, /255 als (x + 128 + ((x + 128) >> 8)) >> 8
+    inline void BlendBehindSpanScalar(uint32_t* dst, const uint32_t* back, int count, uint32_t factor) {
+        for (int i = 0; i < count; ++i) {
+            const uint32_t d = dst[i];
+            const uint32_t inv = 255 - (d >> 24);
+            uint32_t pixel = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                const uint32_t scaled = (((back[i] >> shift) & 0xFF) * factor + 128) >> 8;
+                const uint32_t x = scaled * inv + 128;
+                const uint32_t sum = ((d >> shift) & 0xFF) + ((x + (x >> 8)) >> 8);
+                pixel |= std::min(sum, 255u) << shift;
+            }
+            dst[i] = pixel;
+        }
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline void BoxSumRowSse2(uint16_t* sum, const uint32_t* add, const uint32_t* sub, int count) {
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + i));
+            const __m128i ps = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + i));
+            __m128i* s = reinterpret_cast<__m128i*>(sum + i * 4);
+            const __m128i lo = _mm_sub_epi16(_mm_add_epi16(_mm_loadu_si128(s), _mm_unpacklo_epi8(pa, zero)),
+                _mm_unpacklo_epi8(ps, zero));
+            const __m128i hi = _mm_sub_epi16(_mm_add_epi16(_mm_loadu_si128(s + 1), _mm_unpackhi_epi8(pa, zero)),
+                _mm_unpackhi_epi8(ps, zero));
+            _mm_storeu_si128(s, lo);
+            _mm_storeu_si128(s + 1, hi);
+        }
+        BoxSumRowScalar(sum + i * 4, add + i, sub + i, count - i);
+    }
+
+    HUD_TARGET("avx2") inline void BoxSumRowAvx2(uint16_t* sum, const uint32_t* add, const uint32_t* sub, int count) {
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m256i pa = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(add + i)));
+            const __m256i ps = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + i)));
+            __m256i* s = reinterpret_cast<__m256i*>(sum + i * 4);
+            _mm256_storeu_si256(s, _mm256_sub_epi16(_mm256_add_epi16(_mm256_loadu_si256(s), pa), ps));
+        }
+        BoxSumRowSse2(sum + i * 4, add + i, sub + i, count - i);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void BoxSumRowAvx512(uint16_t* sum, const uint32_t* add, const uint32_t* sub, int count) {
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m512i pa = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(add + i)));
+            const __m512i ps = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sub + i)));
+            uint16_t* s = sum + i * 4;
+            _mm512_storeu_si512(s, _mm512_sub_epi16(_mm512_add_epi16(_mm512_loadu_si512(s), pa), ps));
+        }
+        BoxSumRowAvx2(sum + i * 4, add + i, sub + i, count - i);
+    }
+
+    HUD_TARGET("sse2") inline void BoxAverageRowSse2(uint32_t* dst, const uint16_t* sum, int count, uint32_t half, uint32_t mult) {
+        const __m128i vHalf = _mm_set1_epi16(static_cast<short>(half));
+        const __m128i vMult = _mm_set1_epi16(static_cast<short>(mult));
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i* s = reinterpret_cast<const __m128i*>(sum + i * 4);
+            const __m128i lo = _mm_mulhi_epu16(_mm_add_epi16(_mm_loadu_si128(s), vHalf), vMult);
+            const __m128i hi = _mm_mulhi_epu16(_mm_add_epi16(_mm_loadu_si128(s + 1), vHalf), vMult);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        BoxAverageRowScalar(dst + i, sum + i * 4, count - i, half, mult);
+    }
+
+    HUD_TARGET("avx2") inline void BoxAverageRowAvx2(uint32_t* dst, const uint16_t* sum, int count, uint32_t half, uint32_t mult) {
+        const __m256i vHalf = _mm256_set1_epi16(static_cast<short>(half));
+        const __m256i vMult = _mm256_set1_epi16(static_cast<short>(mult));
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i* s = reinterpret_cast<const __m256i*>(sum + i * 4);
+            const __m256i lo = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_loadu_si256(s), vHalf), vMult);
+            const __m256i hi = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_loadu_si256(s + 1), vHalf), vMult);
+            // packus packt je 128-Bit-Hälfte; die Viertel zurück in Pixelreihenfolge
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+        }
+        BoxAverageRowSse2(dst + i, sum + i * 4, count - i, half, mult);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void BoxAverageRowAvx512(uint32_t* dst, const uint16_t* sum, int count, uint32_t half, uint32_t mult) {
+        const __m512i vHalf = _mm512_set1_epi16(static_cast<short>(half));
+        const __m512i vMult = _mm512_set1_epi16(static_cast<short>(mult));
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m512i value = _mm512_mulhi_epu16(_mm512_add_epi16(_mm512_loadu_si512(sum + i * 4), vHalf), vMult);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm512_cvtusepi16_epi8(value));
+        }
+        BoxAverageRowAvx2(dst + i, sum + i * 4, count - i, half, mult);
+    }
+
+    // Ein Register ausgepackter Pixel (16 Bit pro Kanal); Alpha per Shuffle auf alle vier Kanäle des Pixels
+    HUD_TARGET("sse2") inline __m128i BlendBehindLanesSse2(__m128i d, __m128i back, __m128i factor) {
+        const __m128i round = _mm_set1_epi16(128);
+        const __m128i scaled = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(back, factor), round), 8);
+        __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), d);
+        inv = _mm_shufflehi_epi16(_mm_shufflelo_epi16(inv, 0xFF), 0xFF);
+        const __m128i x = _mm_add_epi16(_mm_mullo_epi16(scaled, inv), round);
+        return _mm_add_epi16(d, _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8));
+    }
+
+    HUD_TARGET("sse2") inline void BlendBehindSpanSse2(uint32_t* dst, const uint32_t* back, int count, uint32_t factor) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i vFactor = _mm_set1_epi16(static_cast<short>(factor));
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            const __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(back + i));
+            const __m128i lo = BlendBehindLanesSse2(_mm_unpacklo_epi8(pd, zero), _mm_unpacklo_epi8(pb, zero), vFactor);
+            const __m128i hi = BlendBehindLanesSse2(_mm_unpackhi_epi8(pd, zero), _mm_unpackhi_epi8(pb, zero), vFactor);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        BlendBehindSpanScalar(dst + i, back + i, count - i, factor);
+    }
+
+    HUD_TARGET("avx2") inline __m256i BlendBehindLanesAvx2(__m256i d, __m256i back, __m256i factor) {
+        const __m256i round = _mm256_set1_epi16(128);
+        const __m256i scaled = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(back, factor), round), 8);
+        __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255), d);
+        inv = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(inv, 0xFF), 0xFF);
+        const __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(scaled, inv), round);
+        return _mm256_add_epi16(d, _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8));
+    }
+
+    HUD_TARGET("avx2") inline void BlendBehindSpanAvx2(uint32_t* dst, const uint32_t* back, int count, uint32_t factor) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i vFactor = _mm256_set1_epi16(static_cast<short>(factor));
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i pd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            const __m256i pb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(back + i));
+            const __m256i lo = BlendBehindLanesAvx2(_mm256_unpacklo_epi8(pd, zero), _mm256_unpacklo_epi8(pb, zero), vFactor);
+            const __m256i hi = BlendBehindLanesAvx2(_mm256_unpackhi_epi8(pd, zero), _mm256_unpackhi_epi8(pb, zero), vFactor);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+        }
+        BlendBehindSpanSse2(dst + i, back + i, count - i, factor);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline __m512i BlendBehindLanesAvx512(__m512i d, __m512i back, __m512i factor) {
+        const __m512i round = _mm512_set1_epi16(128);
+        const __m512i scaled = _mm512_srli_epi16(_mm512_add_epi16(_mm512_mullo_epi16(back, factor), round), 8);
+        __m512i inv = _mm512_sub_epi16(_mm512_set1_epi16(255), d);
+        inv = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(inv, 0xFF), 0xFF);
+        const __m512i x = _mm512_add_epi16(_mm512_mullo_epi16(scaled, inv), round);
+        return _mm512_add_epi16(d, _mm512_srli_epi16(_mm512_add_epi16(x, _mm512_srli_epi16(x, 8)), 8));
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline void BlendBehindSpanAvx512(uint32_t* dst, const uint32_t* back, int count, uint32_t factor) {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i vFactor = _mm512_set1_epi16(static_cast<short>(factor));
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512i pd = _mm512_loadu_si512(dst + i);
+            const __m512i pb = _mm512_loadu_si512(back + i);
+            const __m512i lo = BlendBehindLanesAvx512(_mm512_unpacklo_epi8(pd, zero), _mm512_unpacklo_epi8(pb, zero), vFactor);
+            const __m512i hi = BlendBehindLanesAvx512(_mm512_unpackhi_epi8(pd, zero), _mm512_unpackhi_epi8(pb, zero), vFactor);
+            _mm512_storeu_si512(dst + i, _mm512_packus_epi16(lo, hi));
+        }
+        BlendBehindSpanAvx2(dst + i, back + i, count - i, factor);
+    }
+#endif
+
+    inline void BoxSumRow(uint16_t* sum, const uint32_t* add, const uint32_t* sub, int count) {
+        Kernels().boxSumRow(sum, add, sub, count);
+    }
+
+    inline void BoxAverageRow(uint32_t* dst, const uint16_t* sum, int count, uint32_t half, uint32_t mult) {
+        Kernels().boxAverageRow(dst, sum, count, half, mult);
+    }
+
+    inline void BlendBehindSpan(uint32_t* dst, const uint32_t* back, int count, uint32_t factor) {
+        Kernels().blendBehind(dst, back, count, factor);
+    }
+
+    // Anzahl der Pixel am Anfang, in denen a und b gleich sind (Crossfade: die Farbe ändert sich dort nicht)
+    inline int EqualRunScalar(const uint32_t* a, const uint32_t* b, int count) {
+        int i = 0;
+        while (i < count && a[i] == b[i]) ++i;
+        return i;
+    }
+
+    // Größte Abweichung eines Kanals (A, R, G oder B) zwischen zwei Pixeln
+    inline int ChannelDiff(uint32_t a, uint32_t b) {
+        int diff = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            const int d = std::abs(static_cast<int>((a >> shift) & 0xFF) - static_cast<int>((b >> shift) & 0xFF));
+            diff = std::max(diff, d);
+        }
+        return diff;
+    }
+
+    // Zählt Pixel mit einem Kanal über tolerance (0..255); maxDiff wächst auf die größte Kanalabweichung
+    inline int DiffSpanScalar(const uint32_t* a, const uint32_t* b, int count, int tolerance, int& maxDiff) {
+        int failing = 0;
+        for (int i = 0; i < count; ++i) {
+            const int d = ChannelDiff(a[i], b[i]);
+            maxDiff = std::max(maxDiff, d);
+            if (d > tolerance) failing++;
+        }
+        return failing;
+    }
+
+#if defined(HUD_SIMD_DISPATCH)
+    HUD_TARGET("sse2") inline int EqualRunSse2(const uint32_t* a, const uint32_t* b, int count) {
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(pa, pb)) != 0xFFFF) break;
+        }
+        return i + EqualRunScalar(a + i, b + i, count - i);
+    }
+
+    HUD_TARGET("avx2") inline int EqualRunAvx2(const uint32_t* a, const uint32_t* b, int count) {
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i pa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const __m256i pb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(pa, pb)) != -1) break;
+        }
+        return i + EqualRunSse2(a + i, b + i, count - i);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline int EqualRunAvx512(const uint32_t* a, const uint32_t* b, int count) {
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            if (_mm512_cmpeq_epi32_mask(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i)) != 0xFFFF) break;
+        }
+        return i + EqualRunAvx2(a + i, b + i, count - i);
+    }
+
+    // Kanalabstand per sättigender Subtraktion in beide Richtungen; bestanden = alle vier Kanäle <= Toleranz
+    HUD_TARGET("sse2") inline int DiffSpanSse2(const uint32_t* a, const uint32_t* b, int count, int tolerance, int& maxDiff) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i vTol = _mm_set1_epi8(static_cast<char>(tolerance));
+        __m128i vMax = zero, vPass = zero;
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            const __m128i d = _mm_or_si128(_mm_subs_epu8(pa, pb), _mm_subs_epu8(pb, pa));
+            vMax = _mm_max_epu8(vMax, d);
+            vPass = _mm_sub_epi32(vPass, _mm_cmpeq_epi32(_mm_subs_epu8(d, vTol), zero));
+        }
+        uint8_t bytes[16];
+        int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), vMax);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), vPass);
+        int failing = i;
+        for (int k = 0; k < 4; ++k) failing -= lanes[k];
+        for (int k = 0; k < 16; ++k) maxDiff = std::max(maxDiff, static_cast<int>(bytes[k]));
+        return failing + DiffSpanScalar(a + i, b + i, count - i, tolerance, maxDiff);
+    }
+
+    HUD_TARGET("avx2") inline int DiffSpanAvx2(const uint32_t* a, const uint32_t* b, int count, int tolerance, int& maxDiff) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i vTol = _mm256_set1_epi8(static_cast<char>(tolerance));
+        __m256i vMax = zero, vPass = zero;
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i pa = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const __m256i pb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            const __m256i d = _mm256_or_si256(_mm256_subs_epu8(pa, pb), _mm256_subs_epu8(pb, pa));
+            vMax = _mm256_max_epu8(vMax, d);
+            vPass = _mm256_sub_epi32(vPass, _mm256_cmpeq_epi32(_mm256_subs_epu8(d, vTol), zero));
+        }
+        uint8_t bytes[32];
+        int32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(bytes), vMax);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), vPass);
+        int failing = i;
+        for (int k = 0; k < 8; ++k) failing -= lanes[k];
+        for (int k = 0; k < 32; ++k) maxDiff = std::max(maxDiff, static_cast<int>(bytes[k]));
+        return failing + DiffSpanSse2(a + i, b + i, count - i, tolerance, maxDiff);
+    }
+
+    HUD_TARGET("avx512f,avx512bw") inline int DiffSpanAvx512(const uint32_t* a, const uint32_t* b, int count, int tolerance, int& maxDiff) {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i one = _mm512_set1_epi32(1);
+        const __m512i vTol = _mm512_set1_epi8(static_cast<char>(tolerance));
+        __m512i vMax = zero, vPass = zero;
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m512i pa = _mm512_loadu_si512(a + i);
+            const __m512i pb = _mm512_loadu_si512(b + i);
+            const __m512i d = _mm512_or_si512(_mm512_subs_epu8(pa, pb), _mm512_subs_epu8(pb, pa));
+            vMax = _mm512_max_epu8(vMax, d);
+            vPass = _mm512_mask_add_epi32(vPass, _mm512_cmpeq_epi32_mask(_mm512_subs_epu8(d, vTol), zero), vPass, one);
+        }
+        uint8_t bytes[64];
+        int32_t lanes[16];
+        _mm512_storeu_si512(bytes, vMax);
+        _mm512_storeu_si512(lanes, vPass);
+        int failing = i;
+        for (int k = 0; k < 16; ++k) failing -= lanes[k];
+        for (int k = 0; k < 64; ++k) maxDiff = std::max(maxDiff, static_cast<int>(bytes[k]));
+        return failing + DiffSpanAvx2(a + i, b + i, count - i, tolerance, maxDiff);
+    }
+#endif
+
+    inline int EqualRun(const uint32_t* a, const uint32_t* b, int count) {
+        return Kernels().equalRun(a, b, count);
+    }
+
+    // Zählt Pixel mit einem Kanal außerhalb der Toleranz; maxDiff wächst auf die größte Kanalabweichung.
+    inline int DiffSpan(const uint32_t* a, const uint32_t* b, int count, int tolerance, int& maxDiff) {
+        return Kernels().diff(a, b, count, std::min(std::max(tolerance, 0), 255), maxDiff);
+    }
+
+    // Höchste Stufe, die CPU und Betriebssystem (gesicherte YMM-/ZMM-Register) tragen
+    inline SimdLevel DetectSimdLevel() {
+#if defined(HUD_SIMD_DISPATCH)
+        auto cpuid = [](unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+            int values[4];
+            __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+            for (int k = 0; k < 4; ++k) regs[k] = static_cast<unsigned>(values[k]);
+#else
+            __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        };
+
+        unsigned regs[4];
+        cpuid(0, 0, regs);
+        const unsigned maxLeaf = regs[0];
+        cpuid(1, 0, regs);
+        if (!(regs[3] & (1u << 26))) return SimdLevel::Scalar;
+        const bool osxsave = (regs[2] & (1u << 27)) != 0, avx = (regs[2] & (1u << 28)) != 0;
+        if (!osxsave || !avx || maxLeaf < 7) return SimdLevel::SSE2;
+
+#if defined(_MSC_VER)
+        const unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned xcr0Low = 0, xcr0High = 0;
+        __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+        const unsigned long long xcr0 = (static_cast<unsigned long long>(xcr0High) << 32) | xcr0Low;
+#endif
+        if ((xcr0 & 0x06) != 0x06) return SimdLevel::SSE2;     // XMM + YMM
+
+        cpuid(7, 0, regs);
+        if (!(regs[1] & (1u << 5))) return SimdLevel::SSE2;
+        const bool avx512 = (regs[1] & (1u << 16)) && (regs[1] & (1u << 30));     // F + BW
+        return (avx512 && (xcr0 & 0xE6) == 0xE6) ? SimdLevel::AVX512 : SimdLevel::AVX2;   // + Opmask, ZMM
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    inline const SpanKernels& KernelsFor(SimdLevel level) {
+        static const SpanKernels tables[] = {
+            { SimdLevel::Scalar, &BlendSolidSpanScalar, &BlendGlowSpanScalar, &RadialFalloffSpanScalar,
+                &ArcCoverageSpanScalar, &ScaleAlphaSpanScalar, &BlendRowsSpanScalar, &ResampleRowSpanScalar,
+                &BoxSumRowScalar, &BoxAverageRowScalar, &BlendBehindSpanScalar, &EqualRunScalar, &DiffSpanScalar },
+#if defined(HUD_SIMD_DISPATCH)
+            { SimdLevel::SSE2, &BlendSolidSpanSse2, &BlendGlowSpanSse2, &RadialFalloffSpanSse2,
+                &ArcCoverageSpanSse2, &ScaleAlphaSpanSse2, &BlendRowsSpanSse2, &ResampleRowSpanSse2,
+                &BoxSumRowSse2, &BoxAverageRowSse2, &BlendBehindSpanSse2, &EqualRunSse2, &DiffSpanSse2 },
+            { SimdLevel::AVX2, &BlendSolidSpanAvx2, &BlendGlowSpanAvx2, &RadialFalloffSpanAvx2,
+                &ArcCoverageSpanAvx2, &ScaleAlphaSpanAvx2, &BlendRowsSpanAvx2, &ResampleRowSpanAvx2,
+                &BoxSumRowAvx2, &BoxAverageRowAvx2, &BlendBehindSpanAvx2, &EqualRunAvx2, &DiffSpanAvx2 },
+            { SimdLevel::AVX512, &BlendSolidSpanAvx512, &BlendGlowSpanAvx512, &RadialFalloffSpanAvx512,
+                &ArcCoverageSpanAvx512, &ScaleAlphaSpanAvx512, &BlendRowsSpanAvx512, &ResampleRowSpanAvx512,
+                &BoxSumRowAvx512, &BoxAverageRowAvx512, &BlendBehindSpanAvx512, &EqualRunAvx512, &DiffSpanAvx512 },
+#endif
+        };
+        const size_t index = std::min(static_cast<size_t>(level), sizeof(tables) / sizeof(tables[0]) - 1);
+        return tables[index];
+    }
+
+    inline const SpanKernels*& ActiveKernels() {
+        static const SpanKernels* active = &KernelsFor(DetectSimdLevel());
+        return active;
+    }
+
+    inline const SpanKernels& Kernels() {
+        return *ActiveKernels();
+    }
+
+    // Nur beim Start oder zwischen zwei Frames (Worker lesen die Tabelle ohne Sperre); höher als die CPU
+    // kann wird auf die erkannte Stufe begrenzt. Rückgabe = tatsächlich gewählte Stufe.
+    inline SimdLevel SelectKernels(SimdLevel requested) {
+        const SimdLevel level = std::min(requested, DetectSimdLevel());
+        ActiveKernels() = &KernelsFor(level);
+        return ActiveKernels()->level;
+    }
+
+    inline const char* SimdLevelName(SimdLevel level) {
+        static const char* const names[] = { "scalar", "sse2", "avx2", "avx512" };
+        return names[static_cast<size_t>(level)];
+    }
+
+    // Name wie SimdLevelName, z. B. für "--simd avx2"
+    inline bool ParseSimdLevel(const std::wstring& name, SimdLevel& level) {
+        for (int k = 0; k <= static_cast<int>(SimdLevel::AVX512); ++k) {
+            const std::string text = SimdLevelName(static_cast<SimdLevel>(k));
+            if (name == std::wstring(text.begin(), text.end())) {
+                level = static_cast<SimdLevel>(k);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline float DecodeSrgb(float c) {
+        return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline float EncodeSrgb(float l) {
+        return (l <= 0.0031308f) ? 12.92f * l : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // sRGB <-> linear über Tabellen; 12 Bit zurück reichen für höchstens 1 LSB Fehler und exakten Roundtrip
+    struct LinearLightTables {
+        static constexpr int LINEAR_SHIFT = 4;          // 16 Bit linear -> 12 Bit Tabellenindex
+        static constexpr int SRGB_ENTRIES = 4097;       // letzter Eintrag fängt 65535 aufgerundet ab, spart das Clamp
+
+        int32_t toLinear[256];                          // sRGB 8 Bit -> linear 16 Bit
+        uint8_t toSrgb[SRGB_ENTRIES];
+
+        LinearLightTables() {
+            for (int v = 0; v < 256; ++v) {
+                toLinear[v] = static_cast<int32_t>(std::lrint(DecodeSrgb(v / 255.0f) * 65535.0f));
+            }
+            for (int i = 0; i < SRGB_ENTRIES; ++i) {
+                const float l = std::min(1.0f, static_cast<float>(i << LINEAR_SHIFT) / 65535.0f);
+                toSrgb[i] = static_cast<uint8_t>(std::lrint(EncodeSrgb(l) * 255.0f));
+            }
+        }
+    };
+
+    inline const LinearLightTables& LinearLight() {
+        static const LinearLightTables tables;
+        return tables;
+    }
+
+    // dst = from * (1 - weight / 256) + to * weight / 256, gemischt in linearem Licht.
+    // Vormultiplizierte Kanäle werden direkt linearisiert: bei gleichem Alpha beider Bilder (gleiche Geometrie,
+    // nur andere Farbe) ist das bis auf den linearen Anfang der sRGB-Kurve dasselbe wie vorher zu entmultiplizieren.
+    // Beide Bilder haben nur wenige hundert verschiedene Pixelpaare (Glow-Verlauf, Ringkanten), deshalb rechnet
+    // ein direkt abgebildeter Paar-Cache jedes Paar einmal pro Gewicht; gleiche Pixel gehen blockweise per SIMD durch.
+    class LinearCrossfade {
+    public:
+        void Prepare(int newWeight) {
+            weight = std::max(0, std::min(256, newWeight));
+            const LinearLightTables& tables = LinearLight();
+            for (int v = 0; v < 256; ++v) {
+                fromLinear[v] = tables.toLinear[v] * (256 - weight);
+                toLinear[v] = tables.toLinear[v] * weight;
+            }
+            // a == b kommt nie in den Cache, Nullen sind also leere Einträge
+            cache.assign(CACHE_SIZE, Entry());
+        }
+
+        void Release() {
+            std::vector<Entry>().swap(cache);
+            weight = 256;
+        }
+
+        // dst darf to sein
+        void Span(uint32_t* dst, const uint32_t* from, const uint32_t* to, int count) {
+            if (weight == 0 || weight == 256) {
+                const uint32_t* src = (weight == 0) ? from : to;
+                if (dst != src) std::memcpy(dst, src, static_cast<size_t>(count) * sizeof(uint32_t));
+                return;
+            }
+
+            // Gleiche Pixel am Stück per SIMD, die übrigen einzeln über den Paar-Cache
+            int i = 0;
+            while (i < count) {
+                const int equal = EqualRun(from + i, to + i, count - i);
+                if (dst != to) std::memcpy(dst + i, to + i, static_cast<size_t>(equal) * sizeof(uint32_t));
+                for (i += equal; i < count && from[i] != to[i]; ++i) dst[i] = Pixel(from[i], to[i]);
+            }
+        }
+
+    private:
+        static constexpr int CACHE_BITS = 12;
+        static constexpr size_t CACHE_SIZE = size_t(1) << CACHE_BITS;
+        static constexpr int INDEX_SHIFT = 8 + LinearLightTables::LINEAR_SHIFT;
+
+        struct Entry {
+            uint32_t from = 0, to = 0, mixed = 0;
+        };
+
+        uint32_t Pixel(uint32_t a, uint32_t b) {
+            if (a == b) return a;
+            Entry& entry = cache[((a * 0x9E3779B1u) ^ (b * 0x85EBCA77u)) >> (32 - CACHE_BITS)];
+            if (entry.from != a || entry.to != b) {
+                entry.from = a;
+                entry.to = b;
+                entry.mixed = Mix(a, b);
+            }
+            return entry.mixed;
+        }
+
+        uint32_t Mix(uint32_t a, uint32_t b) const {
+            const uint8_t* srgb = LinearLight().toSrgb;
+            const uint32_t alpha = ((a >> 24) * (256 - weight) + (b >> 24) * weight + 128) >> 8;
+            uint32_t out = alpha << 24;
+            for (int shift = 0; shift < 24; shift += 8) {
+                const uint32_t c = srgb[(fromLinear[(a >> shift) & 0xFF] + toLinear[(b >> shift) & 0xFF]
+                    + (1 << (INDEX_SHIFT - 1))) >> INDEX_SHIFT];
+                out |= std::min(c, alpha) << shift;
+            }
+            return out;
+        }
+
+        int weight = 256;
+        int32_t fromLinear[256] = {};                   // linear * (256 - weight)
+        int32_t toLinear[256] = {};                     // linear * weight
+        std::vector<Entry> cache;
+    };
+}
+
+struct RenderContext {
+    Surface surface;
+    Graphics* graphics = nullptr;   // nur für das GDI+-Backend
+};
+
+struct GeometryCacheStats {
+    unsigned builds = 0;
+    unsigned hits = 0;
+    size_t bytes = 0;
+};
+
+class IHudRasterizer {
+public:
+    virtual ~IHudRasterizer() = default;
+    virtual void Draw(const RenderContext& ctx, const FrameParams& params) = 0;
+    virtual GeometryCacheStats RingCacheStats() const = 0;
+    virtual void SetTheme(const ThemeProgram& theme) = 0;     // verwirft alle aus dem alten Theme gebauten Caches
+
+    // Kreis um die Mitte, außerhalb dessen der letzte Draw nichts gezeichnet hat; 0 = unbekannt
+    virtual float ContentRadius() const { return 0.0f; }
+
+    // ctx.surface zeigt den Frame für params mit der zuletzt gezeigten Zahl statt params.percent. Zeichnet nur die Rechtecke neu,
+    // in denen sich dadurch etwas ändern kann, und liefert sie zurück; 0 = geht nicht, ganz neu zeichnen.
+    virtual int RedrawPercent(const RenderContext&, BYTE, const FrameParams&, PixelRect*) {
+        return 0;
+    }
+};
+
+using RasterizerFactory = std::unique_ptr<IHudRasterizer> (*)();
+
+// Kleiner Thread-Pool für Kachelarbeit: jeder Worker hat eine eigene Deque und stiehlt vom Ende der anderen,
+// wenn seine leer ist. Der aufrufende Thread arbeitet als Worker 0 mit.
+class WorkStealingPool {
+public:
+    struct Stats {
+        unsigned jobs = 0;
+        unsigned tasks = 0;
+        unsigned steals = 0;
+    };
+
+    explicit WorkStealingPool(int threadCount) {
+        const int count = std::max(1, threadCount);
+        for (int i = 0; i < count; ++i) queues.push_back(std::make_unique<Queue>());
+        for (int i = 1; i < count; ++i) threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    int ThreadCount() const { return static_cast<int>(queues.size()); }
+
+    // fn(index, worker) für alle index in [0, count); kehrt erst zurück, wenn alles erledigt ist
+    template<typename Fn>
+    void Run(int count, Fn& fn) {
+        RunErased(count, &Invoke<Fn>, &fn);
+    }
+
+    Stats GetStats() const {
+        Stats result = stats;
+        result.steals = steals.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    typedef void (*TaskFn)(void* context, int index, int worker);
+
+    // Jede Aufgabe trägt ihren Job mit, damit ein verspäteter Worker nie mit veralteten Daten arbeitet
+    struct Item {
+        TaskFn fn;
+        void* context;
+        int index;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Item> items;
+    };
+
+    template<typename Fn>
+    static void Invoke(void* context, int index, int worker) {
+        (*static_cast<Fn*>(context))(index, worker);
+    }
+
+    void RunErased(int count, TaskFn fn, void* context) {
+        if (count <= 0) return;
+
+        // Zähler vor den Aufgaben setzen: ein Worker, der noch im letzten Drain hängt, greift sofort zu
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            remaining = count;
+            generation++;
+        }
+
+        // Gleichmäßig vorverteilen; Ungleichgewicht gleicht das Stehlen aus
+        for (int i = 0; i < count; ++i) {
+            Queue& queue = *queues[i % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.items.push_back({ fn, context, i });
+        }
+        wake.notify_all();
+
+        Drain(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return remaining == 0; });
+        stats.jobs++;
+        stats.tasks += count;
+    }
+
+    bool Pop(int worker, Item& item) {
+        {
+            Queue& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.items.empty()) {
+                item = own.items.front();
+                own.items.pop_front();
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            Queue& victim = *queues[(worker + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.items.empty()) {
+                item = victim.items.back();
+                victim.items.pop_back();
+                steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Drain(int worker) {
+        Item item;
+        while (Pop(worker, item)) {
+            item.fn(item.context, item.index, worker);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) done.notify_all();
+        }
+    }
+
+    void WorkerLoop(int worker) {
+        unsigned seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            Drain(worker);
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    int remaining = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+    std::atomic<unsigned> steals{ 0 };
+    Stats stats;
+};
+
+// Zeichnet das HUD komplett in Software (ohne GDI+), läuft also auch headless.
+// Große Flächen werden in Zeilenstreifen aufgeteilt und parallel gezeichnet; jedes Pixel wird dabei
+// exakt wie im Single-Thread-Pfad berechnet.
+class SoftwareHudRasterizer : public IHudRasterizer {
+public:
+    struct TileStats {
+        unsigned parallelFrames = 0;
+        unsigned tilesDrawn = 0;
+        unsigned tilesCulled = 0;
+    };
+
+    struct PercentStats {
+        unsigned baseBuilds = 0;
+    };
+
+    explicit SoftwareHudRasterizer(GlyphSourceFactory glyphSourceFactory = &BitmapFontGlyphSource::Create,
+        int baseSize = Config::HUD_SIZE)
+        : glyphSourceFactory(glyphSourceFactory), buckets(baseSize) {}
+
+    void Draw(const RenderContext& ctx, const FrameParams& params) override {
+        const Surface& surface = ctx.surface;
+        contentRadius = 0.0f;
+        if (!surface.IsValid() || params.alpha <= 0 || params.scale <= 0.0f) return;
+
+        Layers& layers = buckets.Get(params.dpiScale);
+        const FramePlan plan = Prepare(layers, params);
+        contentRadius = plan.contentRadius;
+
+        if (surface.width * surface.height < Config::PARALLEL_MIN_PIXELS || ThreadCount() <= 1) {
+            DrawRect(surface, PixelRect::Of(surface), plan, 0, plan.opCount, scratch.front());
+            return;
+        }
+
+        CollectTiles(surface, plan);
+        auto drawTile = [&](int index, int worker) {
+            DrawRect(surface, tiles[index], plan, 0, plan.opCount, scratch[worker]);
+        };
+        pool->Run(static_cast<int>(tiles.size()), drawTile);
+        tileStats.parallelFrames++;
+        tileStats.tilesDrawn += static_cast<unsigned>(tiles.size());
+    }
+
+    // Kein Ring-Cache: die Abstandsfunktion ist exakt und billiger als das Einblenden gecachter Abdeckung
+    GeometryCacheStats RingCacheStats() const override { return GeometryCacheStats(); }
+
+    void SetTheme(const ThemeProgram& program) override {
+        theme = program;
+        buckets.Clear();
+        baseValid = false;
+    }
+
+    // 0 = Config::RASTER_THREADS bzw. Anzahl Kerne
+    void SetThreadCount(int count) {
+        requestedThreads = count;
+        pool.reset();
+    }
+
+    int ThreadCount() {
+        EnsurePool();
+        return pool->ThreadCount();
+    }
+
+    const TileStats& GetTileStats() const { return tileStats; }
+    const PercentStats& GetPercentStats() const { return percentStats; }
+
+    float ContentRadius() const override { return contentRadius; }
+
+    // Ändern sich nur Bogenende und Text: in deren Rechtecken die Basisebene zurückkopieren (alle Ebenen vor der
+    // ersten prozentabhängigen, einmal pro Parametersatz gezeichnet) und nur die übrigen Ebenen neu zeichnen.
+    // Der Glow des eingebauten Themes liegt in der Basis und wird dabei nie neu gerastert.
+    int RedrawPercent(const RenderContext& ctx, BYTE shownPercent, const FrameParams& params, PixelRect* rects) override {
+        const Surface& surface = ctx.surface;
+        if (!surface.IsValid() || params.alpha <= 0 || params.scale <= 0.0f) return 0;
+
+        Layers& layers = buckets.Get(params.dpiScale);
+        FrameParams shownParams = params;
+        shownParams.percent = shownPercent;
+        const FramePlan shown = Prepare(layers, shownParams);
+        const FramePlan plan = Prepare(layers, params);
+
+        int split = 0;
+        while (split < plan.opCount && !plan.ops[split].percentDependent) ++split;
+        if (split == plan.opCount) return 0;
+        const Surface base = EnsureBase(layers, params, plan, split);
+
+        int count = 0;
+        for (int i = split; i < plan.opCount; ++i) {
+            PixelRect rect;
+            if (plan.ops[i].kind == ThemeOp::Arc && plan.ops[i].percentDependent) {
+                rect = ArcDelta(shown.ops[i].arc, plan.ops[i].arc);
+            }
+            else if (plan.ops[i].kind == ThemeOp::Text) {
+                rect = PixelRect::Hull(TextBounds(shown), TextBounds(plan));
+            }
+            rect.x0 = std::max(rect.x0, 0);
+            rect.y0 = std::max(rect.y0, 0);
+            rect.x1 = std::min(rect.x1, surface.width);
+            rect.y1 = std::min(rect.y1, surface.height);
+            if (!rect.IsEmpty()) count = AddMerged(rects, count, rect);
+        }
+
+        for (int r = 0; r < count; ++r) {
+            const PixelRect& rect = rects[r];
+            for (int y = rect.y0; y < rect.y1; ++y) {
+                std::memcpy(surface.Row(y) + rect.x0, base.Row(y) + rect.x0, static_cast<size_t>(rect.x1 - rect.x0) * sizeof(uint32_t));
+            }
+            DrawRect(surface, rect, plan, split, plan.opCount, scratch.front());
+        }
+        contentRadius = plan.contentRadius;
+        return count;
+    }
+
+private:
+    struct Layers {
+        explicit Layers(const HudMetrics& metrics) : metrics(metrics) {}
+
+        HudMetrics metrics;
+        GlyphAtlas glyphAtlas;
+    };
+
+    // Alles, was ein Frame braucht; nach Prepare nur noch lesend, damit Kacheln parallel laufen können
+    struct FramePlan {
+        struct Op {
+            ThemeOp::Kind kind = ThemeOp::Glow;
+            bool percentDependent = false;                      // Bogen bis zum Prozentwert, Text
+            uint32_t rgb = 0;
+            float alpha = 0.0f;
+            float radius = 0.0f;                                // Glow
+            Raster::ArcGeometry arc = Raster::ArcGeometry(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+        };
+
+        float center = 0.0f;
+        float scale = 0.0f;
+        Op ops[Config::MAX_THEME_OPS];
+        int opCount = 0;
+        const GlyphAtlas* atlas = nullptr;
+        GlyphAtlas::PlacedGlyph placed[GlyphAtlas::MAX_LAYOUT];
+        int glyphCount = 0;
+        float originX = 0.0f;
+        float originY = 0.0f;
+        float contentRadius = 0.0f;                         // alles Gezeichnete liegt in diesem Kreis
+    };
+
+    // Theme-Ebenen mit den Werten dieses Frames auflösen; kein Parsen, keine Allokation außer beim ersten Mal pro Cache
+    FramePlan Prepare(Layers& layers, const FrameParams& params) {
+        const HudMetrics& m = layers.metrics;
+        FramePlan plan;
+        plan.center = m.center;
+        plan.scale = params.scale;
+
+        const uint32_t stateRgb = params.themeArgb & 0x00FFFFFF;
+        const float alpha = params.alpha / 255.0f;
+        bool hasText = false;
+
+        for (int i = 0; i < theme.opCount; ++i) {
+            const ThemeOp& src = theme.ops[i];
+            if (src.kind == ThemeOp::Glow && params.quality != RenderQuality::Full) continue;
+            FramePlan::Op& op = plan.ops[plan.opCount++];
+            op.kind = src.kind;
+            op.rgb = src.stateColor ? stateRgb : src.rgb;
+
+            switch (src.kind) {
+            case ThemeOp::Glow:
+                op.radius = src.radius * m.scale * params.scale;
+                op.alpha = std::floor(params.alpha * src.alpha);      // 0.25 ergibt alpha / 4 wie bisher
+                plan.contentRadius = std::max(plan.contentRadius, op.radius);
+                break;
+            case ThemeOp::Arc: {
+                const BYTE sweepPercent = src.fullSweep ? 100 : params.percent;
+                op.percentDependent = !src.fullSweep;
+                op.alpha = alpha * src.alpha;
+                op.arc = Raster::ArcGeometry(m.center, m.center, src.radius * m.scale * params.scale,
+                    src.width * m.scale * 0.5f * params.scale, -90.0f, 360.0f * (sweepPercent / 100.0f));
+                plan.contentRadius = std::max(plan.contentRadius, op.arc.radius + op.arc.halfWidth + 1.0f);
+                break;
+            }
+            case ThemeOp::Text:
+                op.percentDependent = true;
+                op.alpha = alpha * src.alpha;
+                hasText = true;
+                break;
+            }
+        }
+        if (!hasText) return plan;
+
+        GlyphAtlas& atlas = layers.glyphAtlas;
+        if (!atlas.IsBuilt()) {
+            std::unique_ptr<IGlyphSource> source = glyphSourceFactory(theme.fontSize * m.scale, theme.fontFamily);
+            if (!source || !atlas.Build(*source)) return plan;
+        }
+
+        float totalWidth;
+        plan.atlas = &atlas;
+        plan.glyphCount = atlas.Layout(params.percent, plan.placed, totalWidth);
+        plan.originX = plan.center - totalWidth * 0.5f;
+        plan.originY = plan.center - atlas.LineHeight() * 0.5f;
+
+        for (int i = 0; i < plan.glyphCount; ++i) {
+            const GlyphAtlas::Entry& e = *plan.placed[i].entry;
+            const float left = plan.originX + plan.placed[i].x + e.offsetX - plan.center;
+            const float top = plan.originY + e.offsetY - plan.center;
+            const float dx = std::max(std::fabs(left), std::fabs(left + e.width));
+            const float dy = std::max(std::fabs(top), std::fabs(top + e.height));
+            plan.contentRadius = std::max(plan.contentRadius, std::sqrt(dx * dx + dy * dy) * plan.scale + 1.0f);
+        }
+        return plan;
+    }
+
+    // Replay der Display-Liste, Ebenen [firstOp, endOp)
+    void DrawRect(const Surface& surface, const PixelRect& clip, const FramePlan& plan, int firstOp, int endOp,
+        std::vector<float>& rowScratch) {
+        for (int i = firstOp; i < endOp; ++i) {
+            const FramePlan::Op& op = plan.ops[i];
+            switch (op.kind) {
+            case ThemeOp::Glow:
+                Raster::FillRadialGradient(surface, clip, plan.center, plan.center, op.radius, op.rgb, op.alpha, rowScratch);
+                break;
+            case ThemeOp::Arc:
+                Raster::StrokeArc(surface, clip, op.arc, op.rgb, op.alpha, rowScratch);
+                break;
+            case ThemeOp::Text:
+                for (int g = 0; g < plan.glyphCount; ++g) {
+                    const GlyphAtlas::Entry& e = *plan.placed[g].entry;
+                    Raster::BlitMaskScaled(surface, clip, plan.atlas->Coverage(), plan.atlas->Width(),
+                        e.atlasX, e.width, e.height,
+                        plan.originX + plan.placed[g].x + e.offsetX, plan.originY + e.offsetY,
+                        plan.scale, plan.center, plan.center, op.rgb, op.alpha, rowScratch);
+                }
+                break;
+            }
+        }
+    }
+
+    // Streifen ohne Inhalt (außerhalb des Glow-Kreises) gar nicht erst verteilen. Volle Breite, weil
+    // schmale Kacheln mit großem Zeilenabstand den Speicherzugriff mehr kosten als die Aufteilung bringt;
+    // innerhalb eines Streifens berühren die Spans ohnehin nur die Sehne des Kreises.
+    void CollectTiles(const Surface& surface, const FramePlan& plan) {
+        tiles.clear();
+        const int rows = Config::RASTER_TILE_ROWS;
+
+        for (int y = 0; y < surface.height; y += rows) {
+            PixelRect tile;
+            tile.x1 = surface.width;
+            tile.y0 = y;
+            tile.y1 = std::min(surface.height, y + rows);
+
+            const float nearestY = Utils::Clamp(plan.center, static_cast<float>(tile.y0), static_cast<float>(tile.y1));
+            if (std::fabs(nearestY - plan.center) > plan.contentRadius) {
+                tileStats.tilesCulled++;
+                continue;
+            }
+            tiles.push_back(tile);
+        }
+    }
+
+    void EnsurePool() {
+        if (pool) return;
+        int count = (requestedThreads > 0) ? requestedThreads : Config::RASTER_THREADS;
+        if (count <= 0) {
+            count = std::min(static_cast<int>(std::thread::hardware_concurrency()), Config::MAX_RASTER_THREADS);
+        }
+        pool = std::make_unique<WorkStealingPool>(std::max(1, count));
+        scratch.resize(pool->ThreadCount());
+    }
+
+    // Ebenen vor `split` für params ohne Prozentwert; neu gezeichnet nur, wenn sich etwas anderes geändert hat
+    Surface EnsureBase(Layers& layers, const FrameParams& params, const FramePlan& plan, int split) {
+        FrameParams key = params;
+        key.percent = 0;
+        const int size = layers.metrics.size;
+        Surface base = { nullptr, size, size, size };
+        if (baseValid && key == baseParams && baseSplit == split && basePixels.size() == static_cast<size_t>(size) * size) {
+            base.pixels = basePixels.data();
+            return base;
+        }
+
+        basePixels.assign(static_cast<size_t>(size) * size, 0);
+        base.pixels = basePixels.data();
+        DrawRect(base, PixelRect::Of(base), plan, 0, split, scratch.front());
+        baseParams = key;
+        baseSplit = split;
+        baseValid = true;
+        percentStats.baseBuilds++;
+        return base;
+    }
+
+    // Pixel, deren Abdeckung sich zwischen zwei Sweeps desselben Bogens ändern kann: der Keil zwischen beiden
+    // Enden im Band um den Radius und die Kappen an beiden Enden (bei vollem Kreis auch am Anfang)
+    static PixelRect ArcDelta(const Raster::ArcGeometry& a, const Raster::ArcGeometry& b) {
+        const float reach = a.halfWidth + 1.5f;     // Antialiasing plus halbe Pixeldiagonale
+        float minX = a.cx, maxX = a.cx, minY = a.cy, maxY = a.cy;
+        bool first = true;
+        auto include = [&](float x, float y, float extent) {
+            if (first) {
+                minX = maxX = x;
+                minY = maxY = y;
+                first = false;
+            }
+            minX = std::min(minX, x - extent);
+            maxX = std::max(maxX, x + extent);
+            minY = std::min(minY, y - extent);
+            maxY = std::max(maxY, y + extent);
+        };
+
+        constexpr float degToRad = 3.14159265358979f / 180.0f;
+        const float from = -90.0f + std::min(a.sweep, b.sweep);
+        const float to = -90.0f + std::max(a.sweep, b.sweep);
+        const float inner = std::max(0.0f, a.radius - reach);
+        for (float deg : { from, to }) {
+            include(a.cx + std::cos(deg * degToRad) * a.radius, a.cy + std::sin(deg * degToRad) * a.radius, reach);
+            include(a.cx + std::cos(deg * degToRad) * inner, a.cy + std::sin(deg * degToRad) * inner, 0.0f);
+        }
+        for (int quarter = static_cast<int>(std::ceil(from / 90.0f)); quarter * 90.0f <= to; ++quarter) {
+            include(a.cx + std::cos(quarter * 90.0f * degToRad) * a.radius,
+                a.cy + std::sin(quarter * 90.0f * degToRad) * a.radius, reach);
+        }
+        if (std::max(a.sweep, b.sweep) >= 360.0f) {
+            include(a.cx + a.sx * a.radius, a.cy + a.sy * a.radius, reach);
+        }
+
+        PixelRect rect;
+        rect.x0 = static_cast<int>(std::floor(minX));
+        rect.y0 = static_cast<int>(std::floor(minY));
+        rect.x1 = static_cast<int>(std::ceil(maxX)) + 1;
+        rect.y1 = static_cast<int>(std::ceil(maxY)) + 1;
+        return rect;
+    }
+
+    // Wie BlitMaskScaled die Glyphen platziert
+    static PixelRect TextBounds(const FramePlan& plan) {
+        PixelRect bounds;
+        for (int g = 0; g < plan.glyphCount; ++g) {
+            const GlyphAtlas::Entry& e = *plan.placed[g].entry;
+            const float left = plan.center + (plan.originX + plan.placed[g].x + e.offsetX - plan.center) * plan.scale;
+            const float top = plan.center + (plan.originY + e.offsetY - plan.center) * plan.scale;
+            PixelRect glyph;
+            glyph.x0 = static_cast<int>(std::floor(left));
+            glyph.y0 = static_cast<int>(std::floor(top));
+            glyph.x1 = static_cast<int>(std::ceil(left + e.width * plan.scale));
+            glyph.y1 = static_cast<int>(std::ceil(top + e.height * plan.scale));
+            bounds = PixelRect::Hull(bounds, glyph);
+        }
+        return bounds;
+    }
+
+    // Überlappende Rechtecke zusammenlegen, damit kein Pixel zweimal gezeichnet wird
+    static int AddMerged(PixelRect* rects, int count, PixelRect rect) {
+        for (int i = 0; i < count; ++i) {
+            const PixelRect& other = rects[i];
+            if (rect.x0 < other.x1 && other.x0 < rect.x1 && rect.y0 < other.y1 && other.y0 < rect.y1) {
+                rect = PixelRect::Hull(rect, other);
+                rects[i] = rects[--count];
+                return AddMerged(rects, count, rect);
+            }
+        }
+        rects[count] = rect;
+        return count + 1;
+    }
+
+    GlyphSourceFactory glyphSourceFactory;
+    ThemeProgram theme = Theme::BuiltIn();
+    ScaleBuckets<Layers> buckets;
+    std::unique_ptr<WorkStealingPool> pool;
+    int requestedThreads = 0;
+    std::vector<std::vector<float>> scratch = std::vector<std::vector<float>>(1);   // eine pro Worker
+    std::vector<PixelRect> tiles;
+    TileStats tileStats;
+    float contentRadius = 0.0f;
+    std::vector<uint32_t> basePixels;   // für RedrawPercent
+    FrameParams baseParams;
+    int baseSplit = 0;
+    bool baseValid = false;
+    PercentStats percentStats;
+};
+
+// Letzter voller Hold-Frame; die Fade-Frames entstehen daraus per Alpha-Skalierung statt Neu-Rendern.
+// Mit einem transparenten Rand von 1 Pixel, damit das Resampling ohne Randprüfung auskommt.
+// Kopiert, skaliert und resampelt nur innerhalb der Spans des Hold-Frames.
+class FadeSnapshot {
+public:
+    void Capture(const Surface& src, const FrameSpans& srcSpans, BYTE framePercent) {
+        const int stride = src.width + 2;
+        pixels.assign(static_cast<size_t>(stride) * (src.height + 2), 0);
+        surface.pixels = pixels.data() + stride + 1;
+        surface.width = src.width;
+        surface.height = src.height;
+        surface.stride = stride;
+        spans = srcSpans;
+
+        for (int y = 0; y < src.height; ++y) {
+            const FrameSpans::Span span = spans.Row(y);
+            if (span.IsEmpty()) continue;
+            std::memcpy(surface.Row(y) + span.x0, src.Row(y) + span.x0, static_cast<size_t>(span.Count()) * sizeof(uint32_t));
+        }
+        rowBuffer.resize(stride);
+        tableScale = 0.0f;
+        percent = framePercent;
+        valid = true;
+    }
+
+    // Nach einem Live-Update der Prozentanzeige nur die neu gezeichneten Rechtecke übernehmen
+    void Patch(const Surface& src, const PixelRect& rect, BYTE framePercent) {
+        if (!valid) return;
+        for (int y = rect.y0; y < rect.y1; ++y) {
+            std::memcpy(surface.Row(y) + rect.x0, src.Row(y) + rect.x0, static_cast<size_t>(rect.x1 - rect.x0) * sizeof(uint32_t));
+        }
+        spans.Cover(rect);
+        percent = framePercent;
+    }
+
+    bool IsValid() const { return valid; }
+    BYTE Percent() const { return percent; }
+    void Invalidate() { valid = false; }
+
+    void Release() {
+        std::vector<uint32_t>().swap(pixels);
+        std::vector<uint32_t>().swap(rowBuffer);
+        surface = Surface();
+        spans = FrameSpans();
+        composed = FrameSpans();
+        valid = false;
+    }
+
+    // Ein Durchlauf pro Zeile: Alpha (und ggf. vertikales Resampling) per SIMD, dann horizontal.
+    // content sind die Spans von dst vorher und nachher.
+    bool Compose(const Surface& dst, FrameSpans& content, float scale, int alpha) {
+        if (!valid || dst.width != surface.width || dst.height != surface.height) return false;
+
+        const uint32_t factor = Raster::AlphaToFactor(alpha);
+        if (!Config::FADE_RESAMPLE || std::fabs(scale - 1.0f) <= 1e-4f) {
+            content.Adopt(dst, spans);
+            for (int y = 0; y < dst.height; ++y) {
+                const FrameSpans::Span span = spans.Row(y);
+                if (span.IsEmpty()) continue;
+                Raster::ScaleAlphaSpan(dst.Row(y) + span.x0, surface.Row(y) + span.x0, span.Count(), factor);
+            }
+            return true;
+        }
+
+        const float center = surface.width / 2.0f;
+        const float invScale = 1.0f / scale;
+        BuildTables(scale, center);
+
+        // Erst die Zielspans, damit dst vor dem Schreiben auf sie umgestellt werden kann
+        composed.Reset(dst.width, dst.height);
+        rowSources.resize(dst.height);
+        for (int y = 0; y < dst.height; ++y) {
+            const float v = (y + 0.5f - center) * invScale + center - 0.5f;
+            RowSource& source = rowSources[y];
+            source.vi = static_cast<int>(std::floor(v));
+            source.fy = static_cast<uint32_t>((v - source.vi) * 256.0f);
+            if (source.vi < -1 || source.vi >= surface.height) {
+                source.vi = -1;
+                source.fy = 0;
+            }
+            else if (source.vi == surface.height - 1) {
+                source.fy = 0;
+            }
+
+            source.span = FrameSpans::Hull(SourceSpan(source.vi), source.fy ? SourceSpan(source.vi + 1) : FrameSpans::Span());
+            composed.SetRow(y, TargetSpan(source.span));
+        }
+        content.Adopt(dst, composed);
+
+        for (int y = 0; y < dst.height; ++y) {
+            const RowSource& source = rowSources[y];
+            const FrameSpans::Span target = composed.Row(y);
+            if (target.IsEmpty()) continue;
+
+            // Quellspalten [x0 - 1, x1 + 1): außerhalb der Spans beider Zeilen ist alles 0
+            const int first = source.span.x0 - 1;
+            const int count = source.span.Count() + 2;
+            const uint32_t w1 = (source.fy * factor + 128) >> 8;
+            const uint32_t w0 = factor - w1;
+            Raster::BlendRowsSpan(rowBuffer.data() + first + 1, surface.Row(source.vi) + first,
+                surface.Row(source.vi + (source.fy ? 1 : 0)) + first, count, w0, w1);
+            Raster::ResampleRowSpan(dst.Row(y) + target.x0, rowBuffer.data() + 1, xIndex.data() + target.x0,
+                xFrac.data() + target.x0, target.Count());
+        }
+        return true;
+    }
+
+private:
+    void BuildTables(float scale, float center) {
+        if (scale == tableScale) return;
+        xIndex.resize(surface.width);
+        xFrac.resize(surface.width);
+        firstReading.resize(surface.width + 1);
+        firstPast.resize(surface.width + 1);
+
+        const float invScale = 1.0f / scale;
+        int reading = 0, past = 0;
+        for (int x = 0; x < surface.width; ++x) {
+            const float u = (x + 0.5f - center) * invScale + center - 0.5f;
+            int ui = static_cast<int>(std::floor(u));
+            uint8_t fx = static_cast<uint8_t>((u - ui) * 256.0f);
+            if (ui < -1 || ui >= surface.width) {
+                ui = -1;
+                fx = 0;
+            }
+            else if (ui == surface.width - 1) {
+                fx = 0;
+            }
+            xIndex[x] = ui;
+            xFrac[x] = fx;
+
+            // Gelesene Quellspalten [lo, hi]; die Ränder lesen nichts und zählen als ganz links bzw. ganz rechts
+            const int lo = (ui == -1 && u >= surface.width) ? surface.width : ui;
+            const int hi = (ui == -1 && fx == 0) ? lo : ui + (fx ? 1 : 0);
+            for (; reading <= std::min(hi, surface.width); ++reading) firstReading[reading] = x;
+            for (; past <= std::min(lo, surface.width); ++past) firstPast[past] = x;
+        }
+        for (; reading <= surface.width; ++reading) firstReading[reading] = surface.width;
+        for (; past <= surface.width; ++past) firstPast[past] = surface.width;
+        tableScale = scale;
+    }
+
+    struct RowSource {
+        int vi = -1;
+        uint32_t fy = 0;
+        FrameSpans::Span span;      // Hülle der beiden gelesenen Zeilen
+    };
+
+    // Zeilen -1 und height sind der transparente Rand
+    FrameSpans::Span SourceSpan(int y) const {
+        return (y < 0 || y >= surface.height) ? FrameSpans::Span() : spans.Row(y);
+    }
+
+    // Zielpixel, deren Tabelleneintrag eine Spalte des Quellspans liest; gelesene Spalten wachsen monoton mit x
+    FrameSpans::Span TargetSpan(FrameSpans::Span src) const {
+        if (src.IsEmpty()) return FrameSpans::Span();
+        const int x0 = firstReading[src.x0];
+        const int x1 = firstPast[src.x1];
+
+        FrameSpans::Span target;
+        if (x0 < x1) {
+            target.x0 = static_cast<uint16_t>(x0);
+            target.x1 = static_cast<uint16_t>(x1);
+        }
+        return target;
+    }
+
+    std::vector<uint32_t> pixels;
+    std::vector<uint32_t> rowBuffer;
+    std::vector<int32_t> xIndex;
+    std::vector<uint8_t> xFrac;
+    std::vector<int> firstReading;  // je Quellspalte c: erstes x, das c oder weiter rechts liest
+    std::vector<int> firstPast;     // je Quellspalte c: erstes x, das nur noch ab c liest
+    std::vector<RowSource> rowSources;
+    Surface surface;
+    FrameSpans spans;           // des Hold-Frames
+    FrameSpans composed;        // des letzten Fade-Frames
+    float tableScale = 0.0f;
+    BYTE percent = 0;           // angezeigter Prozentwert
+    bool valid = false;
+};
+
+// Milchglas hinter dem HUD. Build einmal pro Popup aus dem Bildschirmausschnitt: verkleinern, je Achse drei
+// Box-Durchgänge (zusammen fast ein Gauß), tönen, bilinear zurück auf volle Größe. Die Achsen laufen beide als
+// Zeilen-Kernel, die horizontale über eine Transponierung. Pro Frame bleibt nur Compose: HUD über die Scheibe.
+class BackdropBlur {
+public:
+    // capture: deckend, in HUD-Größe; die Verkleinerung wächst mit dem Skalierungs-Bucket
+    void Build(const Surface& capture, float scale) {
+        const int factor = std::max(1, static_cast<int>(Config::FROST_DOWNSAMPLE * scale + 0.5f));
+        width = capture.width;
+        height = capture.height;
+        smallWidth = (width + factor - 1) / factor;
+        smallHeight = (height + factor - 1) / factor;
+        zeros.assign(std::max(width, height), 0);
+
+        Downsample(capture, factor);
+        BlurColumns(smallWidth, smallHeight);
+        Transpose(smallWidth, smallHeight);
+        BlurColumns(smallHeight, smallWidth);
+        Transpose(smallHeight, smallWidth);
+
+        const std::vector<uint32_t> tint(smallWidth, 0xFF000000u | Config::FROST_TINT_RGB);
+        for (int y = 0; y < smallHeight; ++y) {
+            uint32_t* row = small.data() + static_cast<size_t>(y) * smallWidth;
+            Raster::BlendRowsSpan(row, row, tint.data(), smallWidth, 256 - Config::FROST_TINT, Config::FROST_TINT);
+        }
+        Upsample(factor);
+    }
+
+    bool IsValid() const { return !frost.empty(); }
+
+    Surface Frost() const {
+        Surface surface;
+        surface.pixels = const_cast<uint32_t*>(frost.data());
+        surface.width = width;
+        surface.height = height;
+        surface.stride = width;
+        return frost.empty() ? Surface() : surface;
+    }
+
+    void Release() {
+        std::vector<uint32_t>().swap(frost);
+        std::vector<uint32_t>().swap(small);
+        std::vector<uint32_t>().swap(scratch);
+        std::vector<uint32_t>().swap(horizontal);
+        std::vector<uint32_t>().swap(zeros);
+        std::vector<uint16_t>().swap(sums);
+        composed = FrameSpans();
+    }
+
+    // out = HUD über einer Scheibe aus Milchglas (Radius in Pixeln, Kante geglättet), Glas mit dem Fade-Alpha.
+    // outContent sind die Spans von out vorher und nachher.
+    bool Compose(const Surface& out, FrameSpans& outContent, const Surface& hud, const FrameSpans& hudSpans,
+        float radius, int alpha) {
+        if (frost.empty() || out.width != width || out.height != height || hud.width != width || hud.height != height) {
+            return false;
+        }
+        const uint32_t factor = Raster::AlphaToFactor(alpha);
+        if (factor == 0) radius = 0.0f;
+        radius = std::min(radius, std::min(width, height) / 2.0f);
+        const float cx = width / 2.0f, cy = height / 2.0f;
+
+        // Pro Zeile: Pixel mit Anteil an der Scheibe (outer) und ganz darin (inner)
+        composed.Reset(width, height);
+        discRows.resize(height);
+        for (int y = 0; y < height; ++y) {
+            DiscRow& disc = discRows[y];
+            disc = DiscRow();
+            const float dy = y + 0.5f - cy;
+            const float outerSq = (radius + 0.5f) * (radius + 0.5f) - dy * dy;
+            if (radius > 0.0f && outerSq > 0.0f) {
+                const float half = std::sqrt(outerSq);
+                disc.outer.x0 = static_cast<uint16_t>(std::max(0, static_cast<int>(std::floor(cx - half))));
+                disc.outer.x1 = static_cast<uint16_t>(std::min(width, static_cast<int>(std::ceil(cx + half))));
+                const float innerSq = (radius - 0.5f) * (radius - 0.5f) - dy * dy;
+                if (radius > 0.5f && innerSq > 0.0f) {
+                    const float inner = std::sqrt(innerSq);
+                    const int x0 = std::max<int>(disc.outer.x0, static_cast<int>(std::ceil(cx - inner - 0.5f)));
+                    const int x1 = std::min<int>(disc.outer.x1, static_cast<int>(std::floor(cx + inner - 0.5f)) + 1);
+                    if (x1 > x0) {
+                        disc.inner.x0 = static_cast<uint16_t>(x0);
+                        disc.inner.x1 = static_cast<uint16_t>(x1);
+                    }
+                }
+            }
+            composed.SetRow(y, FrameSpans::Hull(hudSpans.Row(y), disc.outer));
+        }
+        outContent.Adopt(out, composed);
+
+        for (int y = 0; y < height; ++y) {
+            const FrameSpans::Span span = composed.Row(y);
+            if (span.IsEmpty()) continue;
+            uint32_t* row = out.Row(y);
+            const uint32_t* back = frost.data() + static_cast<size_t>(y) * width;
+            std::memset(row + span.x0, 0, static_cast<size_t>(span.Count()) * sizeof(uint32_t));
+            const FrameSpans::Span hudSpan = hudSpans.Row(y);
+            if (!hudSpan.IsEmpty()) {
+                std::memcpy(row + hudSpan.x0, hud.Row(y) + hudSpan.x0, static_cast<size_t>(hudSpan.Count()) * sizeof(uint32_t));
+            }
+
+            const DiscRow& disc = discRows[y];
+            const float dy = y + 0.5f - cy;
+            const int innerX0 = disc.inner.IsEmpty() ? disc.outer.x1 : disc.inner.x0;
+            const int innerX1 = disc.inner.IsEmpty() ? disc.outer.x1 : disc.inner.x1;
+            for (int x = disc.outer.x0; x < disc.outer.x1; ++x) {
+                if (x == innerX0) {
+                    Raster::BlendBehindSpan(row + x, back + x, innerX1 - innerX0, factor);
+                    x = innerX1 - 1;
+                    continue;
+                }
+                const float dx = x + 0.5f - cx;
+                const float coverage = Utils::Clamp(radius + 0.5f - std::sqrt(dx * dx + dy * dy), 0.0f, 1.0f);
+                Raster::BlendBehindSpan(row + x, back + x, 1, static_cast<uint32_t>(factor * coverage + 0.5f));
+            }
+        }
+        return true;
+    }
+
+private:
+    struct DiscRow {
+        FrameSpans::Span outer;
+        FrameSpans::Span inner;
+    };
+
+    // Mittel über factor x factor Pixel; am rechten und unteren Rand zählt die letzte Zeile/Spalte mehrfach
+    void Downsample(const Surface& capture, int factor) {
+        small.resize(static_cast<size_t>(smallWidth) * smallHeight);
+        scratch.resize(small.size());
+        sums.resize(static_cast<size_t>(std::max(width, height)) * 4);
+        const uint32_t area = static_cast<uint32_t>(factor * factor);
+        for (int sy = 0; sy < smallHeight; ++sy) {
+            std::fill(sums.begin(), sums.begin() + static_cast<size_t>(width) * 4, 0);
+            for (int k = 0; k < factor; ++k) {
+                Raster::BoxSumRow(sums.data(), capture.Row(std::min(sy * factor + k, height - 1)), zeros.data(), width);
+            }
+            uint32_t* dst = small.data() + static_cast<size_t>(sy) * smallWidth;
+            for (int sx = 0; sx < smallWidth; ++sx) {
+                uint32_t total[4] = {};
+                for (int k = 0; k < factor; ++k) {
+                    const uint16_t* column = sums.data() + static_cast<size_t>(std::min(sx * factor + k, width - 1)) * 4;
+                    for (int c = 0; c < 4; ++c) total[c] += column[c];
+                }
+                uint32_t pixel = 0;
+                for (int c = 0; c < 4; ++c) pixel |= ((total[c] + area / 2) / area) << (8 * c);
+                dst[sx] = pixel;
+            }
+        }
+    }
+
+    // Drei Box-Durchgänge entlang der Spalten, Rand wiederholt; Ergebnis wieder in small
+    void BlurColumns(int w, int h) {
+        const int r = Config::FROST_BLUR_RADIUS;
+        const uint32_t n = 2 * r + 1;
+        const uint32_t mult = (65536 + n - 1) / n;
+        for (int pass = 0; pass < 3; ++pass) {
+            const uint32_t* src = small.data();
+            uint32_t* dst = scratch.data();
+            auto row = [&](int y) { return src + static_cast<size_t>(Utils::Clamp(y, 0, h - 1)) * w; };
+            std::fill(sums.begin(), sums.begin() + static_cast<size_t>(w) * 4, 0);
+            for (int k = -r; k <= r; ++k) Raster::BoxSumRow(sums.data(), row(k), zeros.data(), w);
+            for (int y = 0; y < h; ++y) {
+                Raster::BoxAverageRow(dst + static_cast<size_t>(y) * w, sums.data(), w, n / 2, mult);
+                Raster::BoxSumRow(sums.data(), row(y + r + 1), row(y - r), w);
+            }
+            small.swap(scratch);
+        }
+    }
+
+    void Transpose(int w, int h) {
+        for (int y = 0; y < h; ++y) {
+            const uint32_t* src = small.data() + static_cast<size_t>(y) * w;
+            for (int x = 0; x < w; ++x) scratch[static_cast<size_t>(x) * h + y] = src[x];
+        }
+        small.swap(scratch);
+    }
+
+    // Pixelmitten auf das kleine Raster abbilden; am Rand Gewicht 0 statt Lesen außerhalb
+    static void BuildTable(std::vector<int32_t>& index, std::vector<uint8_t>& frac, int count, int smallCount, int factor) {
+        index.resize(count);
+        frac.resize(count);
+        for (int i = 0; i < count; ++i) {
+            const float u = (i + 0.5f) / factor - 0.5f;
+            int ui = static_cast<int>(std::floor(u));
+            uint8_t f = static_cast<uint8_t>((u - ui) * 256.0f);
+            if (ui < 0) {
+                ui = 0;
+                f = 0;
+            }
+            else if (ui >= smallCount - 1) {
+                ui = smallCount - 1;
+                f = 0;
+            }
+            index[i] = ui;
+            frac[i] = f;
+        }
+    }
+
+    // Erst jede kleine Zeile auf volle Breite, dann zwischen zwei solchen Zeilen mischen
+    void Upsample(int factor) {
+        BuildTable(xIndex, xFrac, width, smallWidth, factor);
+        BuildTable(yIndex, yFrac, height, smallHeight, factor);
+        horizontal.resize(static_cast<size_t>(smallHeight) * width);
+        scratch.resize(static_cast<size_t>(smallWidth) + 1);
+        for (int sy = 0; sy < smallHeight; ++sy) {
+            const uint32_t* src = small.data() + static_cast<size_t>(sy) * smallWidth;
+            std::copy(src, src + smallWidth, scratch.begin());
+            scratch[smallWidth] = src[smallWidth - 1];
+            Raster::ResampleRowSpan(horizontal.data() + static_cast<size_t>(sy) * width, scratch.data(), xIndex.data(),
+                xFrac.data(), width);
+        }
+
+        frost.resize(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; ++y) {
+            const uint32_t w1 = yFrac[y];
+            const uint32_t* a = horizontal.data() + static_cast<size_t>(yIndex[y]) * width;
+            const uint32_t* b = w1 ? a + width : a;
+            Raster::BlendRowsSpan(frost.data() + static_cast<size_t>(y) * width, a, b, width, 256 - w1, w1);
+        }
+    }
+
+    std::vector<uint32_t> frost;        // volle Größe, deckend
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> scratch;
+    std::vector<uint32_t> horizontal;   // kleine Zeilen auf voller Breite
+    std::vector<uint32_t> zeros;
+    std::vector<uint16_t> sums;         // vier Kanalsummen pro Pixel
+    std::vector<int32_t> xIndex, yIndex;
+    std::vector<uint8_t> xFrac, yFrac;
+    std::vector<DiscRow> discRows;
+    FrameSpans composed;
+    int width = 0;
+    int height = 0;
+    int smallWidth = 0;
+    int smallHeight = 0;
+};
+
+// LRU-Cache fertig gerenderter Frames, Schlüssel (Prozent, Farbe, Frame-Index, Qualität), begrenzt durch ein Speicherbudget.
+// Ein Eintrag hält nur die Pixel innerhalb der Spans, dicht hintereinander, plus die Spans selbst.
+class FrameCache {
+public:
+    using Key = uint64_t;
+
+    struct Stats {
+        unsigned hits = 0;
+        unsigned misses = 0;
+        unsigned evictions = 0;
+        unsigned reused = 0;        // Einträge im Puffer eines verdrängten, ohne neue Allokation
+        unsigned entries = 0;
+        size_t bytes = 0;
+        size_t denseBytes = 0;      // was dieselben Einträge als volle Frames belegen würden
+    };
+
+    explicit FrameCache(size_t budgetBytes = Config::FRAME_CACHE_BUDGET_BYTES) : budget(budgetBytes) {}
+
+    static Key MakeKey(BYTE percent, uint32_t themeArgb, int frameIndex, int scaleBucket, RenderQuality quality) {
+        return (static_cast<uint64_t>(themeArgb) << 32)
+            | (static_cast<uint64_t>(percent) << 24)
+            | (static_cast<uint64_t>(scaleBucket & 0xFF) << 16)
+            | (static_cast<uint64_t>(quality) << 12)
+            | static_cast<uint64_t>(frameIndex & 0x0FFF);
+    }
+
+    void SetBudget(size_t budgetBytes) {
+        budget = budgetBytes;
+        Trim(0);
+    }
+
+    // content sind die Spans von dst vorher und nachher
+    bool Lookup(Key key, const Surface& dst, FrameSpans& content) {
+        auto found = index.find(key);
+        if (found == index.end() || !found->second->spans.Fits(dst)) {
+            stats.misses++;
+            return false;
+        }
+
+        entries.splice(entries.begin(), entries, found->second);
+        const Entry& entry = *found->second;
+        content.Adopt(dst, entry.spans);
+        const uint32_t* packed = entry.pixels.data();
+        for (int y = 0; y < dst.height; ++y) {
+            const FrameSpans::Span span = entry.spans.Row(y);
+            if (span.IsEmpty()) continue;
+            std::memcpy(dst.Row(y) + span.x0, packed, static_cast<size_t>(span.Count()) * sizeof(uint32_t));
+            packed += span.Count();
+        }
+        stats.hits++;
+        return true;
+    }
+
+    bool Contains(Key key) const { return index.count(key) != 0; }
+
+    void Insert(Key key, const Surface& src, const FrameSpans& spans) {
+        const size_t pixelCount = spans.Pixels();
+        const size_t bytes = pixelCount * sizeof(uint32_t) + spans.Bytes();
+        if (bytes > budget || index.count(key)) return;
+        Trim(bytes);
+
+        Entry entry;
+        entry.key = key;
+        entry.spans = spans;
+        entry.bytes = bytes;
+        entry.denseBytes = static_cast<size_t>(src.width) * src.height * sizeof(uint32_t);
+        if (recycled.capacity() >= pixelCount) stats.reused++;
+        entry.pixels = std::move(recycled);
+        entry.pixels.resize(pixelCount);
+        uint32_t* packed = entry.pixels.data();
+        for (int y = 0; y < src.height; ++y) {
+            const FrameSpans::Span span = spans.Row(y);
+            if (span.IsEmpty()) continue;
+            std::memcpy(packed, src.Row(y) + span.x0, static_cast<size_t>(span.Count()) * sizeof(uint32_t));
+            packed += span.Count();
+        }
+
+        stats.bytes += entry.bytes;
+        stats.denseBytes += entry.denseBytes;
+        stats.entries++;
+        entries.push_front(std::move(entry));
+        index[key] = entries.begin();
+    }
+
+    void Clear() {
+        entries.clear();
+        index.clear();
+        std::vector<uint32_t>().swap(recycled);
+        stats.bytes = 0;
+        stats.denseBytes = 0;
+        stats.entries = 0;
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Entry {
+        Key key = 0;
+        FrameSpans spans;
+        std::vector<uint32_t> pixels;   // Zeile für Zeile nur die Spans
+        size_t bytes = 0;
+        size_t denseBytes = 0;
+    };
+
+    // Älteste Einträge verdrängen, bis `incoming` Bytes ins Budget passen; ein Puffer wird wiederverwendet.
+    void Trim(size_t incoming) {
+        while (!entries.empty() && stats.bytes + incoming > budget) {
+            Entry& victim = entries.back();
+            stats.bytes -= victim.bytes;
+            stats.denseBytes -= victim.denseBytes;
+            stats.entries--;
+            stats.evictions++;
+            index.erase(victim.key);
+            if (recycled.capacity() < victim.pixels.capacity()) recycled = std::move(victim.pixels);
+            entries.pop_back();
+        }
+    }
+
+    std::list<Entry> entries;   // vorne = zuletzt benutzt
+    std::unordered_map<Key, std::list<Entry>::iterator> index;
+    std::vector<uint32_t> recycled;
+    size_t budget;
+    Stats stats;
+};
+
+// Ein Monitor, auf dem das HUD erscheint.
+struct HudOutput {
+    RECT bounds = {};
+    float dpiScale = 1.0f;
+
+    // Wo ein zentrierter Frame dieser Größe auf dem Monitor liegt
+    RECT Centered(int width, int height) const {
+        const LONG left = bounds.left + (bounds.right - bounds.left - width) / 2;
+        const LONG top = bounds.top + (bounds.bottom - bounds.top - height) / 2;
+        return { left, top, left + width, top + height };
+    }
+};
+
+// Ein fertiger Frame für alle Ausgaben derselben Skalierung; Pixel und DC gehören dem Renderer.
+struct PresentFrame {
+    Surface surface;
+    const FrameSpans* spans = nullptr;  // außerhalb ist surface transparent
+    PixelRect dirty;                    // kann sich seit dem letzten Frame dieser Skalierung geändert haben
+    HDC dc = nullptr;
+    float scale = 1.0f;
+    int alpha = 0;
+    unsigned serial = 0;            // gleich für alle Present-Aufrufe eines Frames
+    unsigned rasterizations = 0;    // in diesem Frame neu gezeichnete Skalierungen
+};
+
+class IHudOutputs {
+public:
+    virtual ~IHudOutputs() = default;
+    virtual void Refresh() = 0;
+    virtual const std::vector<HudOutput>& Outputs() const = 0;
+    virtual void Present(size_t index, const PresentFrame& frame) = 0;
+};
+
+// Was hinter dem HUD auf dem Bildschirm liegt, für das Milchglas; headless liefert der Snapshot-Test ein Muster.
+class IBackdropSource {
+public:
+    virtual ~IBackdropSource() = default;
+    // Deckende Pixel des Bildschirmausschnitts rect nach dst (gleiche Größe); false = nicht verfügbar
+    virtual bool Capture(const RECT& rect, const Surface& dst) = 0;
+};
+
+// Headless: zeigt nichts an, prüft aber, dass pro Skalierung genau ein Puffer gezeichnet und geteilt wird.
+class FakeHudOutputs : public IHudOutputs {
+public:
+    struct Stats {
+        unsigned frames = 0;
+        unsigned presents = 0;
+        unsigned rasterizations = 0;
+    };
+
+    explicit FakeHudOutputs(std::vector<HudOutput> outputs) : outputs(std::move(outputs)) {}
+
+    void Refresh() override {}
+    const std::vector<HudOutput>& Outputs() const override { return outputs; }
+
+    void Present(size_t index, const PresentFrame& frame) override {
+        assert(index < outputs.size());
+        assert(HudMetrics::BucketScale(outputs[index].dpiScale) == frame.scale);
+
+        if (frame.serial != currentSerial) {
+            currentSerial = frame.serial;
+            buffers.clear();
+            stats.frames++;
+            stats.rasterizations += frame.rasterizations;
+            assert(frame.rasterizations <= DistinctScales());
+        }
+        stats.presents++;
+
+        // Gleiche Skalierung -> derselbe Puffer; verschiedene Skalierungen teilen nie einen
+        for (const SeenBuffer& seen : buffers) {
+            assert((seen.scale == frame.scale) == (seen.pixels == frame.surface.pixels));
+            if (seen.scale == frame.scale) return;
+        }
+        buffers.push_back({ frame.scale, frame.surface.pixels });
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct SeenBuffer {
+        float scale;
+        const uint32_t* pixels;
+    };
+
+    unsigned DistinctScales() const {
+        std::vector<float> scales;
+        for (const HudOutput& output : outputs) {
+            const float scale = HudMetrics::BucketScale(output.dpiScale);
+            if (std::find(scales.begin(), scales.end(), scale) == scales.end()) scales.push_back(scale);
+        }
+        return static_cast<unsigned>(scales.size());
+    }
+
+    std::vector<HudOutput> outputs;
+    std::vector<SeenBuffer> buffers;
+    unsigned currentSerial = 0;
+    Stats stats;
+};
+
+// Optionaler Export für Kiosk-Shell und Overlays: jeder präsentierte Frame des ersten Monitors landet in
+// einem benannten Shared-Memory-Ring (Layout in hudframes.h). Hier eine Kopie pro Frame, nur innerhalb der Spans;
+// Leser kopieren nichts.
+class SharedFrameExport {
+public:
+    struct Stats {
+        unsigned framesPublished = 0;
+        unsigned framesRejected = 0;    // größer als ein Slot
+        unsigned long long bytesCopied = 0;
+    };
+
+    ~SharedFrameExport() { Close(); }
+
+    bool Open() {
+        if (view) return true;
+        const uint64_t bytes = HudFrames::MappingBytes();
+#if defined(_WIN32)
+        mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+            static_cast<DWORD>(bytes >> 32), static_cast<DWORD>(bytes), HudFrames::WINDOWS_NAME);
+        if (!mapping) return false;
+        view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, static_cast<SIZE_T>(bytes));
+#else
+        const int fd = shm_open(HudFrames::POSIX_NAME, O_CREAT | O_RDWR, 0600);
+        if (fd < 0) return false;
+        if (ftruncate(fd, static_cast<off_t>(bytes)) == 0) {
+            void* mapped = mmap(nullptr, static_cast<size_t>(bytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            view = (mapped == MAP_FAILED) ? nullptr : mapped;
+        }
+        close(fd);
+#endif
+        if (!view) {
+            Close();
+            return false;
+        }
+        writer = std::make_unique<HudFrames::Writer>(view);
+        writer->Init();
+        return true;
+    }
+
+    void Close() {
+        writer.reset();
+#if defined(_WIN32)
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        if (view) munmap(view, static_cast<size_t>(HudFrames::MappingBytes()));
+        shm_unlink(HudFrames::POSIX_NAME);
+#endif
+        view = nullptr;
+    }
+
+    void Publish(const PresentFrame& frame) {
+        if (!writer || !frame.surface.IsValid()) return;
+        const Surface& surface = frame.surface;
+        const uint64_t timestampUs = static_cast<uint64_t>(Utils::NowMs() * 1000.0);
+        const bool sparse = frame.spans && frame.spans->Fits(surface);
+        if (sparse) {
+            rows.resize(surface.height);
+            for (int y = 0; y < surface.height; ++y) {
+                const FrameSpans::Span span = frame.spans->Row(y);
+                rows[y] = span.IsEmpty() ? HudFrames::RowSpan{ 0, 0 } : HudFrames::RowSpan{ span.x0, span.x1 };
+            }
+        }
+        if (!writer->Publish(surface.pixels, surface.width, surface.height, surface.stride * 4,
+                static_cast<uint32_t>(frame.alpha), frame.scale, timestampUs, sparse ? rows.data() : nullptr)) {
+            stats.framesRejected++;
+            return;
+        }
+        stats.framesPublished++;
+        stats.bytesCopied += 4ull * (sparse ? frame.spans->Pixels() : static_cast<size_t>(surface.width) * surface.height);
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+#if defined(_WIN32)
+    HANDLE mapping = nullptr;
+#endif
+    void* view = nullptr;
+    std::unique_ptr<HudFrames::Writer> writer;
+    std::vector<HudFrames::RowSpan> rows;
+    Stats stats;
+};
+
+class HUDRenderer {
+public:
+    struct PopupStats {
+        unsigned framesRendered = 0;
+        unsigned framesSkipped = 0;
+        unsigned rasterizations = 0;
+        unsigned presents = 0;
+        uint64_t denseBytes = 0;        // volle Frames, wie sie vorher bei jedem Present hochgeladen wurden
+        uint64_t uploadBytes = 0;       // Rechteck um die geänderten Spans
+        uint64_t spanBytes = 0;         // Pixel innerhalb der Spans
+        unsigned percentUpdates = 0;    // Frames, in denen nur Bogen und Text neu gezeichnet wurden
+        uint64_t pixelsRedrawn = 0;     // ... und die dabei berührten Pixel
+    };
+
+    // Die App: Fenster, GDI-Zeichenflächen und ein Rasterizer, der erst beim ersten Frame entsteht (GDI+ startet
+    // erst in wWinMain)
+    HUDRenderer(std::unique_ptr<IHudOutputs> outputs, RenderTargetFactory targetFactory,
+        RasterizerFactory rasterizerFactory)
+        : outputs(std::move(outputs)), targetFactory(targetFactory), rasterizerFactory(rasterizerFactory) {}
+
+    // Headless, z.B. für den Snapshot-Test: eigene Zeichenflächen und fester Rasterizer
+    HUDRenderer(std::unique_ptr<IHudOutputs> outputs, RenderTargetFactory targetFactory,
+        std::unique_ptr<IHudRasterizer> rasterizer)
+        : outputs(std::move(outputs)), targetFactory(targetFactory), rasterizer(std::move(rasterizer)) {}
+
+    // Einmal beim Start; alle Caches stammen danach aus dem neuen Theme
+    void SetTheme(const ThemeProgram& program) {
+        theme = program;
+        if (rasterizer) rasterizer->SetTheme(theme);
+        frameCache.Clear();
+        for (auto& layer : layers) {
+            layer->fadeSnapshot.Invalidate();
+        }
+        hasPresented = false;
+    }
+
+    // Nur bei WM_DISPLAYCHANGE (und beim ersten Popup), nicht pro Frame
+    void RefreshOutputs() {
+        outputs->Refresh();
+        AssignLayers();
+        backdrops.clear();          // Aufnahmen gehören zu den alten Monitoren
+        outputsValid = true;
+    }
+
+    bool BeginAnimation() {
+        if (!outputsValid) RefreshOutputs();
+        for (auto& layer : layers) {
+            layer->fadeSnapshot.Invalidate();
+            layer->shownExact = false;
+        }
+        hasPresented = false;
+        popupStats = PopupStats();
+        if (!EnsureResources()) return false;
+        CaptureBackdrops();
+        return true;
+    }
+
+    void EndAnimation() {
+        for (auto& layer : layers) {
+            layer->target->Release();
+            layer->fadeSnapshot.Release();
+            std::vector<uint32_t>().swap(layer->crossfadeFrom);
+            layer->crossfadeSpans = FrameSpans();
+            layer->crossfade.Release();
+        }
+        backdrops.clear();
+    }
+
+    void Render(const HUDState& state, RenderQuality quality = RenderQuality::Full) {
+        if (!EnsureResources()) return;
+
+        FrameParams params = Timeline::ComputeFrameParams(state);
+        params.quality = quality;
+        if (hasPresented && params == lastPresented) {
+            popupStats.framesSkipped++;
+            return;
+        }
+
+        // Neue Zielfarbe oder Qualitätsstufe: der Snapshot für den Fade muss dazu passen
+        if (hasPresented && (params.themeArgb != lastPresented.themeArgb || params.quality != lastPresented.quality)) {
+            for (auto& layer : layers) {
+                layer->fadeSnapshot.Invalidate();
+            }
+        }
+
+        // Einmal pro Skalierung zeichnen ...
+        PresentFrame frame;
+        frame.alpha = params.alpha;
+        frame.serial = ++frameSerial;
+        for (auto& layer : layers) {
+            if (RenderLayer(*layer, params, state)) frame.rasterizations++;
+        }
+
+        // ... und denselben Puffer an alle Monitore dieser Skalierung geben
+        const size_t outputCount = outputs->Outputs().size();
+        for (size_t i = 0; i < outputCount && i < outputLayers.size(); ++i) {
+            OutputLayer& layer = *layers[outputLayers[i]];
+            frame.surface = layer.target->GetSurface();
+            frame.spans = &layer.target->Content();
+            frame.dirty = layer.dirty;
+            frame.dc = layer.target->MemoryDC();
+            frame.scale = layer.metrics.scale;
+            if (i < backdrops.size() && backdrops[i].valid) ComposeBackdrop(backdrops[i], layer, params, frame);
+            outputs->Present(i, frame);
+            popupStats.presents++;
+            popupStats.denseBytes += static_cast<uint64_t>(PixelRect::Of(frame.surface).Area()) * sizeof(uint32_t);
+            popupStats.uploadBytes += static_cast<uint64_t>(frame.dirty.Area()) * sizeof(uint32_t);
+            popupStats.spanBytes += static_cast<uint64_t>(frame.spans->Pixels()) * sizeof(uint32_t);
+        }
+        if (frameExport && !outputLayers.empty()) {
+            OutputLayer& layer = *layers[outputLayers.front()];
+            frame.surface = layer.target->GetSurface();
+            frame.spans = &layer.target->Content();
+            frame.dirty = layer.dirty;
+            frame.scale = layer.metrics.scale;
+            frameExport->Publish(frame);
+        }
+
+        lastPresented = params;
+        hasPresented = true;
+        popupStats.framesRendered++;
+        popupStats.rasterizations += frame.rasterizations;
+    }
+
+    RenderTargetStats TargetStats() const {
+        RenderTargetStats total;
+        for (const auto& layer : layers) {
+            const RenderTargetStats& stats = layer->target->Stats();
+            total.surfaceAllocations += stats.surfaceAllocations;
+            total.surfaceReleases += stats.surfaceReleases;
+            total.framesBegun += stats.framesBegun;
+        }
+        return total;
+    }
+    const PopupStats& GetPopupStats() const { return popupStats; }
+    SharedFrameExport::Stats FrameExportStats() const { return frameExport ? frameExport->GetStats() : SharedFrameExport::Stats(); }
+
+    // false, wenn der Ring nicht angelegt werden konnte; der Export bleibt dann aus
+    bool EnableFrameExport(bool enable) {
+        if (!enable) {
+            frameExport.reset();
+            return true;
+        }
+        if (frameExport) return true;
+        auto exporter = std::make_unique<SharedFrameExport>();
+        if (!exporter->Open()) return false;
+        frameExport = std::move(exporter);
+        return true;
+    }
+    const FrameCache::Stats& FrameCacheStats() const { return frameCache.GetStats(); }
+    GeometryCacheStats RingCacheStats() const { return rasterizer ? rasterizer->RingCacheStats() : GeometryCacheStats(); }
+
+    // Milchglas hinter dem HUD; nullptr schaltet es ab. Aufgenommen wird beim nächsten BeginAnimation.
+    void EnableBackdrop(std::unique_ptr<IBackdropSource> source) {
+        backdropSource = std::move(source);
+        backdrops.clear();
+    }
+
+private:
+    // Zeichenfläche und Fade-Snapshot für alle Monitore mit derselben Skalierung
+    struct OutputLayer {
+        OutputLayer(const HudMetrics& metrics, std::unique_ptr<IRenderTarget> target)
+            : metrics(metrics), target(std::move(target)) {}
+
+        HudMetrics metrics;
+        std::unique_ptr<IRenderTarget> target;
+        FadeSnapshot fadeSnapshot;
+        std::vector<uint32_t> crossfadeFrom;    // Frame in der Ausgangsfarbe während eines Farbübergangs
+        FrameSpans crossfadeSpans;
+        Raster::LinearCrossfade crossfade;
+        PixelRect presentedBounds;              // Spans des zuletzt gezeigten Frames
+        PixelRect dirty;                        // ... vereinigt mit denen des aktuellen
+        FrameParams shown;                      // Frame auf der Zeichenfläche, wenn shownExact
+        bool shownExact = false;                // false nach Mischung, Fade aus dem Snapshot oder leerem Frame
+        PixelRect redrawn;                      // nur diese Rechtecke hat RedrawPercent geändert
+    };
+
+    // Milchglas pro Monitor (jeder hat einen anderen Hintergrund): eigene Zeichenfläche für HUD und Glas
+    struct OutputBackdrop {
+        BackdropBlur blur;
+        std::unique_ptr<IRenderTarget> target;
+        PixelRect presentedBounds;
+        float radius = 0.0f;
+        int alpha = 0;
+        bool valid = false;
+    };
+
+    void AssignLayers() {
+        std::vector<std::unique_ptr<OutputLayer>> previous;
+        previous.swap(layers);
+        outputLayers.clear();
+
+        for (const HudOutput& output : outputs->Outputs()) {
+            const float scale = HudMetrics::BucketScale(output.dpiScale);
+            auto sameScale = [scale](const std::unique_ptr<OutputLayer>& layer) {
+                return layer && layer->metrics.scale == scale;
+            };
+
+            auto it = std::find_if(layers.begin(), layers.end(), sameScale);
+            if (it == layers.end()) {
+                auto reused = std::find_if(previous.begin(), previous.end(), sameScale);
+                if (reused != previous.end()) {
+                    layers.push_back(std::move(*reused));
+                }
+                else {
+                    layers.push_back(std::make_unique<OutputLayer>(HudMetrics::ForScale(scale), targetFactory()));
+                }
+                it = layers.end() - 1;
+            }
+            outputLayers.push_back(static_cast<size_t>(it - layers.begin()));
+        }
+        hasPresented = false;
+    }
+
+    bool EnsureResources() {
+        if (!rasterizer) {
+            rasterizer = rasterizerFactory();
+            rasterizer->SetTheme(theme);
+        }
+        for (auto& layer : layers) {
+            if (!layer->target->Acquire(layer->metrics.size, layer->metrics.size)) return false;
+        }
+        return !layers.empty();
+    }
+
+    // Einmal pro Popup, solange das HUD noch nicht zu sehen ist
+    void CaptureBackdrops() {
+        backdrops.clear();
+        if (!backdropSource) return;
+        const std::vector<HudOutput>& list = outputs->Outputs();
+        backdrops.resize(std::min(list.size(), outputLayers.size()));
+        std::vector<uint32_t> pixels;
+        for (size_t i = 0; i < backdrops.size(); ++i) {
+            const HudMetrics& metrics = layers[outputLayers[i]]->metrics;
+            pixels.assign(static_cast<size_t>(metrics.size) * metrics.size, 0);
+            Surface capture;
+            capture.pixels = pixels.data();
+            capture.width = metrics.size;
+            capture.height = metrics.size;
+            capture.stride = metrics.size;
+            if (!backdropSource->Capture(list[i].Centered(metrics.size, metrics.size), capture)) continue;
+
+            OutputBackdrop& backdrop = backdrops[i];
+            backdrop.target = targetFactory();
+            if (!backdrop.target->Acquire(metrics.size, metrics.size)) continue;
+            backdrop.blur.Build(capture, metrics.scale);
+            backdrop.valid = true;
+        }
+    }
+
+    // HUD dieser Skalierung über das Glas des Monitors; frame zeigt danach auf die Fläche des Monitors.
+    // Bleiben Scheibe und Alpha gleich, ändert sich nur, was sich am HUD geändert hat.
+    void ComposeBackdrop(OutputBackdrop& backdrop, const OutputLayer& layer, const FrameParams& params, PresentFrame& frame) {
+        const float radius = Config::FROST_RADIUS * layer.metrics.scale * params.scale;
+        const Surface surface = backdrop.target->GetSurface();
+        FrameSpans& content = backdrop.target->Content();
+        backdrop.target->Flush();
+        if (!backdrop.blur.Compose(surface, content, frame.surface, *frame.spans, radius, params.alpha)) return;
+
+        const PixelRect bounds = content.Bounds();
+        if (hasPresented && (radius != backdrop.radius || params.alpha != backdrop.alpha)) {
+            frame.dirty = PixelRect::Hull(backdrop.presentedBounds, bounds);
+        }
+        backdrop.presentedBounds = bounds;
+        backdrop.radius = radius;
+        backdrop.alpha = params.alpha;
+
+        frame.surface = surface;
+        frame.spans = &content;
+        frame.dc = backdrop.target->MemoryDC();
+    }
+
+    // true, wenn der Frame für diese Skalierung neu gezeichnet (nicht aus dem Cache geholt) wurde
+    bool RenderLayer(OutputLayer& layer, FrameParams params, const HUDState& state) {
+        params.dpiScale = layer.metrics.scale;
+
+        const Surface surface = layer.target->GetSurface();
+        if (!surface.IsValid()) return false;
+        layer.target->Flush();
+
+        bool rasterized = false;
+        layer.redrawn = PixelRect();
+        if (params.alpha == 0) {
+            layer.target->BeginFrame();
+            layer.shownExact = false;
+        }
+        else if (params.colorMix < 256) {
+            // Beide Endfarben (ab dem zweiten Übergangsframe meist aus dem Cache), dann in linearem Licht mischen
+            FrameParams from = params;
+            from.themeArgb = params.fromArgb;
+            rasterized = ProduceFrame(layer, from, state);
+
+            Surface fromSurface = surface;
+            fromSurface.stride = surface.width;
+            if (!layer.crossfadeSpans.Fits(surface)) {
+                layer.crossfadeFrom.assign(static_cast<size_t>(surface.width) * surface.height, 0);
+                layer.crossfadeSpans.Reset(surface.width, surface.height);
+            }
+            fromSurface.pixels = layer.crossfadeFrom.data();
+            const FrameSpans& fromSpans = layer.target->Content();
+            layer.crossfadeSpans.Adopt(fromSurface, fromSpans);
+            for (int y = 0; y < surface.height; ++y) {
+                const FrameSpans::Span span = fromSpans.Row(y);
+                if (span.IsEmpty()) continue;
+                std::memcpy(fromSurface.Row(y) + span.x0, surface.Row(y) + span.x0, span.Count() * sizeof(uint32_t));
+            }
+
+            // Außerhalb beider Spans sind beide Bilder 0, die Mischung also auch
+            rasterized = ProduceFrame(layer, params, state) || rasterized;
+            FrameSpans& content = layer.target->Content();
+            content.Unite(layer.crossfadeSpans);
+            layer.crossfade.Prepare(params.colorMix);
+            for (int y = 0; y < surface.height; ++y) {
+                const FrameSpans::Span span = content.Row(y);
+                if (span.IsEmpty()) continue;
+                layer.crossfade.Span(surface.Row(y) + span.x0, fromSurface.Row(y) + span.x0, surface.Row(y) + span.x0,
+                    span.Count());
+            }
+            layer.shownExact = false;
+            layer.redrawn = PixelRect();
+        }
+        else {
+            rasterized = ProduceFrame(layer, params, state);
+        }
+
+        const PixelRect bounds = layer.target->Content().Bounds();
+        if (!hasPresented) {
+            layer.dirty = PixelRect::Of(surface);
+        }
+        else {
+            layer.dirty = layer.redrawn.IsEmpty() ? PixelRect::Hull(layer.presentedBounds, bounds) : layer.redrawn;
+        }
+        layer.presentedBounds = bounds;
+
+        if (Config::FADE_FROM_SNAPSHOT && IsHoldFrame(state)
+            && (!layer.fadeSnapshot.IsValid() || layer.fadeSnapshot.Percent() != params.percent)) {
+            layer.fadeSnapshot.Capture(surface, layer.target->Content(), params.percent);
+        }
+        return rasterized;
+    }
+
+    // Frame in einer Farbe: aus dem Cache, aus dem Fade-Snapshot oder neu gezeichnet. Gemischte Übergangsframes
+    // kommen nicht in den Cache, nur ihre beiden Endfarben.
+    bool ProduceFrame(OutputLayer& layer, const FrameParams& params, const HUDState& state) {
+        RenderContext ctx;
+        ctx.surface = layer.target->GetSurface();
+        ctx.graphics = layer.target->Context();
+
+        FrameSpans& content = layer.target->Content();
+        const FrameCache::Key key = FrameCache::MakeKey(params.percent, params.themeArgb,
+            Timeline::FrameIndex(state), HudMetrics::BucketId(params.dpiScale), params.quality);
+        if (RedrawPercent(layer, params, state)) {
+            frameCache.Insert(key, ctx.surface, content);
+            return true;
+        }
+        if (frameCache.Lookup(key, ctx.surface, content)) {
+            layer.shown = params;
+            layer.shownExact = true;
+            return false;
+        }
+
+        layer.shown = params;
+        layer.shownExact = true;
+        if (Config::FADE_FROM_SNAPSHOT && state.isFadingOut && layer.fadeSnapshot.IsValid()
+            && layer.fadeSnapshot.Percent() == params.percent) {
+            layer.fadeSnapshot.Compose(ctx.surface, content, params.scale, params.alpha);
+            layer.shownExact = false;
+        }
+        else {
+            ctx.surface = layer.target->BeginFrame();
+            rasterizer->Draw(ctx, params);
+            layer.target->Flush();
+
+            // Kreis des Rasterizers (mit einem Pixel Reserve für Antialiasing), dann die echte Deckung
+            const float radius = rasterizer->ContentRadius();
+            if (radius > 0.0f) {
+                content.Circle(ctx.surface.width, ctx.surface.height, layer.metrics.center, layer.metrics.center, radius + 1.0f);
+            }
+            else {
+                content.Fill(ctx.surface.width, ctx.surface.height);
+            }
+            content.Trim(ctx.surface);
+        }
+        frameCache.Insert(key, ctx.surface, content);
+        return true;
+    }
+
+    static bool IsHoldFrame(const HUDState& state) {
+        return !state.isFadingOut && state.animFrame >= Config::ANIM_FRAMES && !state.isCrossfading();
+    }
+
+    // Live-Update der Prozentanzeige: zeigt die Fläche denselben Frame mit anderem Prozentwert, zeichnet der
+    // Rasterizer nur Bogenende und Text neu. Im Hold bekommt der Fade-Snapshot dieselben Rechtecke.
+    bool RedrawPercent(OutputLayer& layer, const FrameParams& params, const HUDState& state) {
+        if (!layer.shownExact || layer.shown.percent == params.percent) return false;
+        FrameParams shown = layer.shown;
+        shown.percent = params.percent;
+        if (shown != params) return false;
+
+        RenderContext ctx;
+        ctx.surface = layer.target->GetSurface();
+        ctx.graphics = layer.target->Context();
+        PixelRect rects[Config::MAX_THEME_OPS];
+        const int count = rasterizer->RedrawPercent(ctx, layer.shown.percent, params, rects);
+        if (count == 0) return false;
+
+        FrameSpans& content = layer.target->Content();
+        const bool patchSnapshot = IsHoldFrame(state) && layer.fadeSnapshot.IsValid()
+            && layer.fadeSnapshot.Percent() == layer.shown.percent;
+        for (int i = 0; i < count; ++i) {
+            content.Cover(rects[i]);
+            if (patchSnapshot) layer.fadeSnapshot.Patch(ctx.surface, rects[i], params.percent);
+            layer.redrawn = PixelRect::Hull(layer.redrawn, rects[i]);
+            popupStats.pixelsRedrawn += rects[i].Area();
+        }
+        popupStats.percentUpdates++;
+        layer.shown = params;
+        return true;
+    }
+
+    std::unique_ptr<IHudOutputs> outputs;
+    RenderTargetFactory targetFactory;
+    RasterizerFactory rasterizerFactory = nullptr;
+    std::unique_ptr<IHudRasterizer> rasterizer;
+    ThemeProgram theme = Theme::BuiltIn();
+    std::vector<std::unique_ptr<OutputLayer>> layers;   // eine pro Skalierung
+    std::vector<size_t> outputLayers;                   // Ausgabe -> Index in layers
+    bool outputsValid = false;
+    FrameCache frameCache;
+    FrameParams lastPresented;
+    bool hasPresented = false;
+    unsigned frameSerial = 0;
+    PopupStats popupStats;
+    std::unique_ptr<SharedFrameExport> frameExport;
+    std::unique_ptr<IBackdropSource> backdropSource;
+    std::vector<OutputBackdrop> backdrops;              // pro Ausgabe, nur während eines Popups
+};
+
+// Dauerhafter kleiner Ring in der Bildschirmecke, neben dem Popup. Kein Timer, kein Thread: Update kommt nur mit
+// Batterie-Ereignissen und zeichnet nur, wenn sich der ganze Prozentwert oder die Zustandsfarbe ändert. Fertige
+// Frames liegen im FrameCache; der nächste Prozentwert in Laderichtung wird gleich mitgezeichnet, ein Wechsel
+// ist dann eine Kopie in die Zeichenfläche und ein Upload.
+class MiniRingWidget {
+public:
+    struct Stats {
+        unsigned updates = 0;           // Batterie-Ereignisse
+        unsigned redraws = 0;           // ... davon mit neuem Bild
+        unsigned cacheHits = 0;         // ... davon ohne Rasterizer
+        unsigned rasterizations = 0;    // gezeichnete Frames, vorgerenderte eingeschlossen
+        unsigned presents = 0;
+    };
+
+    // Die App gibt ein Eckfenster, GDI-Zeichenfläche und GDI+-Schrift mit, der Snapshot-Test Speicher und Bitmap-Font
+    MiniRingWidget(std::unique_ptr<IHudOutputs> outputs, RenderTargetFactory targetFactory,
+        GlyphSourceFactory glyphSourceFactory)
+        : outputs(std::move(outputs)), target(targetFactory()),
+          rasterizer(glyphSourceFactory, Config::MINI_RING_SIZE), cache(Config::MINI_RING_CACHE_BYTES) {
+        rasterizer.SetTheme(Theme::MiniRing(theme));
+    }
+
+    void SetTheme(const ThemeProgram& program) {
+        theme = program;
+        rasterizer.SetTheme(Theme::MiniRing(theme));
+        cache.Clear();
+        shownValid = false;
+    }
+
+    // Bei WM_DISPLAYCHANGE: andere Ecke oder Skalierung, das aktuelle Bild neu zeigen
+    void RefreshOutputs() {
+        outputs->Refresh();
+        outputsValid = true;
+        if (!shownValid || outputs->Outputs().empty()) return;
+        FrameParams params = shown;
+        params.dpiScale = HudMetrics::BucketScale(outputs->Outputs().front().dpiScale);
+        Show(params);
+    }
+
+    // Bei jedem Batterie-Ereignis und nach Farbänderungen; ohne neues Bild sofort zurück
+    void Update(BYTE percent, bool isCharging, const AppSettings& appSettings) {
+        stats.updates++;
+        if (!outputsValid) RefreshOutputs();
+        if (outputs->Outputs().empty()) return;
+
+        charging = isCharging;
+        settings = appSettings;
+        const FrameParams params = ParamsFor(percent);
+        if (shownValid && params == shown) return;
+        Show(params);
+    }
+
+    const Stats& GetStats() const { return stats; }
+    const FrameCache::Stats& FrameCacheStats() const { return cache.GetStats(); }
+
+private:
+    FrameParams ParamsFor(int percent) const {
+        FrameParams params;
+        params.scale = 1.0f;
+        params.alpha = 255;
+        params.percent = static_cast<BYTE>(Utils::Clamp(percent, 0, 100));
+        params.themeArgb = HUDState::stateColor(params.percent, charging, settings, theme).GetValue();
+        params.dpiScale = HudMetrics::BucketScale(outputs->Outputs().front().dpiScale);
+        return params;
+    }
+
+    void Show(const FrameParams& params) {
+        const HudMetrics metrics = HudMetrics::ForScale(params.dpiScale, Config::MINI_RING_SIZE);
+        if (!target->Acquire(metrics.size, metrics.size)) return;
+        target->Flush();
+
+        PresentFrame frame;
+        frame.rasterizations = Produce(*target, params, metrics) ? 1 : 0;
+        if (frame.rasterizations == 0) stats.cacheHits++;
+        frame.surface = target->GetSurface();
+        frame.spans = &target->Content();
+        frame.dirty = PixelRect::Of(frame.surface);
+        frame.dc = target->MemoryDC();
+        frame.scale = metrics.scale;
+        frame.alpha = 255;
+        frame.serial = ++frameSerial;
+        outputs->Present(0, frame);
+        stats.presents++;
+        stats.redraws++;
+        shown = params;
+        shownValid = true;
+
+        // Der nächste Wert kommt fast immer in Laderichtung; jetzt zeichnen statt beim nächsten Ereignis
+        const FrameParams ahead = ParamsFor(params.percent + (charging ? 1 : -1));
+        if (ahead.percent == params.percent || cache.Contains(KeyFor(ahead))) return;
+        MemoryRenderTarget spare;
+        if (spare.Acquire(metrics.size, metrics.size)) Produce(spare, ahead, metrics);
+    }
+
+    static FrameCache::Key KeyFor(const FrameParams& params) {
+        return FrameCache::MakeKey(params.percent, params.themeArgb, 0, HudMetrics::BucketId(params.dpiScale),
+            params.quality);
+    }
+
+    // true, wenn neu gezeichnet (nicht aus dem Cache geholt)
+    bool Produce(IRenderTarget& surfaceTarget, const FrameParams& params, const HudMetrics& metrics) {
+        RenderContext ctx;
+        ctx.surface = surfaceTarget.GetSurface();
+        ctx.graphics = surfaceTarget.Context();
+        FrameSpans& content = surfaceTarget.Content();
+        const FrameCache::Key key = KeyFor(params);
+        if (cache.Lookup(key, ctx.surface, content)) return false;
+
+        ctx.surface = surfaceTarget.BeginFrame();
+        rasterizer.Draw(ctx, params);
+        const float radius = rasterizer.ContentRadius();
+        if (radius > 0.0f) {
+            content.Circle(ctx.surface.width, ctx.surface.height, metrics.center, metrics.center, radius + 1.0f);
+        }
+        else {
+            content.Fill(ctx.surface.width, ctx.surface.height);
+        }
+        content.Trim(ctx.surface);
+        cache.Insert(key, ctx.surface, content);
+        stats.rasterizations++;
+        return true;
+    }
+
+    std::unique_ptr<IHudOutputs> outputs;
+    std::unique_ptr<IRenderTarget> target;
+    SoftwareHudRasterizer rasterizer;
+    FrameCache cache;
+    ThemeProgram theme = Theme::BuiltIn();
+    AppSettings settings;
+    bool charging = false;
+    bool outputsValid = false;
+    FrameParams shown;
+    bool shownValid = false;
+    unsigned frameSerial = 0;
+    Stats stats;
+};
+
+// Tray-Icon mit Prozent und Ladezustand. Die Bilder für 0..100 × Zustandsfarbe × Skalierung entstehen beim ersten
+// Bedarf mit dem Rasterizer des HUD und bleiben im Cache. Update meldet nur, ob sich das Angezeigte ändert;
+// alle anderen Batterie-Ereignisse lassen das Tray in Ruhe.
+class TrayIconCache {
+public:
+    struct Stats {
+        unsigned updates = 0;
+        unsigned changes = 0;
+        unsigned rasterizations = 0;
+        size_t bytes = 0;
+    };
+
+    explicit TrayIconCache(GlyphSourceFactory glyphSourceFactory = &BitmapFontGlyphSource::Create)
+        : rasterizer(glyphSourceFactory, Config::TRAY_ICON_SIZE) {
+        rasterizer.SetTheme(Theme::TrayIcon(theme));
+    }
+
+    void SetTheme(const ThemeProgram& program) {
+        theme = program;
+        rasterizer.SetTheme(Theme::TrayIcon(theme));
+        images.clear();
+        stats.bytes = 0;
+        shownValid = false;
+    }
+
+    // true, wenn das Tray ein neues Icon oder einen neuen Tooltip braucht
+    bool Update(BYTE percent, bool isCharging, const AppSettings& settings, float dpiScale) {
+        stats.updates++;
+        FrameParams params;
+        params.scale = 1.0f;
+        params.alpha = 255;
+        params.percent = (percent > 100) ? 100 : percent;
+        params.themeArgb = HUDState::stateColor(params.percent, isCharging, settings, theme).GetValue();
+        params.dpiScale = HudMetrics::BucketScale(dpiScale);
+        if (shownValid && params == shown && isCharging == charging) return false;
+
+        shown = params;
+        charging = isCharging;
+        shownValid = true;
+        stats.changes++;
+        return true;
+    }
+
+    BYTE Percent() const { return shown.percent; }
+    bool IsCharging() const { return charging; }
+
+    // Pixel (premultiplied ARGB) des zuletzt gemeldeten Zustands
+    Surface Current() { return Image(shown); }
+
+    Surface Image(const FrameParams& params) {
+        const FrameCache::Key key = FrameCache::MakeKey(params.percent, params.themeArgb, 0,
+            HudMetrics::BucketId(params.dpiScale), params.quality);
+        const int size = HudMetrics::ForScale(params.dpiScale, Config::TRAY_ICON_SIZE).size;
+        std::vector<uint32_t>& pixels = images[key];
+        Surface surface;
+        surface.width = size;
+        surface.height = size;
+        surface.stride = size;
+        if (pixels.empty()) {
+            pixels.assign(static_cast<size_t>(size) * size, 0);
+            surface.pixels = pixels.data();
+            RenderContext ctx;
+            ctx.surface = surface;
+            rasterizer.Draw(ctx, params);
+            stats.rasterizations++;
+            stats.bytes += pixels.size() * sizeof(uint32_t);
+        }
+        surface.pixels = pixels.data();
+        return surface;
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    SoftwareHudRasterizer rasterizer;
+    ThemeProgram theme = Theme::BuiltIn();
+    std::unordered_map<FrameCache::Key, std::vector<uint32_t>> images;
+    FrameParams shown;
+    bool charging = false;
+    bool shownValid = false;
+    Stats stats;
+};
+
+// Wählt Bildrate und Qualitätsstufe: am Netzteil volle Rate, auf Akku die halbe. Liegt das gleitende Mittel der
+// Render-Zeit über dem Budget, geht es eine Stufe herunter, erst mit deutlichem Abstand wieder hinauf.
+// Die Uhr ist austauschbar, damit sich die Entscheidungen ohne echte Frames prüfen lassen.
+class FrameGovernor {
+public:
+    using Clock = Utils::MonotonicClock;
+
+    static constexpr int LEVELS = 4;
+
+    struct Stats {
+        unsigned frames = 0;
+        unsigned overBudget = 0;    // einzelne Frames über dem Budget ihrer Stufe
+        unsigned degrades = 0;
+        unsigned recoveries = 0;
+        unsigned powerChanges = 0;
+        double averageMs = 0.0;     // gleitendes Mittel zur letzten Entscheidung
+    };
+
+    explicit FrameGovernor(Clock clock = &Utils::NowMs) : clock(clock) {}
+
+    // Stufe: 0 = 60 fps voll, 1 = 30 fps voll, 2 = 30 fps ohne Glow, 3 = 20 fps Entwurf
+    static int StepFor(int level) { return TierAt(level).step; }
+    static RenderQuality QualityFor(int level) { return TierAt(level).quality; }
+
+    void SetPowerSource(bool onAC) {
+        const int base = onAC ? 0 : 1;
+        if (base == powerBase) return;
+        powerBase = base;
+        penalty = std::min(penalty, LEVELS - 1 - powerBase);
+        ClearWindow();
+        stats.powerChanges++;
+    }
+
+    int Level() const { return powerBase + penalty; }
+    int FrameStep() const { return StepFor(Level()); }     // Animationsframes pro Timer-Tick
+    int IntervalMs() const { return FrameStep() * Config::TIMER_INTERVAL_MS; }
+    RenderQuality Quality() const { return QualityFor(Level()); }
+
+    void BeginFrame() { frameStart = clock(); }
+
+    void EndFrame() {
+        const double ms = clock() - frameStart;
+        stats.frames++;
+        if (ms > Budget(Level())) stats.overBudget++;
+
+        window[windowPos] = ms;
+        windowPos = (windowPos + 1) % Config::GOVERNOR_WINDOW;
+        if (windowCount < Config::GOVERNOR_WINDOW) windowCount++;
+        if (windowCount < Config::GOVERNOR_WINDOW) return;
+
+        double sum = 0.0;
+        for (double sample : window) sum += sample;
+        stats.averageMs = sum / Config::GOVERNOR_WINDOW;
+
+        if (stats.averageMs > Budget(Level()) && Level() < LEVELS - 1) {
+            penalty++;
+            stats.degrades++;
+            ClearWindow();
+        }
+        else if (penalty > 0 && stats.averageMs < Budget(Level() - 1) * Config::GOVERNOR_RECOVER_SHARE) {
+            penalty--;
+            stats.recoveries++;
+            ClearWindow();
+        }
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Tier {
+        int step;
+        RenderQuality quality;
+    };
+
+    static const Tier& TierAt(int level) {
+        static const Tier tiers[LEVELS] = {
+            { 1, RenderQuality::Full }, { 2, RenderQuality::Full }, { 2, RenderQuality::NoGlow }, { 3, RenderQuality::Draft },
+        };
+        return tiers[Utils::Clamp(level, 0, LEVELS - 1)];
+    }
+
+    static double Budget(int level) {
+        return StepFor(level) * Config::TIMER_INTERVAL_MS * Config::FRAME_BUDGET_SHARE;
+    }
+
+    // Messungen der alten Stufe sagen über die neue nichts aus
+    void ClearWindow() { windowCount = 0; }
+
+    Clock clock;
+    int powerBase = 0;              // 0 am Netzteil, 1 auf Akku
+    int penalty = 0;                // Stufen wegen zu langsamer Frames
+    double frameStart = 0.0;
+    double window[Config::GOVERNOR_WINDOW] = {};
+    int windowPos = 0;
+    int windowCount = 0;
+    Stats stats;
+};
+
+// Taktet die Animation nach verstrichener Zeit statt nach Anzahl der WM_TIMER-Nachrichten: Frame n ist bei
+// Start + n * TIMER_INTERVAL_MS fällig. Ein verspäteter Tick überspringt die verpassten Frames (die Animation wird
+// nicht länger), und der nächste Timer zielt auf die nächste Frist statt auf "jetzt + Intervall".
+// Der Hold bleibt eine einzige lange Wartezeit.
+class FrameScheduler {
+public:
+    using Clock = Utils::MonotonicClock;
+
+    struct Stats {
+        unsigned frames = 0;            // Ticks mit Fortschritt
+        unsigned droppedFrames = 0;     // übersprungene Animationsframes
+        unsigned earlyWakeups = 0;      // vor der Frist geweckt, ohne Fortschritt
+        double jitterMs = 0.0;          // mittlerer Abstand der Weckzeit zur Frist
+        double maxLatenessMs = 0.0;
+        double longestGapMs = 0.0;      // längster Abstand zwischen zwei Ticks mit Fortschritt
+    };
+
+    explicit FrameScheduler(Clock clock = &Utils::NowMs) : clock(clock) {}
+
+    // Popup beginnt jetzt (Frame 0); Rückgabe: ms bis zum ersten Wecken
+    int Start(int step) {
+        origin = clock();
+        lastProgress = origin;
+        consumed = 0;
+        stats = Stats();
+        wakeups = 0;
+        return Plan(0, step);
+    }
+
+    // Beim Wecken: Animationsframes seit dem letzten Tick, 0 = zu früh (dann mit RemainingMs() neu stellen)
+    int DueFrames() {
+        const double now = clock();
+        const double lateness = now - Deadline(nextDue);
+        wakeups++;
+        stats.jitterMs += (std::fabs(lateness) - stats.jitterMs) / wakeups;
+
+        const int frame = FrameAt(now);
+        if (frame < nextDue) {
+            stats.earlyWakeups++;
+            return 0;
+        }
+
+        // Im Hold verlängert Verspätung nur die Wartezeit, es fällt kein sichtbarer Frame weg
+        if (!holding) stats.droppedFrames += frame - nextDue;
+        stats.maxLatenessMs = std::max(stats.maxLatenessMs, lateness);
+        stats.longestGapMs = std::max(stats.longestGapMs, now - lastProgress);
+        stats.frames++;
+        lastProgress = now;
+
+        const int due = frame - consumed;
+        consumed = frame;
+        return due;
+    }
+
+    // Nach HUDState::Tick mit dessen Rückgabe (0 = Bildtakt, step Frames pro Tick); Rückgabe: ms bis zum Wecken
+    int Schedule(int tickInterval, int step) {
+        return Plan(tickInterval, step);
+    }
+
+    // Nach HUDState::changeState: eine bis jetzt verstrichene Hold-Zeit braucht die Animation nicht nachzuholen,
+    // im Bildtakt holt der nächste Tick verpasste Frames wie gewohnt auf
+    int Restart(int tickInterval, int step) {
+        if (holding) consumed = std::max(consumed, FrameAt(clock()));
+        return Plan(tickInterval, step);
+    }
+
+    int RemainingMs() const {
+        return std::max(1, static_cast<int>(std::ceil(Deadline(nextDue) - clock())));
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    int Plan(int tickInterval, int step) {
+        holding = tickInterval > 0;
+        const int frames = holding ? std::max(1, tickInterval / Config::TIMER_INTERVAL_MS) : step;
+        nextDue = consumed + frames;
+        return RemainingMs();
+    }
+
+    int FrameAt(double now) const {
+        return static_cast<int>(std::floor((now - origin) / Config::TIMER_INTERVAL_MS));
+    }
+
+    double Deadline(int frame) const { return origin + static_cast<double>(frame) * Config::TIMER_INTERVAL_MS; }
+
+    Clock clock;
+    double origin = 0.0;
+    double lastProgress = 0.0;
+    int consumed = 0;               // bis hierher an HUDState::Tick weitergegeben
+    int nextDue = 0;
+    bool holding = false;
+    unsigned wakeups = 0;
+    Stats stats;
+};
@@ -0,0 +1,209 @@
+// Speicherlayout des Frame-Exports von Battery HUD (Kiosk-Shell, Overlays); gemeinsam für chargingV3.cpp
+// und hudconsumer.cpp. Ein Ring aus SLOT_COUNT Pixelpuffern hinter einem Kopf. Jeder Slot ist ein Seqlock:
+// ungerade Sequenz = wird gerade geschrieben. Leser lesen die Pixel direkt aus der Abbildung, ohne Kopie
+// und ohne Sperre, und prüfen danach, ob der Slot inzwischen überschrieben wurde.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace HudFrames {
+    constexpr uint32_t MAGIC = 0x46445548;                  // "HUDF"
+    constexpr uint32_t VERSION = 1;
+    constexpr uint32_t SLOT_COUNT = 3;                      // Schreiber überschreibt einen Slot erst zwei Frames später
+    constexpr uint32_t MAX_SIZE = 1400;                     // HUD_SIZE * größter Skalierungs-Bucket
+    constexpr uint32_t SLOT_BYTES = MAX_SIZE * MAX_SIZE * 4;
+    constexpr wchar_t WINDOWS_NAME[] = L"Local\\BatteryHUD.Frames";
+    constexpr char POSIX_NAME[] = "/BatteryHUD.Frames";
+
+    // Feste Größen und 8-Byte-Ausrichtung, damit 32- und 64-Bit-Prozesse dasselbe Layout sehen
+    struct alignas(8) SlotHeader {
+        std::atomic<uint64_t> sequence;     // 2 * frame, wenn fertig
+        uint64_t frame;
+        uint64_t timestampUs;               // monotone Uhr des Schreibers (QPC bzw. CLOCK_MONOTONIC)
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;                    // Bytes pro Zeile
+        uint32_t alpha;                     // Fade-Alpha 0..255, nicht in die Pixel eingerechnet
+        float scale;                        // Skalierungs-Bucket des Frames
+        uint32_t reserved;
+    };
+
+    struct alignas(8) RingHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t slotBytes;
+        uint64_t pixelOffset;               // Slot k beginnt bei pixelOffset + k * slotBytes
+        std::atomic<uint64_t> published;    // neuester fertiger Frame, 0 = noch keiner
+        SlotHeader slots[SLOT_COUNT];
+    };
+
+    static_assert(sizeof(std::atomic<uint64_t>) == 8, "atomic<uint64_t> muss 8 Byte groß sein");
+    static_assert(sizeof(SlotHeader) == 48 && sizeof(RingHeader) == 32 + SLOT_COUNT * 48, "Layout ist Teil des Formats");
+
+    constexpr uint64_t PIXEL_OFFSET = (sizeof(RingHeader) + 63) / 64 * 64;
+
+    constexpr uint64_t MappingBytes(uint32_t slotBytes = SLOT_BYTES) {
+        return PIXEL_OFFSET + static_cast<uint64_t>(SLOT_COUNT) * slotBytes;
+    }
+
+    // Die Pixel bleiben in der Abbildung; gültig, solange Reader::StillValid true liefert
+    struct FrameView {
+        const uint32_t* pixels = nullptr;
+        uint64_t frame = 0;
+        uint64_t timestampUs = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+        uint32_t alpha = 0;
+        float scale = 1.0f;
+
+        const uint32_t* Row(uint32_t y) const {
+            return reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(pixels) + static_cast<size_t>(y) * stride);
+        }
+    };
+
+    // Zeile eines Frames, die nur in [x0, x1) Pixel trägt; außerhalb ist sie 0
+    struct RowSpan {
+        uint32_t x0;
+        uint32_t x1;
+    };
+
+    // Genau ein Schreiber pro Ring
+    class Writer {
+    public:
+        explicit Writer(void* base)
+            : ring(static_cast<RingHeader*>(base)), pixels(static_cast<uint8_t*>(base) + PIXEL_OFFSET) {}
+
+        // Einmal nach dem Anlegen; Leser erkennen einen gültigen Ring erst an magic
+        void Init(uint32_t slotBytes = SLOT_BYTES) {
+            ring->version = VERSION;
+            ring->slotCount = SLOT_COUNT;
+            ring->slotBytes = slotBytes;
+            ring->pixelOffset = PIXEL_OFFSET;
+            for (SlotHeader& slot : ring->slots) slot.sequence.store(0, std::memory_order_relaxed);
+            ring->published.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            ring->magic = MAGIC;
+        }
+
+        // false, wenn der Frame nicht in einen Slot passt. Mit rows (eine pro Zeile) kopiert er nur die Spans und
+        // leert nur, was der Slot vorher außerhalb davon trug; ganz geleert wird ein Slot nur bei neuer Größe.
+        bool Publish(const uint32_t* src, uint32_t width, uint32_t height, uint32_t srcStride,
+            uint32_t alpha, float scale, uint64_t timestampUs, const RowSpan* rows = nullptr) {
+            const uint32_t stride = width * 4;
+            if (static_cast<uint64_t>(stride) * height > ring->slotBytes) return false;
+
+            const uint64_t frame = ring->published.load(std::memory_order_relaxed) + 1;
+            const uint32_t index = static_cast<uint32_t>(frame % SLOT_COUNT);
+            SlotHeader& slot = ring->slots[index];
+            slot.sequence.store(frame * 2 - 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            slot.frame = frame;
+            slot.timestampUs = timestampUs;
+            slot.width = width;
+            slot.height = height;
+            slot.stride = stride;
+            slot.alpha = alpha;
+            slot.scale = scale;
+            uint8_t* dst = pixels + static_cast<size_t>(index) * ring->slotBytes;
+            const uint8_t* row = reinterpret_cast<const uint8_t*>(src);
+            SlotContent& content = written[index];
+            if (!rows) {
+                if (srcStride == stride) {
+                    memcpy(dst, row, static_cast<size_t>(stride) * height);
+                }
+                else {
+                    for (uint32_t y = 0; y < height; ++y) memcpy(dst + static_cast<size_t>(y) * stride, row + static_cast<size_t>(y) * srcStride, stride);
+                }
+                content.width = width;
+                content.height = height;
+                content.rows.assign(height, RowSpan{ 0, width });
+            }
+            else {
+                if (content.width != width || content.height != height) {
+                    memset(dst, 0, static_cast<size_t>(stride) * height);
+                    content.width = width;
+                    content.height = height;
+                    content.rows.assign(height, RowSpan{ 0, 0 });
+                }
+                for (uint32_t y = 0; y < height; ++y) {
+                    uint32_t* line = reinterpret_cast<uint32_t*>(dst + static_cast<size_t>(y) * stride);
+                    const RowSpan span = rows[y].x1 > rows[y].x0 ? rows[y] : RowSpan{ 0, 0 };
+                    RowSpan& old = content.rows[y];
+                    const uint32_t leftEnd = std::min(old.x1, span.x0), rightStart = std::max(old.x0, span.x1);
+                    if (leftEnd > old.x0) memset(line + old.x0, 0, static_cast<size_t>(leftEnd - old.x0) * 4);
+                    if (old.x1 > rightStart) memset(line + rightStart, 0, static_cast<size_t>(old.x1 - rightStart) * 4);
+                    if (span.x1 > span.x0) {
+                        memcpy(line + span.x0, reinterpret_cast<const uint32_t*>(row + static_cast<size_t>(y) * srcStride) + span.x0,
+                            static_cast<size_t>(span.x1 - span.x0) * 4);
+                    }
+                    old = span;
+                }
+            }
+
+            slot.sequence.store(frame * 2, std::memory_order_release);
+            ring->published.store(frame, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        // Was zuletzt in jedem Slot steht; liegt nur beim Schreiber, nicht in der Abbildung
+        struct SlotContent {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<RowSpan> rows;
+        };
+
+        RingHeader* ring;
+        uint8_t* pixels;
+        SlotContent written[SLOT_COUNT];
+    };
+
+    class Reader {
+    public:
+        explicit Reader(const void* base)
+            : ring(static_cast<const RingHeader*>(base)), pixels(static_cast<const uint8_t*>(base) + PIXEL_OFFSET) {}
+
+        bool IsValid() const {
+            return ring->magic == MAGIC && ring->version == VERSION && ring->slotCount == SLOT_COUNT
+                && ring->pixelOffset == PIXEL_OFFSET;
+        }
+
+        uint64_t Latest() const {
+            return ring->published.load(std::memory_order_acquire);
+        }
+
+        // false, wenn der Frame gerade geschrieben wird oder schon überschrieben ist
+        bool Acquire(uint64_t frame, FrameView& view) const {
+            const uint32_t index = static_cast<uint32_t>(frame % SLOT_COUNT);
+            const SlotHeader& slot = ring->slots[index];
+            if (frame == 0 || slot.sequence.load(std::memory_order_acquire) != frame * 2) return false;
+
+            view.frame = frame;
+            view.timestampUs = slot.timestampUs;
+            view.width = slot.width;
+            view.height = slot.height;
+            view.stride = slot.stride;
+            view.alpha = slot.alpha;
+            view.scale = slot.scale;
+            view.pixels = reinterpret_cast<const uint32_t*>(pixels + static_cast<size_t>(index) * ring->slotBytes);
+            if (view.stride < view.width * 4 || static_cast<uint64_t>(view.stride) * view.height > ring->slotBytes) return false;
+            return StillValid(view);
+        }
+
+        // Nach dem Lesen der Pixel: false, wenn der Schreiber den Slot inzwischen angefasst hat (Frame verwerfen)
+        bool StillValid(const FrameView& view) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return ring->slots[view.frame % SLOT_COUNT].sequence.load(std::memory_order_relaxed) == view.frame * 2;
+        }
+
+    private:
+        const RingHeader* ring;
+        const uint8_t* pixels;
+    };
+}
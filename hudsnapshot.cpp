@@ -0,0 +1,32 @@
+// Snapshot-Test von Battery HUD als eigenes Programm, ohne Fenster und ohne GDI+ (hudsnapshot.h).
+// Vergleicht mit den eingecheckten Goldens in snapshots/ und schreibt summary.txt dorthin; die Zusammenfassung
+// kommt auch auf stdout. Exit-Code 0 = alles gleich bzw. innerhalb der Toleranz.
+//
+//   hudsnapshot [verify|record] [verzeichnis] [scalar|sse2|avx2|avx512]
+//
+// Windows: cl /O2 /EHsc hudsnapshot.cpp
+// Linux:   g++ -O2 -std=c++14 -pthread hudsnapshot.cpp -o hudsnapshot -lrt
+#include "hudcore.h"
+#include "hudsnapshot.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    const std::string mode = argc > 1 ? argv[1] : "verify";
+    const std::string dir = argc > 2 ? argv[2] : "snapshots";
+    Raster::SimdLevel level = Raster::DetectSimdLevel();
+    const std::string simd = argc > 3 ? argv[3] : "";
+    if ((mode != "verify" && mode != "record") || (!simd.empty() && !Raster::ParseSimdLevel(std::wstring(simd.begin(), simd.end()), level))) {
+        fprintf(stderr, "usage: hudsnapshot [verify|record] [dir] [scalar|sse2|avx2|avx512]\n");
+        return 2;
+    }
+    Raster::SelectKernels(level);
+
+    const Snapshot::Path path(dir.begin(), dir.end());
+    const int exitCode = Snapshot::Run(path, mode == "record");
+    std::ifstream summary(Snapshot::Join(path, "summary.txt").c_str(), std::ios::binary);
+    std::cout << summary.rdbuf();
+    return exitCode;
+}
@@ -0,0 +1,1655 @@
+// Snapshot-Test von Battery HUD: rendert die Fälle aus CASES headless (Speicher-Ziel, Software-Rasterizer,
+// Bitmap-Font) und vergleicht sie mit den Goldens in snapshots/, danach die Prüfungen und Messungen aus CHECKS.
+// Aufgerufen von der App (--snapshot-verify/--snapshot-record <dir>) und von hudsnapshot.cpp.
+#pragma once
+#include "hudcore.h"
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Headless-Regressionstest des ganzen Popups: jede Animationsphase für eine Matrix aus Prozent und Farben,
+// verglichen mit Goldens (32bpp BMP). "--snapshot-record <dir>" schreibt sie, "--snapshot-verify <dir>" prüft.
+namespace Snapshot {
+    struct Case {
+        BYTE percent;
+        bool charging;
+        bool customColor;
+        int flipAfter;          // Ladegerät nach diesem Frame umstecken (Farbübergang), -1 = nie
+        int level;              // FrameGovernor-Stufe (Schrittweite und Qualität)
+    };
+
+    // Ränder, Farbwechsel bei 20 %, Lade-/Entladefarbe, eigene Farben, Übergang im Intro und im Hold,
+    // reduzierte Stufen (auch mit Übergang)
+    const Case CASES[] = {
+        { 100, true, false, -1, 0 }, { 73, true, false, -1, 0 }, { 20, true, false, -1, 0 }, { 19, true, false, -1, 0 },
+        { 50, false, false, -1, 0 }, { 42, true, true, -1, 0 }, { 8, false, true, -1, 0 },
+        { 73, true, false, 29, 0 }, { 19, true, false, 10, 0 },
+        { 73, true, false, -1, 2 }, { 50, false, false, 4, 3 },
+    };
+
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> pixels;
+    };
+
+    // Eine Ausgabe mit Skalierung 1 (unabhängig von der DPI der Maschine); hält den letzten Frame als Kopie.
+    // Übernimmt wie ein Layered Window nur das geänderte Rechteck, damit die Goldens auch das prüfen, und zählt
+    // Pixel außerhalb der Spans, die nicht transparent sind.
+    class CaptureOutputs : public IHudOutputs {
+    public:
+        CaptureOutputs() : outputs(1) {}
+
+        void Refresh() override {}
+        const std::vector<HudOutput>& Outputs() const override { return outputs; }
+
+        void Present(size_t, const PresentFrame& frame) override {
+            const Surface& surface = frame.surface;
+            PixelRect rect = frame.dirty;
+            if (image.width != surface.width || image.height != surface.height) {
+                image.width = surface.width;
+                image.height = surface.height;
+                image.pixels.assign(static_cast<size_t>(surface.width) * surface.height, 0);
+                rect = PixelRect::Of(surface);
+            }
+            for (int y = rect.y0; y < rect.y1; ++y) {
+                memcpy(&image.pixels[static_cast<size_t>(y) * surface.width + rect.x0], surface.Row(y) + rect.x0,
+                    (rect.x1 - rect.x0) * sizeof(uint32_t));
+            }
+
+            for (int y = 0; y < surface.height; ++y) {
+                const FrameSpans::Span span = frame.spans->Row(y);
+                const uint32_t* row = surface.Row(y);
+                for (int x = 0; x < surface.width; ++x) {
+                    if (row[x] != 0 && (x < span.x0 || x >= span.x1)) outsideSpans++;
+                }
+            }
+            emptyFrames += frame.alpha == 0 ? 1 : 0;
+            presented = true;
+        }
+
+        Image image;
+        bool presented = false;
+        unsigned outsideSpans = 0;
+        unsigned emptyFrames = 0;   // Frames mit Alpha 0: Fläche nur geleert
+
+    private:
+        std::vector<HudOutput> outputs;
+    };
+
+    // Pfade so, wie fstream sie auf der Plattform öffnet: unter Windows breit, sonst UTF-8
+#if defined(_WIN32)
+    using Path = std::wstring;
+
+    inline Path Join(const Path& dir, const std::string& name) { return dir + L"\\" + Path(name.begin(), name.end()); }
+    inline void MakeDirectory(const Path& dir) { CreateDirectoryW(dir.c_str(), nullptr); }
+#else
+    using Path = std::string;
+
+    inline Path Join(const Path& dir, const std::string& name) { return dir + "/" + name; }
+    inline void MakeDirectory(const Path& dir) { mkdir(dir.c_str(), 0755); }
+#endif
+
+    // BITMAPFILEHEADER + BITMAPINFOHEADER am Stück, ohne windows.h
+#pragma pack(push, 2)
+    struct BmpHeader {
+        uint16_t type = 0x4D42;     // "BM"
+        uint32_t fileBytes = 0;
+        uint32_t reserved = 0;
+        uint32_t pixelOffset = 54;
+        uint32_t infoBytes = 40;
+        int32_t width = 0;
+        int32_t height = 0;         // negativ = top-down
+        uint16_t planes = 1;
+        uint16_t bitCount = 32;
+        uint32_t compression = 0;   // BI_RGB
+        uint32_t imageBytes = 0;
+        int32_t pixelsPerMeterX = 0;
+        int32_t pixelsPerMeterY = 0;
+        uint32_t colorsUsed = 0;
+        uint32_t colorsImportant = 0;
+    };
+#pragma pack(pop)
+    static_assert(sizeof(BmpHeader) == 54, "BMP-Kopf ohne Lücken");
+
+    inline bool WriteBmp(const Path& path, const Image& image) {
+        const uint32_t bytes = static_cast<uint32_t>(image.pixels.size() * sizeof(uint32_t));
+        BmpHeader header;
+        header.width = image.width;
+        header.height = -image.height;
+        header.imageBytes = bytes;
+        header.fileBytes = header.pixelOffset + bytes;
+
+        std::ofstream file(path.c_str(), std::ios::binary);
+        if (!file.is_open()) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(image.pixels.data()), bytes);
+        return file.good();
+    }
+
+    // Liest nur, was WriteBmp schreibt: 32bpp, unkomprimiert, top-down
+    inline bool ReadBmp(const Path& path, Image& image) {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file.is_open()) return false;
+
+        BmpHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file.good() || header.type != 0x4D42 || header.bitCount != 32 || header.compression != 0
+            || header.width <= 0 || header.width > 4096 || header.height >= 0 || header.height < -4096) {
+            return false;
+        }
+
+        image.width = header.width;
+        image.height = -header.height;
+        image.pixels.resize(static_cast<size_t>(image.width) * image.height);
+        file.seekg(header.pixelOffset);
+        file.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size() * sizeof(uint32_t));
+        return file.good();
+    }
+
+    // FNV-1a über die Pixelwörter; unabhängig von der Bytereihenfolge
+    inline uint64_t Hash(const Image& image) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (uint32_t pixel : image.pixels) {
+            hash ^= pixel;
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    // Goldens im Repository: ein Hash pro Frame in frames.txt, dazu wenige Schlüsselbilder als BMP, die mit
+    // Toleranz verglichen werden (Intro, Farbübergang bei 20 %, eigene Farbe im Fade, reduzierte Stufe)
+    const char* const KEY_FRAMES[] = {
+        "p073_charge_f10", "p019_charge_flip_f20", "p042_charge_custom_f42", "p050_discharge_flip_l3_f08",
+    };
+
+    inline bool IsKeyFrame(const std::string& name) {
+        return std::find_if(std::begin(KEY_FRAMES), std::end(KEY_FRAMES),
+            [&name](const char* key) { return name == key; }) != std::end(KEY_FRAMES);
+    }
+
+    struct FrameHash {
+        int width = 0;
+        int height = 0;
+        uint64_t hash = 0;
+    };
+
+    // Zeilen "name breite höhe hash"; # leitet Kommentare ein
+    inline std::unordered_map<std::string, FrameHash> ReadHashes(const Path& path) {
+        std::unordered_map<std::string, FrameHash> hashes;
+        std::ifstream file(path.c_str());
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            char name[64];
+            FrameHash frame;
+            unsigned long long hash = 0;
+            if (sscanf(line.c_str(), "%63s %d %d %llx", name, &frame.width, &frame.height, &hash) != 4) continue;
+            frame.hash = hash;
+            hashes[name] = frame;
+        }
+        return hashes;
+    }
+
+    // Abweichende Pixel magenta, der Rest abgedunkelt zur Orientierung
+    inline Image DiffImage(const Image& golden, const Image& actual) {
+        Image diff = actual;
+        for (size_t i = 0; i < diff.pixels.size(); ++i) {
+            diff.pixels[i] = Raster::ChannelDiff(golden.pixels[i], actual.pixels[i]) > Config::SNAPSHOT_TOLERANCE
+                ? 0xFFFF00FFu
+                : 0xFF000000u | ((actual.pixels[i] >> 2) & 0x003F3F3Fu);
+        }
+        return diff;
+    }
+
+    inline std::string FrameName(const Case& c, int ordinal) {
+        char name[64];
+        char level[16] = "";
+        if (c.level > 0) snprintf(level, sizeof(level), "_l%d", c.level);
+        snprintf(name, sizeof(name), "p%03u_%s%s%s%s_f%02d", static_cast<unsigned>(c.percent),
+            c.charging ? "charge" : "discharge", c.customColor ? "_custom" : "", c.flipAfter >= 0 ? "_flip" : "", level, ordinal);
+        return name;
+    }
+
+    // Erwartungen einer Prüfung: zählt verletzte und schreibt sie als "FAIL <Prüfung>: <was>" in den Bericht
+    class Expect {
+    public:
+        Expect(std::string& report, const char* check) : report(report), check(check) {}
+
+        void operator()(bool condition, const std::string& what) {
+            if (condition) return;
+            failures++;
+            report += std::string("FAIL ") + check + ": " + what + "\n";
+        }
+
+        int failures = 0;
+
+    private:
+        std::string& report;
+        const char* check;
+    };
+
+    // Reicht alles an den Software-Rasterizer durch und zählt die vollen Draws
+    class CountingRasterizer : public IHudRasterizer {
+    public:
+        explicit CountingRasterizer(std::unique_ptr<IHudRasterizer> inner) : inner(std::move(inner)) {}
+
+        void Draw(const RenderContext& ctx, const FrameParams& params) override {
+            draws++;
+            inner->Draw(ctx, params);
+        }
+        GeometryCacheStats RingCacheStats() const override { return inner->RingCacheStats(); }
+        void SetTheme(const ThemeProgram& theme) override { inner->SetTheme(theme); }
+        float ContentRadius() const override { return inner->ContentRadius(); }
+        int RedrawPercent(const RenderContext& ctx, BYTE shownPercent, const FrameParams& params, PixelRect* rects) override {
+            return inner->RedrawPercent(ctx, shownPercent, params, rects);
+        }
+
+        unsigned draws = 0;
+
+    private:
+        std::unique_ptr<IHudRasterizer> inner;
+    };
+
+    // Renderer ohne Fenster; outputs zeigt auf die Ausgabe, die der Renderer besitzt
+    template <typename Renderer, typename Outputs>
+    struct Headless {
+        Outputs& outputs;
+        std::unique_ptr<Renderer> renderer;
+    };
+
+    // Speicher-Ziel, Software-Rasterizer, Bitmap-Font statt GDI+-Text: hängt nicht von installierten Schriften ab
+    template <typename Outputs = CaptureOutputs>
+    Headless<HUDRenderer, Outputs> MakeHeadlessRenderer(const ThemeProgram& theme,
+        std::unique_ptr<IHudRasterizer> rasterizer = std::make_unique<SoftwareHudRasterizer>(&BitmapFontGlyphSource::Create)) {
+        auto capture = std::make_unique<Outputs>();
+        Outputs& outputs = *capture;
+        auto renderer = std::make_unique<HUDRenderer>(std::move(capture), &MemoryRenderTarget::Create, std::move(rasterizer));
+        renderer->SetTheme(theme);
+        return { outputs, std::move(renderer) };
+    }
+
+    inline Headless<MiniRingWidget, CaptureOutputs> MakeHeadlessMiniRing() {
+        auto capture = std::make_unique<CaptureOutputs>();
+        CaptureOutputs& outputs = *capture;
+        return { outputs, std::make_unique<MiniRingWidget>(std::move(capture), &MemoryRenderTarget::Create,
+            &BitmapFontGlyphSource::Create) };
+    }
+
+    // Übergangskernel (mit SIMD-Pfad) gegen Float-Referenz über alle Kanalpaare, höchstens 1 LSB daneben
+    inline int CheckLinearLight(std::string& report, std::string& summary) {
+        const int weights[] = { 1, 16, 64, 128, 200, 255 };
+        std::vector<uint32_t> from(256), to(256), mixed(256);
+        int maxError = 0;
+        unsigned samples = 0;
+
+        for (int weight : weights) {
+            Raster::LinearCrossfade crossfade;
+            crossfade.Prepare(weight);
+            const float t = weight / 256.0f;
+            for (int a = 0; a < 256; ++a) {
+                for (int b = 0; b < 256; ++b) {
+                    from[b] = 0xFF000000u | (static_cast<uint32_t>(a) * 0x010101u);
+                    to[b] = 0xFF000000u | (static_cast<uint32_t>(255 - b) << 16) | (static_cast<uint32_t>(b) * 0x0101u);
+                }
+                crossfade.Span(mixed.data(), from.data(), to.data(), 256);
+
+                for (int b = 0; b < 256; ++b) {
+                    for (int shift = 0; shift < 32; shift += 8) {
+                        const float ca = ((from[b] >> shift) & 0xFF) / 255.0f;
+                        const float cb = ((to[b] >> shift) & 0xFF) / 255.0f;
+                        const int expected = (shift == 24) ? 255 : static_cast<int>(std::lrint(255.0f
+                            * Raster::EncodeSrgb(Raster::DecodeSrgb(ca) * (1.0f - t) + Raster::DecodeSrgb(cb) * t)));
+                        const int actual = static_cast<int>((mixed[b] >> shift) & 0xFF);
+                        maxError = std::max(maxError, std::abs(actual - expected));
+                        samples++;
+                    }
+                }
+            }
+        }
+
+        Expect expect(report, "linear light");
+        expect(maxError <= 1, "max error " + std::to_string(maxError) + " LSB");
+        summary += "linear light: max error " + std::to_string(maxError) + " LSB over " + std::to_string(samples) + " samples\n";
+        return expect.failures;
+    }
+
+    // Durchsatz jeder verfügbaren Stufe in Megapixel/s, je Kernel eine 1024er Zeile für etwa 20 ms
+    inline std::string BenchmarkKernels() {
+        const int width = 1024;
+        std::vector<uint32_t> dst(width, 0x40102030u), a(width, 0x80402010u), b(width, 0xFF20A0F0u);
+        std::vector<float> cov(width, 0.5f), out(width);
+        std::vector<uint16_t> sums(width * 4, 700);
+        const Raster::ArcGeometry arc(512.0f, 0.0f, 400.0f, 8.0f, -90.0f, 250.0f);
+        // Verkleinerung auf 0.93 wie im Fade
+        std::vector<int32_t> index(width);
+        std::vector<uint8_t> frac(width);
+        for (int x = 0; x < width; ++x) {
+            const float u = x * 0.93f;
+            index[x] = static_cast<int32_t>(u);
+            frac[x] = static_cast<uint8_t>((u - index[x]) * 256.0f);
+        }
+
+        std::string result;
+        for (int k = 0; k <= static_cast<int>(Raster::DetectSimdLevel()); ++k) {
+            const Raster::SpanKernels& kernels = Raster::KernelsFor(static_cast<Raster::SimdLevel>(k));
+            auto measure = [&](auto run) {
+                const double start = Utils::NowMs();
+                double elapsed = 0.0;
+                long long spans = 0;
+                do {
+                    for (int r = 0; r < 64; ++r) run();
+                    spans += 64;
+                    elapsed = Utils::NowMs() - start;
+                } while (elapsed < 20.0);
+                return static_cast<double>(spans) * width / (elapsed * 1000.0);
+            };
+
+            const double solid = measure([&] { kernels.blendSolid(dst.data(), cov.data(), width, 0x3CB4FFu, 0.8f); });
+            const double glow = measure([&] { kernels.blendGlow(dst.data(), cov.data(), width, 0xFF8020u, 200.0f); });
+            const double radial = measure([&] { kernels.radialFalloff(out.data(), 0, width, -511.5f, 3.5f, 1.0f / 512.0f); });
+            const double arcs = measure([&] { kernels.arcCoverage(out.data(), 0, width, -511.5f, 300.5f, arc); });
+            const double scale = measure([&] { kernels.scaleAlpha(dst.data(), a.data(), width, 77); });
+            const double blendRows = measure([&] { kernels.blendRows(dst.data(), a.data(), b.data(), width, 100, 156); });
+            const double resample = measure([&] { kernels.resampleRow(dst.data(), a.data(), index.data(), frac.data(), width); });
+            const double boxSum = measure([&] { kernels.boxSumRow(sums.data(), a.data(), a.data(), width); });
+            const double boxAverage = measure([&] { kernels.boxAverageRow(dst.data(), sums.data(), width, 3, 9363); });
+            const double behind = measure([&] { kernels.blendBehind(dst.data(), b.data(), width, 190); });
+            const double equalRun = measure([&] { kernels.equalRun(a.data(), a.data(), width); });
+            int maxDiff = 0;
+            const double diff = measure([&] { kernels.diff(a.data(), b.data(), width, 2, maxDiff); });
+
+            char line[360];
+            snprintf(line, sizeof(line), "kernels %-6s Mpx/s: blendSolid %.0f, blendGlow %.0f, radialFalloff %.0f, "
+                "arcCoverage %.0f, scaleAlpha %.0f, blendRows %.0f, resampleRow %.0f, boxSumRow %.0f, boxAverageRow %.0f, "
+                "blendBehind %.0f, equalRun %.0f, diff %.0f\n", Raster::SimdLevelName(kernels.level), solid, glow, radial, arcs,
+                scale, blendRows, resample, boxSum, boxAverage, behind, equalRun, diff);
+            result += line;
+        }
+        return result;
+    }
+
+    // Jede verfügbare Kernel-Stufe bitgenau gegen die skalare, über alle Restlängen und versetzte Quellen,
+    // danach der Durchsatz jeder Stufe; Rückgabe = Anzahl abweichender Ausgaben
+    inline int CheckKernels(std::string& report, std::string& summary) {
+        const Raster::SpanKernels& reference = Raster::KernelsFor(Raster::SimdLevel::Scalar);
+        const int maxCount = 301;
+
+        // xorshift: beliebige Kanäle, Abdeckung auch über 1 (wird auf 1 begrenzt)
+        uint32_t seed = 0x2545F491u;
+        auto next = [&seed]() { seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5; return seed; };
+        std::vector<uint32_t> pixelsA(maxCount + 3), pixelsB(maxCount + 3);
+        std::vector<float> coverage(maxCount + 1);
+        for (int k = 0; k <= maxCount; ++k) {
+            pixelsA[k] = next();
+            pixelsB[k] = next();
+            coverage[k] = static_cast<float>(next() % 1200) / 1000.0f;
+        }
+        pixelsB[maxCount + 1] = next();
+        pixelsB[maxCount + 2] = next();
+        const Raster::ArcGeometry arcs[] = {
+            { 0.0f, 0.0f, 120.0f, 6.5f, -90.0f, 100.0f },
+            { 0.0f, 0.0f, 120.0f, 6.5f, 30.0f, 250.0f },
+            { 0.0f, 0.0f, 120.0f, 6.5f, 0.0f, 360.0f },
+            { 0.0f, 0.0f, 120.0f, 6.5f, -90.0f, 356.4f },     // Kappen überlappen
+        };
+        const float rows[] = { -118.5f, -114.5f, -40.5f, 3.5f, 97.5f };
+
+        Expect check(report, "kernels");
+        for (int k = static_cast<int>(Raster::SimdLevel::SSE2); k <= static_cast<int>(Raster::DetectSimdLevel()); ++k) {
+            const Raster::SpanKernels& variant = Raster::KernelsFor(static_cast<Raster::SimdLevel>(k));
+            auto expect = [&](bool same, const char* kernel, int count) {
+                if (same) return;
+                check(false, std::string(kernel) + " " + Raster::SimdLevelName(variant.level) + " weicht bei Länge "
+                    + std::to_string(count) + " ab");
+            };
+            auto sameBits = [](const std::vector<float>& x, const std::vector<float>& y) {
+                return x.empty() || memcmp(x.data(), y.data(), x.size() * sizeof(float)) == 0;
+            };
+
+            for (int count = 0; count <= maxCount; count += (count < 40) ? 1 : 29) {
+                const int offset = count & 1;
+                const uint32_t* a = pixelsA.data() + offset;
+                const uint32_t* b = pixelsB.data() + offset;
+                const float* cov = coverage.data() + offset;
+
+                std::vector<uint32_t> want(a, a + count), got(want);
+                reference.blendSolid(want.data(), cov, count, 0x3CB4FFu, 0.8f);
+                variant.blendSolid(got.data(), cov, count, 0x3CB4FFu, 0.8f);
+                expect(want == got, "blendSolid", count);
+
+                want.assign(a, a + count);
+                got = want;
+                reference.blendGlow(want.data(), cov, count, 0xFF8020u, 200.0f);
+                variant.blendGlow(got.data(), cov, count, 0xFF8020u, 200.0f);
+                expect(want == got, "blendGlow", count);
+
+                reference.scaleAlpha(want.data(), a, count, 77);
+                variant.scaleAlpha(got.data(), a, count, 77);
+                expect(want == got, "scaleAlpha", count);
+
+                reference.blendRows(want.data(), a, b, count, 100, 156);
+                variant.blendRows(got.data(), a, b, count, 100, 156);
+                expect(want == got, "blendRows", count);
+
+                // Index von -1 bis count - 1, Gewichte 0..255; src hat davor und dahinter je ein Pixel
+                std::vector<int32_t> index(count);
+                std::vector<uint8_t> frac(count);
+                for (int k = 0; k < count; ++k) {
+                    index[k] = static_cast<int32_t>(next() % (count + 1)) - 1;
+                    frac[k] = static_cast<uint8_t>(next());
+                }
+                reference.resampleRow(want.data(), b + 1, index.data(), frac.data(), count);
+                variant.resampleRow(got.data(), b + 1, index.data(), frac.data(), count);
+                expect(want == got, "resampleRow", count);
+
+                want.assign(a, a + count);
+                got = want;
+                reference.blendBehind(want.data(), b, count, 190);
+                variant.blendBehind(got.data(), b, count, 190);
+                expect(want == got, "blendBehind", count);
+
+                // Gleich bis auf ein Pixel an jeder Stelle, auch am Ende; Abweichungen um die Toleranz herum
+                std::vector<uint32_t> same(a, a + count + 1);
+                for (int stop = 0; stop <= count; stop += (stop < 40) ? 1 : 13) {
+                    same[stop] ^= 0x00010000u;
+                    expect(reference.equalRun(a, same.data(), count) == variant.equalRun(a, same.data(), count), "equalRun", count);
+                    same[stop] ^= 0x00010000u;
+                }
+                for (int k = 0; k < count; ++k) same[k] += (next() % 7) * 0x01010101u & 0x03030303u;
+                for (int tolerance : { 0, 1, 2, 255 }) {
+                    int wantMax = 0, gotMax = 0;
+                    const int wantFailing = reference.diff(a, same.data(), count, tolerance, wantMax);
+                    const int gotFailing = variant.diff(a, same.data(), count, tolerance, gotMax);
+                    expect(wantFailing == gotFailing && wantMax == gotMax, "diff", count);
+                    wantMax = gotMax = 0;
+                    expect(reference.diff(a, b, count, tolerance, wantMax) == variant.diff(a, b, count, tolerance, gotMax)
+                        && wantMax == gotMax, "diff", count);
+                }
+
+                // Summen wie bei einer Box aus 7 Pixeln; Mittel aus zufälligen Summen bis 7 * 255
+                std::vector<uint16_t> wantSum(count * 4), gotSum;
+                for (uint16_t& value : wantSum) value = static_cast<uint16_t>(next() % (7 * 255 + 1));
+                gotSum = wantSum;
+                reference.boxAverageRow(want.data(), wantSum.data(), count, 3, (65536 + 6) / 7);
+                variant.boxAverageRow(got.data(), gotSum.data(), count, 3, (65536 + 6) / 7);
+                expect(want == got, "boxAverageRow", count);
+                reference.boxSumRow(wantSum.data(), a, b, count);
+                variant.boxSumRow(gotSum.data(), a, b, count);
+                expect(wantSum == gotSum, "boxSumRow", count);
+
+                std::vector<float> wantF(count), gotF(count);
+                reference.radialFalloff(wantF.data(), 0, count, -37.3f - offset, 5.5f, 1.0f / 41.7f);
+                variant.radialFalloff(gotF.data(), 0, count, -37.3f - offset, 5.5f, 1.0f / 41.7f);
+                expect(sameBits(wantF, gotF), "radialFalloff", count);
+
+                for (const Raster::ArcGeometry& arc : arcs) {
+                    for (float dy : rows) {
+                        reference.arcCoverage(wantF.data(), 0, count, -130.5f + offset, dy, arc);
+                        variant.arcCoverage(gotF.data(), 0, count, -130.5f + offset, dy, arc);
+                        expect(sameBits(wantF, gotF), "arcCoverage", count);
+                    }
+                }
+            }
+        }
+        summary += BenchmarkKernels();
+        return check.failures;
+    }
+
+    // Glow aus dem Cache gegen GlowCache::Rasterize: bei voller Deckung bitgleich, mit Alpha skaliert höchstens
+    // 2 LSB (Rasterize rundet alpha / 4 ab); misst beide Wege pro Frame
+    inline int CheckGlowCache(std::string& report, std::string& summary) {
+        Expect expect(report, "glow cache");
+        const int size = Config::HUD_SIZE;
+        const uint32_t color = 0xFF00E678u;
+        std::vector<uint32_t> referencePixels(static_cast<size_t>(size) * size), scaled(referencePixels.size());
+        Surface reference;
+        reference.pixels = referencePixels.data();
+        reference.width = size;
+        reference.height = size;
+        reference.stride = size;
+
+        GlowCache cache;
+        const Surface& cached = cache.Get(color, size);
+        GlowCache::Rasterize(reference, color, 255);
+        expect(memcmp(cached.pixels, reference.pixels, referencePixels.size() * sizeof(uint32_t)) == 0,
+            "cached glow differs from Rasterize at alpha 255");
+        cache.Get(color, size);
+        cache.Get(0xFFFF9632u, size);
+        expect(cache.GetStats().builds == 2 && cache.GetStats().hits == 1,
+            std::to_string(cache.GetStats().builds) + " builds, " + std::to_string(cache.GetStats().hits)
+            + " hits for color, same color, new color");
+
+        const Surface& glow = cache.Get(color, size);
+        int maxDiff = 0;
+        for (int alpha = 0; alpha <= 255; alpha += 15) {
+            GlowCache::Rasterize(reference, color, alpha);
+            Raster::ScaleAlphaSpan(scaled.data(), glow.pixels, static_cast<int>(scaled.size()), Raster::AlphaToFactor(alpha));
+            for (size_t i = 0; i < scaled.size(); ++i) maxDiff = std::max(maxDiff, Raster::ChannelDiff(scaled[i], referencePixels[i]));
+        }
+        expect(maxDiff <= 2, "scaled cached glow off by " + std::to_string(maxDiff));
+
+        // Ohne Cache rechnet jeder Frame den Verlauf neu, mit Cache bleibt nur die Alpha-Skalierung
+        auto measure = [](auto run) {
+            const double start = Utils::NowMs();
+            double elapsed = 0.0;
+            int frames = 0;
+            do {
+                run(frames++);
+                elapsed = Utils::NowMs() - start;
+            } while (elapsed < 20.0);
+            return elapsed / frames;
+        };
+        const double uncachedMs = measure([&](int frame) { GlowCache::Rasterize(reference, color, 255 - (frame & 127)); });
+        const double cachedMs = measure([&](int frame) {
+            const Surface& layer = cache.Get(color, size);
+            Raster::ScaleAlphaSpan(scaled.data(), layer.pixels, static_cast<int>(scaled.size()),
+                Raster::AlphaToFactor(255 - (frame & 127)));
+        });
+
+        char line[160];
+        snprintf(line, sizeof(line), "glow cache: uncached %.3f ms, cached %.3f ms per frame at %d px, max diff %d\n",
+            uncachedMs, cachedMs, size, maxDiff);
+        summary += line;
+        return expect.failures;
+    }
+
+    // Abdeckung aus der Abstandsfunktion gegen ein überabgetastetes Referenzbild: pro Pixel höchstens 32/255 daneben,
+    // Fläche auf 0.1 % genau, auch wenn sich bei fast vollem Bogen die Kappen überlappen. 8x8 Abtastpunkte: ein
+    // 4x4-Raster liegt selbst bis zu 1/16 daneben und allein damit schon über der Grenze. Der Box-Filter quer zur
+    // Kante macht jede geschlossene Kontur um pi/12 px² zu groß (Kreis: pi * (r² + 1/12)); das zählt nur bei den
+    // kürzesten Bögen und ist erlaubt.
+    inline int CheckArcCoverage(std::string& report, std::string& summary) {
+        Expect expect(report, "arc coverage");
+        const ThemeProgram theme = Theme::BuiltIn();
+        const int grid = 8;
+        std::vector<float> coverage, scratch;
+        int worstDiff = 0, arcs = 0;
+        double worstArea = 0.0;
+        for (float scale : { 1.0f, 1.5f, 2.0f }) {
+            const int size = static_cast<int>(Config::HUD_SIZE * scale);
+            const float center = size / 2.0f;
+            PixelRect bounds;
+            bounds.x1 = size;
+            bounds.y1 = size;
+            for (int percent = 1; percent <= 100; percent += percent < 91 ? 9 : 1) {
+                for (int op = 0; op < theme.opCount; ++op) {
+                    const ThemeOp& src = theme.ops[op];
+                    if (src.kind != ThemeOp::Arc || (src.fullSweep && percent < 100)) continue;
+                    const Raster::ArcGeometry arc(center, center, src.radius * scale, src.width * 0.5f * scale, -90.0f,
+                        360.0f * (percent / 100.0f));
+                    coverage.assign(static_cast<size_t>(size) * size, 0.0f);
+                    Raster::ForEachArcSpan(bounds, arc, scratch, [&](int y, int x0, int count, const float* row) {
+                        std::copy(row, row + count, coverage.begin() + static_cast<size_t>(y) * size + x0);
+                    });
+
+                    double area = 0.0, referenceArea = 0.0;
+                    int maxDiff = 0;
+                    for (int y = 0; y < size; ++y) {
+                        for (int x = 0; x < size; ++x) {
+                            const float value = coverage[static_cast<size_t>(y) * size + x];
+                            area += value;
+                            const float dx = x + 0.5f - center, dy = y + 0.5f - center;
+                            if (std::fabs(std::sqrt(dx * dx + dy * dy) - arc.radius) > arc.halfWidth + 1.0f) continue;
+
+                            int inside = 0;
+                            for (int j = 0; j < grid; ++j) {
+                                for (int i = 0; i < grid; ++i) {
+                                    const float sx = dx + (i + 0.5f) / grid - 0.5f, sy = dy + (j + 0.5f) / grid - 0.5f;
+                                    inside += arc.DistanceFromCenter(sx, sy) <= arc.halfWidth ? 1 : 0;
+                                }
+                            }
+                            const float reference = inside / static_cast<float>(grid * grid);
+                            referenceArea += reference;
+                            maxDiff = std::max(maxDiff, static_cast<int>(std::fabs(value - reference) * 255.0f + 0.5f));
+                        }
+                    }
+                    const double areaError = std::fabs(area - referenceArea) / referenceArea;
+                    const double allowed = std::max(0.001 * referenceArea, 3.14159265 / 12.0);
+                    worstDiff = std::max(worstDiff, maxDiff);
+                    worstArea = std::max(worstArea, areaError);
+                    arcs++;
+
+                    char where[64];
+                    snprintf(where, sizeof(where), "%d %% at %.1fx", percent, scale);
+                    expect(maxDiff <= 32, std::string(where) + ": max diff " + std::to_string(maxDiff));
+                    expect(std::fabs(area - referenceArea) <= allowed,
+                        std::string(where) + ": area off by " + std::to_string(areaError * 100.0) + " %");
+                }
+            }
+        }
+
+        char line[160];
+        snprintf(line, sizeof(line), "arc coverage: %d arcs against %dx%d samples, max diff %d, area off by at most %.3f %% (%.2f px² allowed)\n",
+            arcs, grid, grid, worstDiff, worstArea * 100.0, 3.14159265 / 12.0);
+        summary += line;
+        return expect.failures;
+    }
+
+    // Kacheln auf 2, 4 und 8 Threads gegen einen Thread: bei 700 und 1400 px bitgleich für Intro, Hold und Fade;
+    // misst die Zeit pro Frame je Thread-Zahl im zweiten Durchlauf, wenn die Caches stehen
+    inline int CheckThreads(std::string& report, std::string& summary) {
+        Expect expect(report, "threads");
+        const ThemeProgram theme = Theme::BuiltIn();
+        const struct { float scale; int alpha; BYTE percent; } frames[] = {
+            { 0.6f, 120, 73 }, { 1.0f, 255, 73 }, { 1.0f, 255, 100 }, { 0.95f, 200, 19 },
+        };
+        const int threadCounts[] = { 1, 2, 4, 8 };
+
+        std::string line = "threads:";
+        for (float dpiScale : { 2.0f, 4.0f }) {
+            const int size = static_cast<int>(Config::HUD_SIZE * dpiScale);
+            std::vector<uint32_t> reference;
+            char sizeName[32];
+            snprintf(sizeName, sizeof(sizeName), " %d px", size);
+            line += sizeName;
+            for (int threads : threadCounts) {
+                SoftwareHudRasterizer rasterizer(&BitmapFontGlyphSource::Create);
+                rasterizer.SetTheme(theme);
+                rasterizer.SetThreadCount(threads);
+                MemoryRenderTarget target;
+                target.Acquire(size, size);
+
+                std::vector<uint32_t> result;
+                double elapsed = 0.0;
+                for (int pass = 0; pass < 2; ++pass) {
+                    result.clear();
+                    elapsed = 0.0;
+                    for (const auto& frame : frames) {
+                        FrameParams params;
+                        params.scale = frame.scale;
+                        params.alpha = frame.alpha;
+                        params.percent = frame.percent;
+                        params.themeArgb = 0xFF00E678u;
+                        params.dpiScale = dpiScale;
+                        RenderContext ctx;
+                        ctx.surface = target.BeginFrame();
+                        const double start = Utils::NowMs();
+                        rasterizer.Draw(ctx, params);
+                        elapsed += Utils::NowMs() - start;
+                        result.insert(result.end(), ctx.surface.pixels, ctx.surface.pixels + static_cast<size_t>(size) * size);
+                    }
+                }
+
+                const unsigned parallel = rasterizer.GetTileStats().parallelFrames;
+                if (threads == 1) {
+                    reference.swap(result);
+                    expect(parallel == 0, std::to_string(size) + " px on 1 thread drawn in tiles");
+                }
+                else {
+                    expect(result == reference, std::to_string(size) + " px on " + std::to_string(threads)
+                        + " threads differs from 1 thread");
+                    expect(parallel == 2 * sizeof(frames) / sizeof(frames[0]),
+                        std::to_string(size) + " px on " + std::to_string(threads) + " threads not drawn in tiles");
+                }
+                char timing[48];
+                snprintf(timing, sizeof(timing), "%s%d: %.2f ms", threads == 1 ? " " : ", ", threads,
+                    elapsed / (sizeof(frames) / sizeof(frames[0])));
+                line += timing;
+            }
+            line += dpiScale < 4.0f ? ";" : "";
+        }
+        summary += line + " per frame\n";
+        return expect.failures;
+    }
+
+    // Fade-Frames aus dem Hold-Snapshot gegen frisch gezeichnete: nur Alpha höchstens 16/255, mit Resampling
+    // an den Kanten höchstens 70/255; misst beide Wege pro Frame
+    inline int CheckFadeSnapshot(std::string& report, std::string& summary) {
+        Expect expect(report, "fade snapshot");
+        const ThemeProgram theme = Theme::BuiltIn();
+        SoftwareHudRasterizer rasterizer(&BitmapFontGlyphSource::Create);
+        rasterizer.SetTheme(theme);
+        MemoryRenderTarget target;
+        target.Acquire(Config::HUD_SIZE, Config::HUD_SIZE);
+        std::vector<uint32_t> composedPixels(static_cast<size_t>(Config::HUD_SIZE) * Config::HUD_SIZE);
+        Surface composed = target.GetSurface();
+        composed.pixels = composedPixels.data();
+        FrameSpans composedSpans;
+
+        FrameParams params;
+        params.scale = 1.0f;
+        params.alpha = 255;
+        params.percent = 73;
+        params.themeArgb = 0xFF00E678u;
+        // Wie HUDRenderer::ProduceFrame ohne Snapshot: Fläche leeren, zeichnen, Spans aus Kreis und Deckung
+        auto render = [&](float scale, int alpha) {
+            params.scale = scale;
+            params.alpha = alpha;
+            RenderContext ctx;
+            ctx.surface = target.BeginFrame();
+            rasterizer.Draw(ctx, params);
+            const float center = Config::HUD_SIZE / 2.0f;
+            target.Content().Circle(ctx.surface.width, ctx.surface.height, center, center, rasterizer.ContentRadius() + 1.0f);
+            target.Content().Trim(ctx.surface);
+            return ctx.surface;
+        };
+
+        FadeSnapshot snapshot;
+        const Surface hold = render(1.0f, 255);
+        snapshot.Capture(hold, target.Content(), params.percent);
+
+        int alphaOnly = 0, resampled = 0;
+        auto compare = [&](float scale, int alpha) {
+            snapshot.Compose(composed, composedSpans, scale, alpha);
+            const Surface fresh = render(scale, alpha);
+            int diff = 0;
+            for (int y = 0; y < fresh.height; ++y) {
+                for (int x = 0; x < fresh.width; ++x) diff = std::max(diff, Raster::ChannelDiff(fresh.Row(y)[x], composed.Row(y)[x]));
+            }
+            return diff;
+        };
+        composedSpans.Fill(composed.width, composed.height);
+        for (int frame = Config::FADEOUT_FRAMES - 1; frame >= 0; --frame) {
+            const Timeline::Keyframe& k = Timeline::FADE[frame];
+            alphaOnly = std::max(alphaOnly, compare(1.0f, k.alpha));
+            resampled = std::max(resampled, compare(k.scale, k.alpha));
+        }
+        expect(alphaOnly <= 16, "alpha-only fade off by " + std::to_string(alphaOnly));
+        expect(resampled <= 70, "resampled fade off by " + std::to_string(resampled));
+
+        // Ganzer Fade am Stück auf jedem Weg, wie er im Popup nacheinander läuft. Es zählt der schnellste Durchlauf,
+        // sonst kippt ein einzelner verdrängter Durchlauf den Vergleich
+        auto measure = [](auto frame) {
+            const double start = Utils::NowMs();
+            double best = 1e9;
+            do {
+                const double pass = Utils::NowMs();
+                for (int k = Config::FADEOUT_FRAMES - 1; k >= 0; --k) frame(Timeline::FADE[k]);
+                best = std::min(best, Utils::NowMs() - pass);
+            } while (Utils::NowMs() - start < 20.0);
+            return best / Config::FADEOUT_FRAMES;
+        };
+        const double renderMs = measure([&](const Timeline::Keyframe& k) { render(k.scale, k.alpha); });
+        const double alphaMs = measure([&](const Timeline::Keyframe& k) {
+            snapshot.Compose(composed, composedSpans, 1.0f, k.alpha);
+        });
+        const double resampleMs = measure([&](const Timeline::Keyframe& k) {
+            snapshot.Compose(composed, composedSpans, k.scale, k.alpha);
+        });
+        expect(alphaMs < renderMs && resampleMs < renderMs, "compose is not cheaper than render");
+
+        char line[200];
+        snprintf(line, sizeof(line), "fade snapshot: compose %.3f ms alpha-only, %.3f ms resampled, render %.3f ms per frame, "
+            "max diff %d alpha-only, %d resampled\n", alphaMs, resampleMs, renderMs, alphaOnly, resampled);
+        summary += line;
+        return expect.failures;
+    }
+
+    // LRU-Reihenfolge, Verdrängen per SetBudget, Wiederverwendung der Puffer und Treffer/Fehlzugriffe des Frame-Caches,
+    // dann dasselbe Popup kalt und warm; misst beide
+    inline int CheckFrameCache(std::string& report, std::string& summary) {
+        Expect expect(report, "frame cache");
+        const int size = 16;
+        std::vector<uint32_t> pixels(static_cast<size_t>(size) * size), out(pixels.size());
+        Surface src;
+        src.pixels = pixels.data();
+        src.width = size;
+        src.height = size;
+        src.stride = size;
+        Surface dst = src;
+        dst.pixels = out.data();
+        FrameSpans spans, content;
+        spans.Fill(size, size);
+        auto key = [](int frame) { return FrameCache::MakeKey(50, 0xFF00E678u, frame, 0, RenderQuality::Full); };
+        auto insert = [&](FrameCache& cache, int frame) {
+            std::fill(pixels.begin(), pixels.end(), 0xFF000000u | static_cast<uint32_t>(frame));
+            cache.Insert(key(frame), src, spans);
+        };
+
+        FrameCache probe;
+        insert(probe, 0);
+        const size_t entryBytes = probe.GetStats().bytes;
+
+        // Platz für drei: A, B, C, dann A benutzen; D verdrängt B
+        FrameCache cache(entryBytes * 3);
+        insert(cache, 0);
+        insert(cache, 1);
+        insert(cache, 2);
+        expect(cache.Lookup(key(0), dst, content) && out[0] == 0xFF000000u, "entry 0 not returned");
+        insert(cache, 3);
+        expect(cache.Contains(key(0)) && !cache.Contains(key(1)) && cache.Contains(key(2)) && cache.Contains(key(3)),
+            "least recently used entry not evicted first");
+        expect(!cache.Lookup(key(1), dst, content), "evicted entry still returned");
+        expect(cache.GetStats().hits == 1 && cache.GetStats().misses == 1,
+            std::to_string(cache.GetStats().hits) + " hits, " + std::to_string(cache.GetStats().misses) + " misses");
+
+        // Budget für zwei: der älteste verbliebene (2) geht
+        cache.SetBudget(entryBytes * 2);
+        expect(cache.GetStats().entries == 2 && !cache.Contains(key(2)) && cache.Contains(key(0)) && cache.Contains(key(3)),
+            "SetBudget did not evict the oldest entry");
+        expect(cache.GetStats().evictions == 2 && cache.GetStats().bytes <= entryBytes * 2,
+            std::to_string(cache.GetStats().evictions) + " evictions");
+
+        // Warm: jede weitere Einfügung übernimmt den Puffer des verdrängten Eintrags
+        const unsigned reusedBefore = cache.GetStats().reused;
+        for (int frame = 4; frame < 12; ++frame) insert(cache, frame);
+        expect(cache.GetStats().reused - reusedBefore == 8,
+            std::to_string(cache.GetStats().reused - reusedBefore) + " of 8 warm inserts reused a buffer");
+        expect(cache.Lookup(key(11), dst, content) && out[0] == (0xFF000000u | 11u), "newest entry not returned");
+
+        // Dasselbe Popup zweimal: beim zweiten Mal kommt jeder Frame aus dem Cache
+        const ThemeProgram theme = Theme::BuiltIn();
+        const AppSettings settings;
+        const auto headless = MakeHeadlessRenderer(theme);
+        HUDRenderer& renderer = *headless.renderer;
+        auto popup = [&]() {
+            HUDState state;
+            state.startAnimation(73, true, settings, theme);
+            const double start = Utils::NowMs();
+            renderer.BeginAnimation();
+            while (state.isVisible) {
+                state.Tick();
+                renderer.Render(state);
+            }
+            const double elapsed = Utils::NowMs() - start;
+            renderer.EndAnimation();
+            return elapsed;
+        };
+        const double coldMs = popup();
+        const FrameCache::Stats cold = renderer.FrameCacheStats();
+        const double warmMs = popup();
+        const FrameCache::Stats& warm = renderer.FrameCacheStats();
+        expect(warm.misses == cold.misses && warm.hits > cold.hits,
+            "warm popup missed " + std::to_string(warm.misses - cold.misses) + " frames");
+
+        char line[200];
+        snprintf(line, sizeof(line), "frame cache: popup cold %.2f ms (%u misses), warm %.2f ms (%u hits, %u misses)\n",
+            coldMs, cold.misses, warmMs, warm.hits - cold.hits, warm.misses - cold.misses);
+        summary += line;
+        return expect.failures;
+    }
+
+    // Ersparnis der Sparse-Frames gegenüber vollen Frames: Speicher pro Cache-Eintrag, Bandbreite pro Present
+    inline std::string SparseSavings(const FrameCache::Stats& cache, const HUDRenderer::PopupStats& presented) {
+        auto perFrame = [](uint64_t bytes, unsigned count) { return count ? bytes / 1024.0 / count : 0.0; };
+        auto percent = [](double part, double whole) { return whole > 0.0 ? 100.0 * part / whole : 0.0; };
+        const double cacheDense = perFrame(cache.denseBytes, cache.entries);
+        const double cacheSparse = perFrame(cache.bytes, cache.entries);
+        const double dense = perFrame(presented.denseBytes, presented.presents);
+        const double upload = perFrame(presented.uploadBytes, presented.presents);
+        const double spans = perFrame(presented.spanBytes, presented.presents);
+
+        char line[300];
+        snprintf(line, sizeof(line), "sparse frames: cache %.1f KB saved per frame (%.0f %% of %.1f KB), present %.1f KB "
+            "upload saved per frame (%.0f %% of %.1f KB), %.1f KB outside the spans (%.0f %%)\n",
+            cacheDense - cacheSparse, percent(cacheDense - cacheSparse, cacheDense), cacheDense,
+            dense - upload, percent(dense - upload, dense), dense, dense - spans, percent(dense - spans, dense));
+        return line;
+    }
+
+    // Ein Popup mit dem eingebauten Theme; sobald der Hold erreicht ist, kommen die Live-Updates der Prozentanzeige
+    struct LivePopup {
+        Image hold;                     // Hold-Frame nach dem letzten Update
+        std::vector<Image> updates;     // nach jedem Update
+        std::vector<Image> fade;
+        HUDRenderer::PopupStats stats;
+    };
+
+    inline LivePopup RunLivePopup(BYTE percent, bool charging, const std::vector<BYTE>& updates) {
+        const ThemeProgram theme = Theme::BuiltIn();
+        const AppSettings settings;
+        const auto headless = MakeHeadlessRenderer(theme);
+        CaptureOutputs& outputs = headless.outputs;
+        HUDRenderer& renderer = *headless.renderer;
+
+        LivePopup popup;
+        HUDState state;
+        state.startAnimation(percent, charging, settings, theme);
+        renderer.BeginAnimation();
+        bool holdReached = false;
+        while (state.isVisible) {
+            const int interval = state.Tick();
+            outputs.presented = false;
+            renderer.Render(state);
+            if (state.isFadingOut && outputs.presented) popup.fade.push_back(outputs.image);
+            if (interval > 0 && !holdReached) {
+                holdReached = true;
+                for (BYTE update : updates) {
+                    if (state.updatePercent(update, settings, theme)) renderer.Render(state);
+                    popup.updates.push_back(outputs.image);
+                }
+                popup.hold = outputs.image;
+            }
+        }
+        popup.stats = renderer.GetPopupStats();
+        return popup;
+    }
+
+    // Jeder Zwischenstand und der anschließende Fade aus dem geflickten Snapshot müssen bitgleich zu einem Popup
+    // sein, das gleich mit dem neuen Wert gestartet ist; Rückgabe = Anzahl verletzter Erwartungen
+    inline int CheckLiveUpdate(std::string& report, std::string& summary) {
+        struct LiveCase {
+            BYTE percent;
+            bool charging;
+            std::vector<BYTE> updates;
+        };
+        // Schritt nach oben und unten, zweite und dritte Ziffer, leerer Bogen, voller Kreis
+        const LiveCase cases[] = {
+            { 73, true, { 74, 75, 80 } }, { 98, true, { 99, 100 } }, { 42, true, { 37 } }, { 10, false, { 9, 1, 0 } },
+        };
+
+        Expect expect(report, "live percent");
+        unsigned updates = 0;
+        uint64_t pixels = 0;
+        size_t framePixels = 0;
+
+        for (const LiveCase& c : cases) {
+            const LivePopup live = RunLivePopup(c.percent, c.charging, c.updates);
+            const std::string name = std::to_string(c.percent);
+            expect(live.stats.percentUpdates == c.updates.size(), name + " not redrawn incrementally");
+            updates += live.stats.percentUpdates;
+            pixels += live.stats.pixelsRedrawn;
+            framePixels = live.hold.pixels.size();
+
+            for (size_t i = 0; i < c.updates.size(); ++i) {
+                const LivePopup fresh = RunLivePopup(c.updates[i], c.charging, std::vector<BYTE>());
+                const std::string step = name + " -> " + std::to_string(c.updates[i]);
+                expect(i < live.updates.size() && live.updates[i].pixels == fresh.hold.pixels, step + " differs");
+                if (i + 1 < c.updates.size()) continue;
+
+                bool fadeMatches = live.fade.size() == fresh.fade.size();
+                for (size_t f = 0; fadeMatches && f < fresh.fade.size(); ++f) {
+                    fadeMatches = live.fade[f].pixels == fresh.fade[f].pixels;
+                }
+                expect(fadeMatches, step + " fade differs");
+            }
+        }
+
+        char line[160];
+        snprintf(line, sizeof(line), "live percent: %u updates, %.0f px redrawn per update (%.1f %% of a frame)\n",
+            updates, updates ? static_cast<double>(pixels) / updates : 0.0,
+            (updates && framePixels) ? 100.0 * pixels / updates / framePixels : 0.0);
+        summary += line;
+        return expect.failures;
+    }
+
+    // Ein Mini-Ring, der nur diesen einen Zustand gezeigt hat
+    inline Image FreshMiniRing(BYTE percent, bool charging, const AppSettings& settings) {
+        const auto headless = MakeHeadlessMiniRing();
+        headless.renderer->Update(percent, charging, settings);
+        return headless.outputs.image;
+    }
+
+    // Mini-Ring: Ereignisse ohne neuen Wert dürfen nichts zeichnen und nichts hochladen, Wechsel in Laderichtung
+    // kommen aus dem vorgerenderten Cache und sind bitgleich zu frisch gezeichneten; Rückgabe = Anzahl Fehler
+    inline int CheckMiniRing(std::string& report, std::string& summary) {
+        Expect expect(report, "mini ring");
+        const auto headless = MakeHeadlessMiniRing();
+        CaptureOutputs& outputs = headless.outputs;
+        MiniRingWidget& widget = *headless.renderer;
+        const AppSettings settings;
+
+        // Laden von 73 % bis 76 %, dazwischen Ereignisse ohne neuen Prozentwert (Restlaufzeit u.ä.); dann Ausstecken
+        const int idleEvents = 1000;
+        struct Step {
+            BYTE percent;
+            bool charging;
+        };
+        const Step steps[] = { { 73, true }, { 74, true }, { 75, true }, { 76, true }, { 76, false }, { 75, false } };
+        unsigned idleWork = 0;
+        for (const Step& step : steps) {
+            const std::string name = std::to_string(step.percent) + (step.charging ? " charging" : " discharging");
+            outputs.presented = false;
+            widget.Update(step.percent, step.charging, settings);
+            expect(outputs.presented, name + " not presented");
+            expect(outputs.image.pixels == FreshMiniRing(step.percent, step.charging, settings).pixels, name + " differs");
+
+            const MiniRingWidget::Stats before = widget.GetStats();
+            outputs.presented = false;
+            for (int i = 0; i < idleEvents; ++i) widget.Update(step.percent, step.charging, settings);
+            const MiniRingWidget::Stats& after = widget.GetStats();
+            idleWork += (after.redraws - before.redraws) + (after.rasterizations - before.rasterizations)
+                + (after.presents - before.presents) + (outputs.presented ? 1 : 0);
+        }
+
+        const MiniRingWidget::Stats& stats = widget.GetStats();
+        const unsigned changes = sizeof(steps) / sizeof(steps[0]);
+        expect(idleWork == 0, std::to_string(idleWork) + " wakeups while unchanged");
+        expect(stats.redraws == changes && stats.presents == changes, "redraws without a change");
+        // 73 frisch, 74..76 vorgerendert, 77 auf Vorrat; ausgesteckt 76 frisch, 75 vorgerendert, 74 auf Vorrat
+        expect(stats.cacheHits == 4 && stats.rasterizations == 8, "changes not served from the prerendered cache");
+        expect(outputs.outsideSpans == 0, "pixels outside the spans");
+
+        char line[200];
+        snprintf(line, sizeof(line), "mini ring: %u events, %u redraws (%u from the prerendered cache), %u rasterizations, "
+            "%u wakeups while unchanged, %.1f KB cached\n", stats.updates, stats.redraws, stats.cacheHits,
+            stats.rasterizations, idleWork, widget.FrameCacheStats().bytes / 1024.0);
+        summary += line;
+        return expect.failures;
+    }
+
+    // Tray-Icon: gleiche Ereignisse melden keine Änderung, jeder Zustand wird höchstens einmal gerastert, der Bogen
+    // zeigt den Prozentwert in der Zustandsfarbe. Misst dabei alle Zustände bei 1x und 2x; Rückgabe = Anzahl Fehler
+    inline int CheckTrayIcon(std::string& report, std::string& summary) {
+        Expect expect(report, "tray icon");
+        const ThemeProgram theme = Theme::BuiltIn();
+        const AppSettings settings;
+        TrayIconCache icons;
+        icons.SetTheme(theme);
+
+        expect(icons.Update(73, true, settings, 1.0f), "first state not reported");
+        unsigned idleChanges = 0;
+        for (int i = 0; i < 1000; ++i) idleChanges += icons.Update(73, true, settings, 1.0f) ? 1 : 0;
+        expect(idleChanges == 0, std::to_string(idleChanges) + " changes without a new value");
+        expect(icons.Update(74, true, settings, 1.0f), "new percent not reported");
+        expect(icons.Update(74, false, settings, 1.0f), "unplugging not reported");
+
+        // Halber Bogen: rechts die Zustandsfarbe, links nur die graue Spur
+        icons.Update(50, true, settings, 1.0f);
+        const Surface half = icons.Current();
+        expect(half.width == Config::TRAY_ICON_SIZE && half.height == Config::TRAY_ICON_SIZE, "wrong size");
+        auto matches = [](uint32_t premultiplied, uint32_t rgb, int alpha) {
+            const int a = static_cast<int>(premultiplied >> 24);
+            if (std::abs(a - alpha) > 24 || a == 0) return false;
+            for (int shift = 0; shift < 24; shift += 8) {
+                const int channel = static_cast<int>((premultiplied >> shift) & 0xFF) * 255 / a;
+                if (std::abs(channel - static_cast<int>((rgb >> shift) & 0xFF)) > 24) return false;
+            }
+            return true;
+        };
+        const int mid = half.height / 2;
+        expect(matches(half.Row(mid)[half.width - 3], theme.chargeArgb & 0x00FFFFFF, 255), "arc missing");
+        expect(matches(half.Row(mid)[2], 0x808080, 153), "track missing");
+
+        // Alle Zustände zweimal: beim ersten Mal gerastert, beim zweiten nur aus dem Cache
+        TrayIconCache bench;
+        bench.SetTheme(theme);
+        auto sweep = [&] {
+            const double start = Utils::NowMs();
+            for (float scale : { 1.0f, 2.0f }) {
+                for (bool charging : { true, false }) {
+                    for (int percent = 0; percent <= 100; ++percent) {
+                        if (bench.Update(static_cast<BYTE>(percent), charging, settings, scale)) bench.Current();
+                    }
+                }
+            }
+            return Utils::NowMs() - start;
+        };
+        const double cold = sweep();
+        const unsigned drawn = bench.GetStats().rasterizations;
+        const double warm = sweep();
+        expect(drawn == 2 * 2 * 101, "not every state drawn once");
+        expect(bench.GetStats().rasterizations == drawn, "cached states drawn again");
+
+        char line[200];
+        snprintf(line, sizeof(line), "tray icon: %u icons (1x and 2x) in %.1f ms (%.0f us each), again from the cache "
+            "in %.2f ms, %.1f KB cached, %u changes for 1000 unchanged events\n", drawn, cold,
+            drawn ? cold * 1000.0 / drawn : 0.0, warm, bench.GetStats().bytes / 1024.0, idleChanges);
+        summary += line;
+        return expect.failures;
+    }
+
+    // Künstlicher Bildschirm hinter dem HUD: eine Farbe, Schachbrett (1 Pixel) oder Verlauf mit Rauschen
+    class PatternBackdrop : public IBackdropSource {
+    public:
+        enum class Pattern { Uniform, Checker, Gradient };
+
+        explicit PatternBackdrop(Pattern pattern) : pattern(pattern) {}
+
+        bool Capture(const RECT&, const Surface& dst) override {
+            for (int y = 0; y < dst.height; ++y) {
+                uint32_t* row = dst.Row(y);
+                for (int x = 0; x < dst.width; ++x) row[x] = 0xFF000000u | Pixel(x, y, dst.width, dst.height);
+            }
+            captures++;
+            return true;
+        }
+
+        unsigned captures = 0;
+
+    private:
+        uint32_t Pixel(int x, int y, int width, int height) const {
+            switch (pattern) {
+            case Pattern::Uniform: return 0x4080C0;
+            case Pattern::Checker: return ((x + y) & 1) ? 0xFFFFFF : 0;
+            default: break;
+            }
+            const uint32_t noise = static_cast<uint32_t>(x * 7919 + y * 104729) * 2654435761u >> 27;
+            const uint32_t r = static_cast<uint32_t>(x * 255 / width), g = static_cast<uint32_t>(y * 255 / height);
+            return (r << 16) | (g << 8) | std::min(noise * 8, 255u);
+        }
+
+        Pattern pattern;
+    };
+
+    // Wie CaptureOutputs, zählt aber Pixel, in denen das nur im Dirty-Rechteck aktualisierte Bild vom Frame abweicht
+    class CheckedCaptureOutputs : public CaptureOutputs {
+    public:
+        void Present(size_t index, const PresentFrame& frame) override {
+            CaptureOutputs::Present(index, frame);
+            for (int y = 0; y < frame.surface.height; ++y) {
+                const uint32_t* row = frame.surface.Row(y);
+                const uint32_t* shown = &image.pixels[static_cast<size_t>(y) * image.width];
+                for (int x = 0; x < frame.surface.width; ++x) stale += (row[x] != shown[x]) ? 1 : 0;
+            }
+        }
+
+        unsigned stale = 0;
+    };
+
+    // Halbtransparenter Kreis als HUD-Ersatz für Compose ohne Rasterizer
+    inline void SyntheticHud(int size, std::vector<uint32_t>& pixels, Surface& surface, FrameSpans& spans) {
+        pixels.assign(static_cast<size_t>(size) * size, 0);
+        surface.pixels = pixels.data();
+        surface.width = size;
+        surface.height = size;
+        surface.stride = size;
+        spans.Circle(size, size, size / 2.0f, size / 2.0f, size * 0.4f);
+        for (int y = 0; y < size; ++y) {
+            const FrameSpans::Span span = spans.Row(y);
+            for (int x = span.x0; x < span.x1; ++x) {
+                const uint32_t a = static_cast<uint32_t>(x + y) & 0xFF;
+                surface.Row(y)[x] = (a << 24) | ((a / 2) << 16) | ((a / 3) << 8) | (a / 4);
+            }
+        }
+    }
+
+    // Milchglas: einfarbiger Hintergrund bleibt (getönt) einfarbig, ein Schachbrett wird glatt, alle Kernel-Stufen
+    // bauen und mischen bitgleich, im Popup liegt nichts außerhalb der Spans und das Dirty-Rechteck reicht.
+    // Misst Build und Compose bei 1x und 2x; Rückgabe = Anzahl Fehler
+    inline int CheckBackdrop(std::string& report, std::string& summary) {
+        Expect expect(report, "backdrop");
+        std::vector<uint32_t> capturePixels;
+        auto capture = [&](PatternBackdrop::Pattern pattern, int size) {
+            capturePixels.assign(static_cast<size_t>(size) * size, 0);
+            Surface surface;
+            surface.pixels = capturePixels.data();
+            surface.width = size;
+            surface.height = size;
+            surface.stride = size;
+            PatternBackdrop(pattern).Capture(RECT(), surface);
+            return surface;
+        };
+        auto build = [&](BackdropBlur& blur, PatternBackdrop::Pattern pattern, int size, float scale) {
+            blur.Build(capture(pattern, size), scale);
+        };
+        auto range = [](const Surface& surface) {
+            int lowest = 255, highest = 0;
+            for (int y = 0; y < surface.height; ++y) {
+                for (int x = 0; x < surface.width; ++x) {
+                    const int green = static_cast<int>((surface.Row(y)[x] >> 8) & 0xFF);
+                    lowest = std::min(lowest, green);
+                    highest = std::max(highest, green);
+                }
+            }
+            return highest - lowest;
+        };
+
+        BackdropBlur uniform;
+        build(uniform, PatternBackdrop::Pattern::Uniform, Config::HUD_SIZE, 1.0f);
+        uint32_t tinted = 0;
+        const uint32_t source = 0xFF4080C0u, tint = 0xFF000000u | Config::FROST_TINT_RGB;
+        Raster::BlendRowsSpanScalar(&tinted, &source, &tint, 1, 256 - Config::FROST_TINT, Config::FROST_TINT);
+        int uniformDiff = 0;
+        const Surface frost = uniform.Frost();
+        for (int y = 0; y < frost.height; ++y) {
+            for (int x = 0; x < frost.width; ++x) uniformDiff = std::max(uniformDiff, Raster::ChannelDiff(frost.Row(y)[x], tinted));
+        }
+        expect(frost.width == Config::HUD_SIZE && uniformDiff <= 1, "uniform backdrop off by " + std::to_string(uniformDiff));
+
+        BackdropBlur checker;
+        build(checker, PatternBackdrop::Pattern::Checker, Config::HUD_SIZE, 1.0f);
+        const int checkerRange = range(checker.Frost());
+        expect(checkerRange <= 16, "checkerboard not smoothed, range " + std::to_string(checkerRange));
+
+        // Jede Kernel-Stufe gegen die skalare, bei 2x mit einem halbtransparenten HUD davor
+        const Raster::SimdLevel active = Raster::Kernels().level;
+        const int size = Config::HUD_SIZE * 2;
+        std::vector<uint32_t> hudPixels;
+        Surface hud;
+        FrameSpans hudSpans;
+        SyntheticHud(size, hudPixels, hud, hudSpans);
+        std::vector<uint32_t> reference;
+        for (int k = 0; k <= static_cast<int>(Raster::DetectSimdLevel()); ++k) {
+            const Raster::SimdLevel level = Raster::SelectKernels(static_cast<Raster::SimdLevel>(k));
+            BackdropBlur blur;
+            build(blur, PatternBackdrop::Pattern::Gradient, size, 2.0f);
+            MemoryRenderTarget target;
+            target.Acquire(size, size);
+            blur.Compose(target.GetSurface(), target.Content(), hud, hudSpans, Config::FROST_RADIUS * 2.0f * 0.9f, 200);
+            const Surface frostSurface = blur.Frost();
+            const Surface out = target.GetSurface();
+            std::vector<uint32_t> result(frostSurface.pixels, frostSurface.pixels + static_cast<size_t>(size) * size);
+            result.insert(result.end(), out.pixels, out.pixels + static_cast<size_t>(size) * size);
+            if (k == 0) {
+                reference.swap(result);
+            }
+            else {
+                expect(result == reference, std::string(Raster::SimdLevelName(level)) + " differs from scalar");
+            }
+        }
+        Raster::SelectKernels(active);
+
+        // Ein Popup mit Glas: eine Aufnahme, Mitte deckend, Ecke frei, nichts außerhalb der Spans
+        const ThemeProgram theme = Theme::BuiltIn();
+        const AppSettings settings;
+        const auto headless = MakeHeadlessRenderer<CheckedCaptureOutputs>(theme);
+        CheckedCaptureOutputs& outputs = headless.outputs;
+        HUDRenderer& renderer = *headless.renderer;
+        auto pattern = std::make_unique<PatternBackdrop>(PatternBackdrop::Pattern::Gradient);
+        PatternBackdrop& backdrop = *pattern;
+        renderer.EnableBackdrop(std::move(pattern));
+        HUDState state;
+        state.startAnimation(73, true, settings, theme);
+        renderer.BeginAnimation();
+        bool holdChecked = false;
+        while (state.isVisible) {
+            const int interval = state.Tick();
+            renderer.Render(state);
+            if (interval > 0 && !holdChecked) {
+                holdChecked = true;
+                const Image& image = outputs.image;
+                const int edge = Config::HUD_SIZE / 2 + static_cast<int>(Config::FROST_RADIUS) - 3;
+                expect(image.pixels[static_cast<size_t>(Config::HUD_SIZE / 2) * image.width + Config::HUD_SIZE / 2] >> 24 == 255,
+                    "center not opaque");
+                expect(image.pixels[static_cast<size_t>(Config::HUD_SIZE / 2) * image.width + edge] >> 24 == 255,
+                    "glass missing inside the rim");
+                expect(image.pixels[0] == 0, "corner not transparent");
+            }
+        }
+        renderer.EndAnimation();
+        expect(holdChecked, "hold never reached");
+        expect(backdrop.captures == 1, std::to_string(backdrop.captures) + " captures per popup");
+        expect(outputs.outsideSpans == 0, "pixels outside the spans");
+        expect(outputs.stale == 0, std::to_string(outputs.stale) + " px missed by the dirty rectangle");
+
+        // Build einmal pro Popup, Compose pro Frame
+        double buildMs[2] = {}, composeMs[2] = {};
+        const int runs = 20;
+        for (int i = 0; i < 2; ++i) {
+            const float scale = i == 0 ? 1.0f : 2.0f;
+            const int sizeAt = static_cast<int>(Config::HUD_SIZE * scale);
+            SyntheticHud(sizeAt, hudPixels, hud, hudSpans);
+            const Surface screen = capture(PatternBackdrop::Pattern::Gradient, sizeAt);
+            BackdropBlur blur;
+            MemoryRenderTarget target;
+            target.Acquire(sizeAt, sizeAt);
+            double start = Utils::NowMs();
+            for (int r = 0; r < runs; ++r) blur.Build(screen, scale);
+            buildMs[i] = (Utils::NowMs() - start) / runs;
+            start = Utils::NowMs();
+            for (int r = 0; r < runs; ++r) {
+                blur.Compose(target.GetSurface(), target.Content(), hud, hudSpans, Config::FROST_RADIUS * scale, 255 - r);
+            }
+            composeMs[i] = (Utils::NowMs() - start) / runs;
+        }
+
+        char line[200];
+        snprintf(line, sizeof(line), "backdrop: build %.2f ms at 350 px, %.2f ms at 700 px; "
+            "compose %.2f / %.2f ms per frame; checkerboard range %d\n", buildMs[0], buildMs[1], composeMs[0],
+            composeMs[1], checkerRange);
+        summary += line;
+        return expect.failures;
+    }
+
+    // Ring-Protokoll aus hudframes.h auf einem kleinen Puffer statt der benannten Abbildung;
+    // Rückgabe = Anzahl verletzter Erwartungen
+    inline int CheckFrameExport(std::string& report, std::string&) {
+        Expect expect(report, "frame export");
+
+        const uint32_t width = 24, height = 16, sourceStride = width * 2;
+        const uint32_t slotBytes = width * height * 4;
+        std::vector<uint64_t> memory(static_cast<size_t>((HudFrames::MappingBytes(slotBytes) + 7) / 8));
+        HudFrames::Writer writer(memory.data());
+        HudFrames::Reader reader(memory.data());
+        expect(!reader.IsValid(), "leerer Speicher ist kein Ring");
+        writer.Init(slotBytes);
+        expect(reader.IsValid() && reader.Latest() == 0, "frisch angelegt: noch kein Frame");
+
+        // Quelle mit doppelter Zeilenlänge, damit zeilenweise kopiert wird
+        std::vector<uint32_t> source(static_cast<size_t>(sourceStride) * height);
+        HudFrames::FrameView first, view;
+        for (uint32_t frame = 1; frame <= 5; ++frame) {
+            for (size_t k = 0; k < source.size(); ++k) source[k] = frame * 0x01010101u + static_cast<uint32_t>(k);
+            writer.Publish(source.data(), width, height, sourceStride * 4, 200, 1.5f, frame * 1000);
+            if (frame == 1) expect(reader.Acquire(1, first), "erster Frame lesbar");
+        }
+
+        expect(reader.Latest() == 5 && reader.Acquire(5, view) && view.width == width && view.height == height
+            && view.alpha == 200 && view.scale == 1.5f && view.timestampUs == 5000, "neuester Frame mit Kopf");
+        bool pixelsMatch = view.pixels != nullptr;
+        for (uint32_t y = 0; y < height && pixelsMatch; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                pixelsMatch = pixelsMatch && view.Row(y)[x] == 5 * 0x01010101u + y * sourceStride + x;
+            }
+        }
+        expect(pixelsMatch && reader.StillValid(view), "Pixel ohne Kopie aus dem Slot");
+        expect(!reader.StillValid(first) && !reader.Acquire(2, view), "überschriebene Slots werden erkannt");
+        expect(reader.Acquire(3, view) && reader.Acquire(4, view), "die letzten SLOT_COUNT Frames bleiben lesbar");
+        expect(!writer.Publish(source.data(), width, height + 1, sourceStride * 4, 255, 1.0f, 0) && reader.Latest() == 5,
+            "zu großer Frame wird abgelehnt");
+
+        // Nur Spans kopieren: Slots, die vorher volle oder breitere Zeilen trugen, müssen außerhalb wieder 0 sein
+        std::vector<HudFrames::RowSpan> rows(height);
+        bool sparseMatch = true;
+        for (uint32_t frame = 6; frame <= 20; ++frame) {
+            const uint32_t frameHeight = frame % 7 == 0 ? height / 2 : height;
+            for (uint32_t y = 0; y < frameHeight; ++y) {
+                const uint32_t x0 = (frame * 3 + y) % (width / 2), x1 = x0 + (frame * 5 + y * 3) % (width - x0 + 1);
+                rows[y] = (frame + y) % 5 == 0 ? HudFrames::RowSpan{ 0, 0 } : HudFrames::RowSpan{ x0, x1 };
+                for (uint32_t x = 0; x < width; ++x) {
+                    source[y * sourceStride + x] = x >= rows[y].x0 && x < rows[y].x1 ? frame * 0x01010101u + y * width + x : 0;
+                }
+            }
+            sparseMatch = sparseMatch && writer.Publish(source.data(), width, frameHeight, sourceStride * 4,
+                255, 1.0f, frame * 1000, rows.data());
+            sparseMatch = sparseMatch && reader.Acquire(frame, view) && view.height == frameHeight;
+            for (uint32_t y = 0; y < frameHeight && sparseMatch; ++y) {
+                sparseMatch = std::memcmp(view.Row(y), &source[y * sourceStride], width * 4) == 0;
+            }
+        }
+        expect(sparseMatch, "Span-Kopie ergibt denselben dichten Frame");
+        return expect.failures;
+    }
+
+    inline double& SimulatedMs() {
+        static double ms = 0.0;
+        return ms;
+    }
+
+    inline double SimulatedClock() { return SimulatedMs(); }
+
+    inline void SimulateFrames(FrameGovernor& governor, int count, double frameMs) {
+        for (int i = 0; i < count; ++i) {
+            governor.BeginFrame();
+            SimulatedMs() += frameMs;
+            governor.EndFrame();
+            SimulatedMs() += std::max(0.0, governor.IntervalMs() - frameMs);
+        }
+    }
+
+    // Entscheidungen des Governors mit simulierter Uhr; Rückgabe = Anzahl verletzter Erwartungen
+    inline int CheckGovernor(std::string& report, std::string&) {
+        Expect expect(report, "governor");
+
+        const int window = Config::GOVERNOR_WINDOW;
+        FrameGovernor governor(&SimulatedClock);
+        SimulateFrames(governor, 4 * window, 1.0);
+        expect(governor.Level() == 0 && governor.IntervalMs() == Config::TIMER_INTERVAL_MS, "Netzteil, schnelle Frames: volle Rate");
+
+        governor.SetPowerSource(false);
+        expect(governor.Level() == 1 && governor.Quality() == RenderQuality::Full, "Akku: halbe Rate, volle Qualität");
+        governor.SetPowerSource(true);
+
+        // Budget auf Stufe 0 ist 8 ms, auf Stufe 1 16 ms
+        SimulateFrames(governor, window, 12.0);
+        expect(governor.Level() == 1 && governor.GetStats().degrades == 1, "über Budget: eine Stufe herunter");
+        SimulateFrames(governor, 4 * window, 12.0);
+        expect(governor.Level() == 1 && governor.GetStats().recoveries == 0, "knapp unter Budget: keine Rückkehr");
+        SimulateFrames(governor, window, 2.0);
+        expect(governor.Level() == 0 && governor.GetStats().recoveries == 1, "wieder schnell: zurück zur vollen Rate");
+
+        SimulateFrames(governor, 2, 200.0);
+        expect(governor.Level() == 0, "einzelne Ausreißer: keine Entscheidung vor vollem Fenster");
+        SimulateFrames(governor, FrameGovernor::LEVELS * window, 100.0);
+        expect(governor.Level() == FrameGovernor::LEVELS - 1 && governor.Quality() == RenderQuality::Draft,
+            "dauerhaft zu langsam: unterste Stufe");
+        SimulateFrames(governor, FrameGovernor::LEVELS * window, 0.5);
+        expect(governor.Level() == 0, "schnell: schrittweise zurück");
+
+        governor.SetPowerSource(false);
+        SimulateFrames(governor, 4 * window, 0.5);
+        expect(governor.Level() == 1, "Akku bleibt trotz schneller Frames bei halber Rate");
+        expect(governor.GetStats().powerChanges == 3 && governor.GetStats().overBudget > 0, "Zähler");
+        return expect.failures;
+    }
+
+    struct PacingRun {
+        double durationMs = 0.0;
+        FrameScheduler::Stats stats;
+    };
+
+    // Ganzer Popup-Ablauf mit simulierter Uhr: der Timer feuert auf dem nächsten Raster der Auflösung nach der
+    // gewünschten Wartezeit (wie SetTimer), einmalig um stallMs verspätet und einmalig earlyMs zu früh
+    inline PacingRun SimulatePopup(double resolutionMs, double stallMs, double earlyMs) {
+        SimulatedMs() = 0.0;
+        FrameScheduler scheduler(&SimulatedClock);
+        HUDState state;
+        state.startAnimation(73, true, AppSettings(), Theme::BuiltIn());
+
+        int wait = scheduler.Start(1);
+        for (int wake = 0; wake < 10000; ++wake) {
+            SimulatedMs() = std::ceil((SimulatedMs() + wait) / resolutionMs) * resolutionMs;
+            if (wake == 5) SimulatedMs() += stallMs;
+            if (wake == 8) SimulatedMs() -= earlyMs;
+
+            const int due = scheduler.DueFrames();
+            if (due == 0) {
+                wait = scheduler.RemainingMs();
+                continue;
+            }
+            const int interval = state.Tick(due);
+            if (interval < 0) break;
+            wait = scheduler.Schedule(interval, 1);
+        }
+
+        PacingRun run;
+        run.durationMs = SimulatedMs();
+        run.stats = scheduler.GetStats();
+        return run;
+    }
+
+    // Zeitachse des ganzen HUDState-Ablaufs; Rückgabe = Anzahl verletzter Erwartungen
+    inline int CheckPacing(std::string& report, std::string&) {
+        Expect expect(report, "pacing");
+
+        // Intro, ein Hold-Timer, Fade
+        const double ideal = (Config::ANIM_FRAMES + Config::HOLD_FRAMES + 1 + Config::FADEOUT_FRAMES)
+            * static_cast<double>(Config::TIMER_INTERVAL_MS);
+
+        const PacingRun exact = SimulatePopup(1.0, 0.0, 0.0);
+        expect(exact.durationMs == ideal && exact.stats.droppedFrames == 0 && exact.stats.jitterMs == 0.0,
+            "exakter Timer: keine Abweichung");
+        expect(exact.stats.frames == Config::ANIM_FRAMES + 1 + Config::FADEOUT_FRAMES, "exakter Timer: ein Tick pro Frame");
+
+        // Standardauflösung 15,6 ms: "jetzt + 16 ms" würde jedes Mal 31,25 ms, gezielt auf die Frist bleibt es im Takt
+        const double resolution = 15.625;
+        const PacingRun coarse = SimulatePopup(resolution, 0.0, 0.0);
+        expect(coarse.durationMs <= ideal + resolution, "grobe Auflösung: Dauer bleibt");
+        expect(coarse.stats.maxLatenessMs < resolution + 1.0 && coarse.stats.frames + coarse.stats.droppedFrames == exact.stats.frames,
+            "grobe Auflösung: jede Frist innerhalb einer Timer-Periode");
+
+        const PacingRun stalled = SimulatePopup(1.0, 200.0, 0.0);
+        expect(stalled.durationMs == ideal, "200 ms Hänger im Intro: Dauer bleibt");
+        expect(stalled.stats.droppedFrames == 12 && stalled.stats.longestGapMs >= 200.0, "200 ms Hänger: 12 Frames übersprungen");
+
+        const PacingRun early = SimulatePopup(1.0, 0.0, 5.0);
+        expect(early.stats.earlyWakeups == 1 && early.durationMs == ideal, "zu früh geweckt: ohne Fortschritt nachgestellt");
+        return expect.failures;
+    }
+
+    // Prüfungen neben den Goldens, nur beim Verify; jede hängt Fehler an den Bericht und Messwerte an die Zusammenfassung
+    struct Check {
+        const char* name;
+        int (*run)(std::string& report, std::string& summary);
+    };
+
+    const Check CHECKS[] = {
+        { "glow cache", &CheckGlowCache },
+        { "fade snapshot", &CheckFadeSnapshot },
+        { "frame cache", &CheckFrameCache },
+        { "arc coverage", &CheckArcCoverage },
+        { "threads", &CheckThreads },
+        { "linear light", &CheckLinearLight },
+        { "governor", &CheckGovernor },
+        { "pacing", &CheckPacing },
+        { "kernels", &CheckKernels },
+        { "frame export", &CheckFrameExport },
+        { "live percent", &CheckLiveUpdate },
+        { "mini ring", &CheckMiniRing },
+        { "tray icon", &CheckTrayIcon },
+        { "backdrop", &CheckBackdrop },
+    };
+
+    // Rückgabe ist der Exit-Code: 0 = alle Frames gleich bzw. innerhalb der Toleranz (beim Record: alles geschrieben)
+    inline int Run(const Path& dir, bool record) {
+        const double started = Utils::NowMs();
+        MakeDirectory(dir);
+        const Path hashPath = Join(dir, "frames.txt");
+        const std::unordered_map<std::string, FrameHash> goldens = record
+            ? std::unordered_map<std::string, FrameHash>() : ReadHashes(hashPath);
+        std::string hashes = "# Snapshot-Goldens: name breite höhe fnv1a64; neu schreiben mit hudsnapshot record\n";
+
+        const ThemeProgram theme = Theme::BuiltIn();
+        auto counting = std::make_unique<CountingRasterizer>(
+            std::make_unique<SoftwareHudRasterizer>(&BitmapFontGlyphSource::Create));
+        const CountingRasterizer& rasterizer = *counting;
+        const auto headless = MakeHeadlessRenderer(theme, std::move(counting));
+        CaptureOutputs& outputs = headless.outputs;
+        HUDRenderer& renderer = *headless.renderer;
+
+        unsigned frames = 0, keyFrames = 0, passed = 0, failed = 0, missing = 0, errors = 0;
+        int maxDiff = 0;
+        std::string report;
+        HUDRenderer::PopupStats presented;
+        Expect targets(report, "render target");
+
+        for (const Case& c : CASES) {
+            AppSettings settings;
+            settings.useCustomChargeColor = c.customColor;
+            settings.useCustomDischargeColor = c.customColor;
+            settings.chargeColor = Color(255, 60, 140, 255);
+            settings.dischargeColor = Color(255, 200, 60, 220);
+
+            // Gleiche Tick-Folge wie WM_TIMER, nur ohne zu warten
+            HUDState state;
+            state.startAnimation(c.percent, c.charging, settings, theme);
+            const RenderTargetStats targetBefore = renderer.TargetStats();
+            const unsigned drawsBefore = rasterizer.draws, emptyBefore = outputs.emptyFrames;
+            renderer.BeginAnimation();
+            int ordinal = 0;
+            const int step = FrameGovernor::StepFor(c.level);
+            while (state.isVisible) {
+                state.Tick(step);
+                outputs.presented = false;
+                renderer.Render(state, FrameGovernor::QualityFor(c.level));
+                if (!outputs.presented) continue;
+
+                const int frameOrdinal = ordinal++;
+                const std::string name = FrameName(c, frameOrdinal);
+                const Image& image = outputs.image;
+                const uint64_t hash = Hash(image);
+                const bool keyFrame = IsKeyFrame(name);
+                frames++;
+                keyFrames += keyFrame ? 1 : 0;
+                if (frameOrdinal == c.flipAfter) {
+                    state.changeState(c.percent, !c.charging, settings, theme);
+                }
+
+                if (record) {
+                    char line[128];
+                    snprintf(line, sizeof(line), "%s %d %d %016llx\n", name.c_str(), image.width, image.height,
+                        static_cast<unsigned long long>(hash));
+                    hashes += line;
+                    if (keyFrame && !WriteBmp(Join(dir, name + ".bmp"), image)) errors++;
+                    continue;
+                }
+
+                // Alle übrigen Frames müssen bitgleich sein; ein anderer Compiler rundet evtl. anders, dann neu
+                // aufnehmen, sobald die Schlüsselbilder innerhalb der Toleranz liegen
+                const auto recorded = goldens.find(name);
+                const bool sameHash = recorded != goldens.end() && recorded->second.hash == hash
+                    && recorded->second.width == image.width && recorded->second.height == image.height;
+                if (!keyFrame) {
+                    if (sameHash) {
+                        passed++;
+                        continue;
+                    }
+                    WriteBmp(Join(dir, name + ".actual.bmp"), image);
+                    if (recorded == goldens.end()) {
+                        missing++;
+                        report += "MISSING " + name + "\n";
+                    }
+                    else {
+                        failed++;
+                        report += "FAIL " + name + ": hash differs\n";
+                    }
+                    continue;
+                }
+
+                Image golden;
+                if (!ReadBmp(Join(dir, name + ".bmp"), golden) || golden.width != image.width || golden.height != image.height) {
+                    missing++;
+                    WriteBmp(Join(dir, name + ".actual.bmp"), image);
+                    report += "MISSING " + name + "\n";
+                    continue;
+                }
+
+                int frameMaxDiff = 0;
+                const int failing = Raster::DiffSpan(golden.pixels.data(), image.pixels.data(),
+                    static_cast<int>(image.pixels.size()), Config::SNAPSHOT_TOLERANCE, frameMaxDiff);
+                maxDiff = std::max(maxDiff, frameMaxDiff);
+                if (failing == 0) {
+                    passed++;
+                    continue;
+                }
+
+                failed++;
+                WriteBmp(Join(dir, name + ".actual.bmp"), image);
+                WriteBmp(Join(dir, name + ".diff.bmp"), DiffImage(golden, image));
+                report += "FAIL " + name + ": " + std::to_string(failing) + " px, max diff "
+                    + std::to_string(frameMaxDiff) + "\n";
+            }
+            const HUDRenderer::PopupStats& popup = renderer.GetPopupStats();
+            presented.presents += popup.presents;
+            presented.denseBytes += popup.denseBytes;
+            presented.uploadBytes += popup.uploadBytes;
+            presented.spanBytes += popup.spanBytes;
+            renderer.EndAnimation();
+
+            // Eine Fläche pro Popup statt pro Frame; geleert wird nur vor einem vollen Draw oder einem leeren Frame
+            const RenderTargetStats targetAfter = renderer.TargetStats();
+            const std::string popupName = FrameName(c, 0);
+            targets(targetAfter.surfaceAllocations - targetBefore.surfaceAllocations == 1,
+                popupName + ": " + std::to_string(targetAfter.surfaceAllocations - targetBefore.surfaceAllocations)
+                + " surface allocations");
+            targets(targetAfter.surfaceReleases - targetBefore.surfaceReleases == 1,
+                popupName + ": " + std::to_string(targetAfter.surfaceReleases - targetBefore.surfaceReleases)
+                + " surface releases");
+            const unsigned begun = targetAfter.framesBegun - targetBefore.framesBegun;
+            const unsigned expected = (rasterizer.draws - drawsBefore) + (outputs.emptyFrames - emptyBefore);
+            targets(begun == expected, popupName + ": " + std::to_string(begun) + " frames begun, expected "
+                + std::to_string(expected));
+        }
+
+        if (outputs.outsideSpans > 0) {
+            report += "FAIL sparse frames: " + std::to_string(outputs.outsideSpans) + " px outside the spans\n";
+        }
+        std::string results = ", sparse frames " + std::string(outputs.outsideSpans == 0 ? "ok" : "FAILED");
+        if (!record) results += ", render target " + std::string(targets.failures == 0 ? "ok" : "FAILED");
+        std::string measurements = record ? std::string() : SparseSavings(renderer.FrameCacheStats(), presented);
+        bool checksOk = outputs.outsideSpans == 0 && (record || targets.failures == 0);
+        for (const Check& check : CHECKS) {
+            if (record) break;
+            const bool passedCheck = check.run(report, measurements) == 0;
+            results += std::string(", ") + check.name + (passedCheck ? " ok" : " FAILED");
+            checksOk = checksOk && passedCheck;
+        }
+
+        if (record) {
+            std::ofstream file(hashPath.c_str(), std::ios::binary);
+            file.write(hashes.data(), hashes.size());
+            if (!file.good()) errors++;
+        }
+
+        const std::string elapsed = std::to_string(static_cast<long long>(Utils::NowMs() - started)) + " ms\n";
+        std::string summary = record
+            ? "snapshot record: " + std::to_string(frames) + " frames (" + std::to_string(keyFrames) + " key frames), "
+                + std::to_string(errors) + " write errors, " + elapsed
+            : "snapshot verify: " + std::to_string(frames) + " frames (" + std::to_string(keyFrames) + " key frames), "
+                + std::to_string(passed) + " passed, "
+                + std::to_string(failed) + " failed, " + std::to_string(missing) + " missing, tolerance "
+                + std::to_string(Config::SNAPSHOT_TOLERANCE) + ", max diff " + std::to_string(maxDiff) + ", simd "
+                + Raster::SimdLevelName(Raster::Kernels().level) + results + ", " + elapsed;
+        summary += measurements;
+        summary += report;
+
+        std::ofstream file(Join(dir, "summary.txt").c_str(), std::ios::binary);
+        if (file.is_open()) file.write(summary.data(), summary.size());
+
+        const bool ok = record ? errors == 0 : failed == 0 && missing == 0 && checksOk;
+        return ok ? 0 : 1;
+    }
+}